@@ -0,0 +1,204 @@
+#!/usr/bin/env python3
+"""
+Host client for the SimpleFOC Commander binary protocol.
+
+Frame format (see Commander.h):
+    0x00 COBS(seq | operations | CRC16-CCITT little endian) 0x00
+    operation: (opcode | motor index), command letter, sub-command letter [, float32 value]
+
+Registers are addressed with the commands.h letters, ex. "VP" (velocity PID P gain),
+"LU" (voltage limit), "R" (phase resistance), "M5" (shaft velocity), "M0" (target),
+or with the numeric register id of RegisterMap.h, ex. 0x30 (velocity PID P gain).
+
+Usage:
+    commander_binary_client.py PORT [--baud 1000000] [--motor 0] [--read VP LU ...]
+                                    [--write VP=0.2 0x40=12 ...] [--benchmark [SECONDS]]
+
+Requires pyserial.
+"""
+import argparse
+import struct
+import time
+
+OP_READ = 0x10
+OP_WRITE = 0x20
+OP_READ_ID = 0x30
+OP_WRITE_ID = 0x40
+STATUS_OK = 0x00
+
+
+def crc16(data):
+    """CRC16-CCITT, polynomial 0x1021, initial value 0xFFFF"""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_encode(data):
+    out = bytearray()
+    block = bytearray()
+    for byte in data:
+        if byte == 0:
+            out.append(len(block) + 1)
+            out += block
+            block = bytearray()
+        else:
+            block.append(byte)
+            if len(block) == 254:
+                out.append(0xFF)
+                out += block
+                block = bytearray()
+    out.append(len(block) + 1)
+    out += block
+    return bytes(out)
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            raise ValueError("invalid COBS frame")
+        out += data[i + 1:i + code]
+        i += code
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def register_address(name):
+    """'VP' -> (b'V', b'P'), 'R' -> (b'R', 0)"""
+    cmd = ord(name[0])
+    sub = ord(name[1]) if len(name) > 1 else 0
+    return cmd, sub
+
+
+def register_arg(arg):
+    """command line register - numeric id ('0x30', '48') or letters ('VP')"""
+    return int(arg, 0) if arg[0].isdigit() else arg
+
+
+class CommanderClient:
+    """Batched register access over the Commander binary protocol"""
+
+    def __init__(self, port, baud=1000000, timeout=0.5):
+        import serial
+        self.serial = serial.Serial(port, baud, timeout=timeout)
+        self.seq = 0
+
+    def close(self):
+        self.serial.close()
+
+    def transaction(self, operations):
+        """
+        Execute a list of operations in one frame.
+        operation: ('r', motor, 'VP') or ('w', motor, 'VP', value)
+                   the register can also be the numeric id, ex. ('r', motor, 0x30)
+        returns a list with the read value, True for a successful write or None on error
+        """
+        self.seq = (self.seq + 1) & 0xFF
+        payload = bytearray([self.seq])
+        for op in operations:
+            if isinstance(op[2], int):
+                address = bytes([op[2]])
+                opcode = OP_READ_ID if op[0] == 'r' else OP_WRITE_ID
+            else:
+                address = bytes(register_address(op[2]))
+                opcode = OP_READ if op[0] == 'r' else OP_WRITE
+            payload += bytes([opcode | op[1]]) + address
+            if op[0] == 'w':
+                payload += struct.pack('<f', op[3])
+        payload += struct.pack('<H', crc16(payload))
+        self.serial.write(b'\x00' + cobs_encode(payload) + b'\x00')
+        return self._parse_reply(operations, self._read_frame())
+
+    def read(self, motor, *names):
+        return self.transaction([('r', motor, n) for n in names])
+
+    def write(self, motor, **values):
+        return self.transaction([('w', motor, n, v) for n, v in values.items()])
+
+    def _read_frame(self):
+        # skip any text output until the frame start
+        while True:
+            byte = self.serial.read(1)
+            if not byte:
+                raise TimeoutError("no reply")
+            if byte == b'\x00':
+                break
+        frame = bytearray()
+        while True:
+            byte = self.serial.read(1)
+            if not byte:
+                raise TimeoutError("incomplete reply")
+            if byte == b'\x00':
+                if frame:
+                    return cobs_decode(bytes(frame))
+                continue
+            frame += byte
+
+    def _parse_reply(self, operations, reply):
+        if len(reply) < 3 or crc16(reply[:-2]) != struct.unpack('<H', reply[-2:])[0]:
+            raise IOError("reply checksum error")
+        if reply[0] != self.seq:
+            raise IOError("reply sequence mismatch")
+        results = []
+        i = 1
+        for op in operations:
+            if i >= len(reply) - 2:
+                results.append(None)
+                continue
+            ok = reply[i] == STATUS_OK
+            i += 1
+            if op[0] == 'r' and ok:
+                results.append(struct.unpack('<f', reply[i:i + 4])[0])
+                i += 4
+            else:
+                results.append(True if ok else None)
+        return results
+
+
+def benchmark(client, motor, seconds):
+    """Measure the register read throughput with batched and single reads"""
+    names = ['QP', 'QI', 'DP', 'DI', 'VP', 'VI', 'VF', 'AP', 'LU', 'LC', 'LV', 'M5']
+    for batch in (1, len(names)):
+        count = 0
+        start = time.perf_counter()
+        while time.perf_counter() - start < seconds:
+            client.read(motor, *names[:batch])
+            count += batch
+        elapsed = time.perf_counter() - start
+        print("batch %2d: %8.1f reads/s, %6.1f frames/s" % (batch, count / elapsed, count / batch / elapsed))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="SimpleFOC Commander binary protocol client")
+    parser.add_argument('port')
+    parser.add_argument('--baud', type=int, default=1000000)
+    parser.add_argument('--motor', type=int, default=0)
+    parser.add_argument('--read', nargs='*', default=[])
+    parser.add_argument('--write', nargs='*', default=[])
+    parser.add_argument('--benchmark', nargs='?', type=float, const=5.0)
+    args = parser.parse_args()
+
+    client = CommanderClient(args.port, args.baud)
+    time.sleep(0.1)
+    client.serial.reset_input_buffer()
+    if args.write:
+        ops = [('w', args.motor, register_arg(kv.split('=')[0]), float(kv.split('=')[1])) for kv in args.write]
+        print(dict(zip(args.write, client.transaction(ops))))
+    if args.read:
+        ops = [('r', args.motor, register_arg(name)) for name in args.read]
+        print(dict(zip(args.read, client.transaction(ops))))
+    if args.benchmark:
+        benchmark(client, args.motor, args.benchmark)
+    client.close()
+
+
+if __name__ == '__main__':
+    main()
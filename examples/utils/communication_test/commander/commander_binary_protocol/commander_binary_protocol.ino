@@ -0,0 +1,77 @@
+/**
+ * Binary commander protocol example
+ * 
+ * The motor is added to the binary protocol of the commander with addMotor() and can be
+ * controlled with the host client commander_binary_client.py (in the same folder):
+ *   python3 commander_binary_client.py /dev/ttyUSB0 --read VP VI LU M5
+ *   python3 commander_binary_client.py /dev/ttyUSB0 --write VP=0.2 M0=10
+ *   python3 commander_binary_client.py /dev/ttyUSB0 --benchmark
+ * 
+ * The string commands (ex. M10, MVP, ?) are still available on the same port.
+ */
+#include <SimpleFOC.h>
+
+// BLDC motor & driver instance
+BLDCMotor motor = BLDCMotor(11);
+BLDCDriver3PWM driver = BLDCDriver3PWM(9, 5, 6, 8);
+
+// encoder instance
+Encoder encoder = Encoder(2, 3, 500);
+// channel A and B callbacks
+void doA() { encoder.handleA(); }
+void doB() { encoder.handleB(); }
+
+// commander communication instance
+Commander command = Commander(Serial);
+void doMotor(char* cmd) { command.motor(&motor, cmd); }
+
+void setup() {
+
+  // initialize encoder sensor hardware
+  encoder.init();
+  encoder.enableInterrupts(doA, doB);
+  // link the motor to the sensor
+  motor.linkSensor(&encoder);
+
+  // driver config
+  // power supply voltage [V]
+  driver.voltage_power_supply = 12;
+  driver.init();
+  // link driver
+  motor.linkDriver(&driver);
+
+  // set control loop type to be used
+  motor.controller = MotionControlType::velocity;
+
+  // use monitoring with serial for motor init
+  // monitoring port
+  Serial.begin(1000000);
+  // comment out if not needed
+  motor.useMonitoring(Serial);
+
+  // initialise motor
+  motor.init();
+  // align encoder and start FOC
+  motor.initFOC();
+
+  // string protocol - motor on the command M
+  command.add('M', doMotor, "motor");
+  // binary protocol - motor index 0
+  command.addMotor(&motor);
+  // no text output that could be mixed with the binary replies
+  command.verbose = VerboseMode::machine_readable;
+
+  _delay(1000);
+}
+
+
+void loop() {
+  // iterative setting FOC phase voltage
+  motor.loopFOC();
+
+  // iterative function setting the outter loop target
+  motor.move();
+
+  // user communication - string and binary
+  command.run();
+}
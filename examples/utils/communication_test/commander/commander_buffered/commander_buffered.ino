@@ -0,0 +1,77 @@
+/**
+ * Commander with the non-blocking buffered serial
+ *
+ * The serial input is moved to a receive ring and the replies are written to a transmit ring
+ * drained only as fast as the UART accepts them, so the time the communication takes
+ * from the loopFOC() calls is bounded (BufferedStream::max_bytes and Commander::max_bytes_per_run).
+ * The receive ring can also be filled directly from the UART ISR/DMA callback with buffered.receive().
+*/
+#include <SimpleFOC.h>
+
+// BLDC motor & driver instance
+BLDCMotor motor = BLDCMotor(11);
+BLDCDriver3PWM driver = BLDCDriver3PWM(9, 5, 6, 8);
+
+// encoder instance
+Encoder encoder = Encoder(2, 3, 500);
+// channel A and B callbacks
+void doA() { encoder.handleA(); }
+void doB() { encoder.handleB(); }
+
+// non-blocking serial
+BufferedStream buffered = BufferedStream(Serial);
+// commander communication instance
+Commander command = Commander(buffered);
+void doMotor(char* cmd) { command.motor(&motor, cmd); }
+
+void setup() {
+
+  // use monitoring with serial 
+  Serial.begin(115200);
+  // enable more verbose output for debugging
+  // comment out if not needed
+  SimpleFOCDebug::enable(&Serial);
+
+  // initialize encoder sensor hardware
+  encoder.init();
+  encoder.enableInterrupts(doA, doB);
+  // link the motor to the sensor
+  motor.linkSensor(&encoder);
+
+  // driver config
+  // power supply voltage [V]
+  driver.voltage_power_supply = 12;
+  driver.init();
+  // link driver
+  motor.linkDriver(&driver);
+
+  // set control loop type to be used
+  motor.controller = MotionControlType::velocity;
+
+  // initialize motor
+  motor.init();
+  // align encoder and start FOC
+  motor.initFOC();
+
+  // move at most 16 bytes in each direction per loop
+  buffered.max_bytes = 16;
+  // add the motor to the commander interface
+  command.add('M', doMotor, "motor");
+
+  _delay(1000);
+  Serial.println(F("Commander listening"));
+  Serial.println(F(" - Send ? to see the node list..."));
+}
+
+void loop() {
+  // iterative setting FOC phase voltage
+  motor.loopFOC();
+
+  // iterative function setting the outer loop target
+  motor.move();
+
+  // move the received bytes and the pending replies
+  buffered.update();
+  // parse at most one command
+  command.run();
+}
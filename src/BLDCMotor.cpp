@@ -1,31 +1,40 @@
 #include "BLDCMotor.h"
 #include "./communication/SimpleFOCDebug.h"
+#include "./common/motor_identification.h"
+
+// 梯形换相的扇区表
+// mult - 3相的占空比乘数 1=正，-1=负，0=高阻抗（中心电压）
+// enable - 相状态掩码，位 0-2 对应相 A-C 启用
+struct TrapezoidSector_s {
+  float mult[3];
+  uint8_t enable;
+};
 
 // 见 https://www.youtube.com/watch?v=InzXA7mWBWE 第5张幻灯片
-// 每个为60度，3相的值为1=正，-1=负，0=高阻抗
-int trap_120_map[6][3] = {
-    {_HIGH_IMPEDANCE, 1, -1},
-    {-1, 1, _HIGH_IMPEDANCE},
-    {-1, _HIGH_IMPEDANCE, 1},
-    {_HIGH_IMPEDANCE, -1, 1},
-    {1, -1, _HIGH_IMPEDANCE},
-    {1, _HIGH_IMPEDANCE, -1}};
+// 每个为60度
+static const TrapezoidSector_s trap_120_table[6] = {
+    {{_HIGH_IMPEDANCE, 1, -1}, 0b110},
+    {{-1, 1, _HIGH_IMPEDANCE}, 0b011},
+    {{-1, _HIGH_IMPEDANCE, 1}, 0b101},
+    {{_HIGH_IMPEDANCE, -1, 1}, 0b110},
+    {{1, -1, _HIGH_IMPEDANCE}, 0b011},
+    {{1, _HIGH_IMPEDANCE, -1}, 0b101}};
 
 // 见 https://www.youtube.com/watch?v=InzXA7mWBWE 第8张幻灯片
-// 每个为30度，3相的值为1=正，-1=负，0=高阻抗
-int trap_150_map[12][3] = {
-    {_HIGH_IMPEDANCE, 1, -1},
-    {-1, 1, -1},
-    {-1, 1, _HIGH_IMPEDANCE},
-    {-1, 1, 1},
-    {-1, _HIGH_IMPEDANCE, 1},
-    {-1, -1, 1},
-    {_HIGH_IMPEDANCE, -1, 1},
-    {1, -1, 1},
-    {1, -1, _HIGH_IMPEDANCE},
-    {1, -1, -1},
-    {1, _HIGH_IMPEDANCE, -1},
-    {1, 1, -1}};
+// 每个为30度
+static const TrapezoidSector_s trap_150_table[12] = {
+    {{_HIGH_IMPEDANCE, 1, -1}, 0b110},
+    {{-1, 1, -1}, 0b111},
+    {{-1, 1, _HIGH_IMPEDANCE}, 0b011},
+    {{-1, 1, 1}, 0b111},
+    {{-1, _HIGH_IMPEDANCE, 1}, 0b101},
+    {{-1, -1, 1}, 0b111},
+    {{_HIGH_IMPEDANCE, -1, 1}, 0b110},
+    {{1, -1, 1}, 0b111},
+    {{1, -1, _HIGH_IMPEDANCE}, 0b011},
+    {{1, -1, -1}, 0b111},
+    {{1, _HIGH_IMPEDANCE, -1}, 0b101},
+    {{1, 1, -1}, 0b111}};
 
 // BLDCMotor( int pp , float R)
 // - pp            - 极对数
@@ -65,7 +74,7 @@ int BLDCMotor::init()
   if (!driver || !driver->initialized)
   {
     motor_status = FOCMotorStatus::motor_init_failed;
-    SIMPLEFOC_DEBUG("MOT: 初始化失败，驱动器未初始化");
+    SIMPLEFOC_ERROR("MOT: 初始化失败，驱动器未初始化");
     return 0;
   }
   motor_status = FOCMotorStatus::motor_initializing;
@@ -122,6 +131,9 @@ void BLDCMotor::disable()
   driver->setPwm(0, 0, 0);
   // 禁用驱动器
   driver->disable();
+  // 驱动器改变了相状态 - 梯形换相需要重新设置
+  trap_enable = 0xFF;
+  trap_hall = false;
   // 更新电机状态
   enabled = 0;
 }
@@ -131,6 +143,7 @@ void BLDCMotor::enable()
 {
   // 启用驱动器
   driver->enable();
+  trap_enable = 0xFF;
   // 设置PWM为零
   driver->setPwm(0, 0, 0);
   // 启用电流传感
@@ -155,6 +168,10 @@ int BLDCMotor::initFOC()
 
   motor_status = FOCMotorStatus::motor_calibrating;
 
+  // 弱磁控制器的电机模型和 MTPA 表
+  if (field_weakening)
+    field_weakening->init(phase_resistance, phase_inductance, KV_rating, pole_pairs, current_limit);
+
   // 如果需要，进行电机对齐
   // 对于编码器，必须进行对齐！
   // 传感器和电机对齐 - 可以通过设置 motor.sensor_direction 和 motor.zero_electric_angle 跳过
@@ -175,7 +192,7 @@ int BLDCMotor::initFOC()
         if (!current_sense->initialized)
         {
           motor_status = FOCMotorStatus::motor_calib_failed;
-          SIMPLEFOC_DEBUG("MOT: 初始化 FOC 错误，电流传感未初始化");
+          SIMPLEFOC_ERROR("MOT: 初始化 FOC 错误，电流传感未初始化");
           exit_flag = 0;
         }
         else
@@ -185,17 +202,17 @@ int BLDCMotor::initFOC()
       }
       else
       {
-        SIMPLEFOC_DEBUG("MOT: 没有电流传感器。");
+        SIMPLEFOC_WARN("MOT: 没有电流传感器。");
       }
     }
   }
   else
   {
-    SIMPLEFOC_DEBUG("MOT: 没有传感器。");
+    SIMPLEFOC_WARN("MOT: 没有传感器。");
     if ((controller == MotionControlType::angle_openloop || controller == MotionControlType::velocity_openloop))
     {
       exit_flag = 1;
-      SIMPLEFOC_DEBUG("MOT: 仅开环控制！");
+      SIMPLEFOC_WARN("MOT: 仅开环控制！");
     }
     else
     {
@@ -203,14 +220,19 @@ int BLDCMotor::initFOC()
     }
   }
 
-  if (exit_flag)
+  if (exit_flag && current_sense && current_sense->aligning())
+  {
+    // 电流传感器对齐仍在运行 - loopFOC() 完成后设置电机状态
+    SIMPLEFOC_DEBUG("MOT: 电流传感器对齐中。");
+  }
+  else if (exit_flag)
   {
     SIMPLEFOC_DEBUG("MOT: 准备就绪。");
     motor_status = FOCMotorStatus::motor_ready;
   }
   else
   {
-    SIMPLEFOC_DEBUG("MOT: 初始化 FOC 失败。");
+    SIMPLEFOC_ERROR("MOT: 初始化 FOC 失败。");
     motor_status = FOCMotorStatus::motor_calib_failed;
     disable();
   }
@@ -225,12 +247,21 @@ int BLDCMotor::alignCurrentSense()
 
   SIMPLEFOC_DEBUG("MOT: 对齐电流传感器。");
 
+  // 非阻塞对齐 - 由 loopFOC() 推进，完成后更新电机状态
+  if (current_sense->align_nonblocking)
+  {
+    if (current_sense->alignStart(voltage_sensor_align, modulation_centered))
+      return 1;
+    SIMPLEFOC_ERROR("MOT: 对齐错误！");
+    return 0;
+  }
+
   // 对齐电流传感器和驱动器
   exit_flag = current_sense->driverAlign(voltage_sensor_align, modulation_centered);
   if (!exit_flag)
   {
     // 电流传感器错误 - 相位未测量或连接不良
-    SIMPLEFOC_DEBUG("MOT: 对齐错误！");
+    SIMPLEFOC_ERROR("MOT: 对齐错误！");
     exit_flag = 0;
   }
   else
@@ -295,7 +326,7 @@ int BLDCMotor::alignSensor()
     if (moved < MIN_ANGLE_DETECT_MOVEMENT)
     {
       // 如果移动的角度小于设定的最小检测角度
-      SIMPLEFOC_DEBUG("MOT: 未能注意到移动"); // 输出调试信息，表示未能检测到移动
+      SIMPLEFOC_ERROR("MOT: 未能注意到移动"); // 输出调试信息，表示未能检测到移动
       return 0;                               // 返回0，表示校准失败
     }
     else if (mid_angle < end_angle)
@@ -315,7 +346,7 @@ int BLDCMotor::alignSensor()
     pp_check_result = !(fabs(moved * pole_pairs - _2PI) > 0.5f); // 0.5f 是一个任意值，可以更低或更高！
     if (pp_check_result == false)
     {
-      SIMPLEFOC_DEBUG("MOT: PP 检查: 失败 - 估计的极对数: ", _2PI / moved);
+      SIMPLEFOC_WARN("MOT: PP 检查: 失败 - 估计的极对数: ", _2PI / moved);
     }
     else
     {
@@ -386,7 +417,7 @@ int BLDCMotor::absoluteZeroSearch()
   {
     if (sensor->needsSearch())
     {
-      SIMPLEFOC_DEBUG("MOT: 错误: 未找到！");
+      SIMPLEFOC_ERROR("MOT: 错误: 未找到！");
     }
     else
     {
@@ -405,6 +436,22 @@ void BLDCMotor::loopFOC()
   if (sensor)
     sensor->update();
 
+  // 母线电压 - 更新驱动器的电源电压（开环模式也需要）
+  if (bus_voltage)
+    bus_voltage->update();
+
+  // 非阻塞电流传感器对齐 - 对齐期间接管相电压
+  if (updateCurrentSenseAlign())
+    return;
+
+  // 参数辨识 - 辨识期间接管相电压
+  if (identification && identification->running())
+  {
+    if (enabled)
+      identification->update();
+    return;
+  }
+
   // 如果是开环则不做任何操作
   if (controller == MotionControlType::angle_openloop || controller == MotionControlType::velocity_openloop)
     return;
@@ -417,6 +464,7 @@ void BLDCMotor::loopFOC()
   // 此函数不会有数值问题，因为它使用 Sensor::getMechanicalAngle()
   // 该值范围在 0-2PI 之间
   electrical_angle = electricalAngle();
+  float current_target; // 电流设定点（包括频率响应扰动）
   switch (torque_controller)
   {
   case TorqueControlType::voltage:
@@ -429,11 +477,13 @@ void BLDCMotor::loopFOC()
     current.q = current_sense->getDCCurrent(electrical_angle);
     // 对值进行滤波
     current.q = LPF_current_q(current.q);
+    // 频率响应测量 - 电流设定点扰动
+    current_target = frequency_response ? frequency_response->inject(FrequencyResponseTarget::fr_current, current_sp, current.q) : current_sp;
     // 计算相电压
-    voltage.q = PID_current_q(current_sp - current.q);
+    voltage.q = PID_current_q(current_target - current.q);
     // d 电压 - 滞后补偿
     if (_isset(phase_inductance))
-      voltage.d = _constrain(-current_sp * shaft_velocity * pole_pairs * phase_inductance, -voltage_limit, voltage_limit);
+      voltage.d = _constrain(-current_target * shaft_velocity * pole_pairs * phase_inductance, -voltage_limit, voltage_limit);
     else
       voltage.d = 0;
     break;
@@ -445,20 +495,34 @@ void BLDCMotor::loopFOC()
     // 滤波值
     current.q = LPF_current_q(current.q);
     current.d = LPF_current_d(current.d);
+    // 频率响应测量 - 电流设定点扰动
+    current_target = frequency_response ? frequency_response->inject(FrequencyResponseTarget::fr_current, current_sp, current.q) : current_sp;
     // 计算相电压
-    voltage.q = PID_current_q(current_sp - current.q);
-    voltage.d = PID_current_d(-current.d);
+    if (field_weakening)
+    {
+      // 弱磁/MTPA - 负 d 电流设定点
+      DQCurrent_s current_ref = (*field_weakening)(current_target, shaft_velocity, voltage, voltage_limit, current_limit);
+      voltage.q = PID_current_q(current_ref.q - current.q);
+      voltage.d = PID_current_d(current_ref.d - current.d);
+    }
+    else
+    {
+      voltage.q = PID_current_q(current_target - current.q);
+      voltage.d = PID_current_d(-current.d);
+    }
     // d 电压 - 滞后补偿 - TODO 验证
     // if(_isset(phase_inductance)) voltage.d = _constrain( voltage.d - current_sp*shaft_velocity*pole_pairs*phase_inductance, -voltage_limit, voltage_limit);
     break;
   default:
     // 未选择扭矩控制
-    SIMPLEFOC_DEBUG("MOT: 未选择扭矩控制！");
+    SIMPLEFOC_ERROR("MOT: 未选择扭矩控制！");
     break;
   }
 
+  // 频率响应测量 - q 电压扰动
+  float Uq = frequency_response ? frequency_response->inject(FrequencyResponseTarget::fr_voltage, voltage.q, current.q) : voltage.q;
   // 设置相电压 - FOC 核心功能 :)
-  setPhaseVoltage(voltage.q, voltage.d, electrical_angle);
+  setPhaseVoltage(Uq, voltage.d, electrical_angle);
 }
 
 // 迭代函数运行 FOC 算法的外部循环
@@ -473,11 +537,23 @@ void BLDCMotor::move(float new_target)
   if (_isset(new_target))
     target = new_target;
 
+  // 参数辨识期间不执行控制
+  if (identification && identification->running())
+    return;
+
+  // 电流传感器对齐期间不执行控制
+  if (current_sense && current_sense->aligning())
+    return;
+
   // 下采样（可选）
   if (motion_cnt++ < motion_downsample)
     return;
   motion_cnt = 0;
 
+  // 如果链接了设定点队列，则以 move() 速率插值目标值
+  if (setpoint_queue)
+    target = (*setpoint_queue)(_micros(), target);
+
   // 轴角/速度需要先调用 update()
   // 获取轴角
   // TODO 传感器精度：shaft_angle 实际上存储了完整的位置，包括完整的旋转，作为浮点数
@@ -530,6 +606,9 @@ void BLDCMotor::move(float new_target)
     // 计算速度设定点
     shaft_velocity_sp = feed_forward_velocity + P_angle(shaft_angle_sp - shaft_angle);
     shaft_velocity_sp = _constrain(shaft_velocity_sp, -velocity_limit, velocity_limit);
+    // 频率响应测量 - 速度设定点扰动
+    if (frequency_response)
+      shaft_velocity_sp = frequency_response->inject(FrequencyResponseTarget::fr_velocity, shaft_velocity_sp, shaft_velocity);
     // 计算扭矩命令 - 传感器精度：此计算是可以的，但基于之前计算的错误值
     current_sp = PID_velocity(shaft_velocity_sp - shaft_velocity); // 如果是电压扭矩控制
     // 如果通过电压控制扭矩
@@ -550,6 +629,9 @@ void BLDCMotor::move(float new_target)
   case MotionControlType::velocity:
     // 速度设定点 - 传感器精度：此计算在数值上是精确的。
     shaft_velocity_sp = target;
+    // 频率响应测量 - 速度设定点扰动
+    if (frequency_response)
+      shaft_velocity_sp = frequency_response->inject(FrequencyResponseTarget::fr_velocity, shaft_velocity_sp, shaft_velocity);
     // 计算扭矩命令
     current_sp = PID_velocity(shaft_velocity_sp - shaft_velocity); // 如果是电流/foc_current 扭矩控制
     // 如果通过电压控制扭矩
@@ -594,83 +676,35 @@ void BLDCMotor::setPhaseVoltage(float Uq, float Ud, float angle_el)
 {
 
   float center;
-  int sector;
   float _ca, _sa;
 
   switch (foc_modulation)
   {
   case FOCModulationType::Trapezoid_120:
-    // 参见 https://www.youtube.com/watch?v=InzXA7mWBWE 第 5 幻灯片
-    // 确定扇区
-    sector = 6 * (_normalizeAngle(angle_el + _PI_6) / _2PI); // 添加 PI/6 以与其他模式对齐
+  case FOCModulationType::Trapezoid_150:
+    // 参见 https://www.youtube.com/watch?v=InzXA7mWBWE 第 5 和第 8 幻灯片
     // 电压居中
     // modulation_centered == true > driver.voltage_limit/2
     // modulation_centered == false > 或可适应的居中，当 Uq=0 时所有相位拉到 0
-    center = modulation_centered ? (driver->voltage_limit) / 2 : Uq;
-
-    if (trap_120_map[sector][0] == _HIGH_IMPEDANCE)
-    {
-      Ua = center;
-      Ub = trap_120_map[sector][1] * Uq + center;
-      Uc = trap_120_map[sector][2] * Uq + center;
-      driver->setPhaseState(PhaseState::PHASE_OFF, PhaseState::PHASE_ON, PhaseState::PHASE_ON); // 尽可能禁用相位
-    }
-    else if (trap_120_map[sector][1] == _HIGH_IMPEDANCE)
-    {
-      Ua = trap_120_map[sector][0] * Uq + center;
-      Ub = center;
-      Uc = trap_120_map[sector][2] * Uq + center;
-      driver->setPhaseState(PhaseState::PHASE_ON, PhaseState::PHASE_OFF, PhaseState::PHASE_ON); // 尽可能禁用相位
-    }
-    else
-    {
-      Ua = trap_120_map[sector][0] * Uq + center;
-      Ub = trap_120_map[sector][1] * Uq + center;
-      Uc = center;
-      driver->setPhaseState(PhaseState::PHASE_ON, PhaseState::PHASE_ON, PhaseState::PHASE_OFF); // 尽可能禁用相位
-    }
-    break;
-
-  case FOCModulationType::Trapezoid_150:
-    // 参见 https://www.youtube.com/watch?v=InzXA7mWBWE 第 8 幻灯片
-    // 确定扇区
-    sector = 12 * (_normalizeAngle(angle_el + _PI_6) / _2PI); // 添加 PI/6 以与其他模式对齐
-    // 电压居中
-    center = modulation_centered ? (driver->voltage_limit) / 2 : Uq;
-
-    if (trap_150_map[sector][0] == _HIGH_IMPEDANCE)
-    {
-      Ua = center;
-      Ub = trap_150_map[sector][1] * Uq + center;
-      Uc = trap_150_map[sector][2] * Uq + center;
-      driver->setPhaseState(PhaseState::PHASE_OFF, PhaseState::PHASE_ON, PhaseState::PHASE_ON); // 尽可能禁用相位
+    trap_center = modulation_centered ? (driver->voltage_limit) / 2 : Uq;
+    trap_voltage = Uq;
+    // 霍尔中断换相时扇区由中断决定（开环时除外）
+    if (trap_hall && motor_status == FOCMotorStatus::motor_ready && controller != MotionControlType::angle_openloop && controller != MotionControlType::velocity_openloop) {
+      // 霍尔中断也写入相状态和 PWM - 写入期间屏蔽中断，两者不会交错
+      _IRQ_SAVE(irq_state);
+      trapezoidApply(trap_sector);
+      _IRQ_RESTORE(irq_state);
+    } else {
+      trap_sector = trapezoidSector(angle_el);
+      trapezoidApply(trap_sector);
     }
-    else if (trap_150_map[sector][1] == _HIGH_IMPEDANCE)
-    {
-      Ua = trap_150_map[sector][0] * Uq + center;
-      Ub = center;
-      Uc = trap_150_map[sector][2] * Uq + center;
-      driver->setPhaseState(PhaseState::PHASE_ON, PhaseState::PHASE_OFF, PhaseState::PHASE_ON); // 尽可能禁用相位
-    }
-    else if (trap_150_map[sector][2] == _HIGH_IMPEDANCE)
-    {
-      Ua = trap_150_map[sector][0] * Uq + center;
-      Ub = trap_150_map[sector][1] * Uq + center;
-      Uc = center;
-      driver->setPhaseState(PhaseState::PHASE_ON, PhaseState::PHASE_ON, PhaseState::PHASE_OFF); // 尽可能禁用相位
-    }
-    else
-    {
-      Ua = trap_150_map[sector][0] * Uq + center;
-      Ub = trap_150_map[sector][1] * Uq + center;
-      Uc = trap_150_map[sector][2] * Uq + center;
-      driver->setPhaseState(PhaseState::PHASE_ON, PhaseState::PHASE_ON, PhaseState::PHASE_ON); // 启用所有相位
-    }
-    break;
+    return;
 
   case FOCModulationType::SinePWM:
   case FOCModulationType::SpaceVectorPWM:
     // 正弦 PWM 调制
+    // 高频注入 - d 轴叠加电压
+    Ud += injection_voltage_d;
     // 逆帕克 + 克拉克变换
     _sincos(angle_el, &_sa, &_ca);
 
@@ -683,6 +717,23 @@ void BLDCMotor::setPhaseVoltage(float Uq, float Ud, float angle_el)
     Ub = -0.5f * Ualpha + _SQRT3_2 * Ubeta;
     Uc = -0.5f * Ualpha - _SQRT3_2 * Ubeta;
 
+    // 死区补偿 - 死区期间相电压由电流方向决定，按相电流的符号加上损失的电压
+    if (dead_time_compensation > 0)
+    {
+      // 相电流 - 逆帕克 + 克拉克变换
+      float Ialpha = _ca * current.d - _sa * current.q;
+      float Ibeta = _sa * current.d + _ca * current.q;
+      float Ia = Ialpha;
+      float Ib = -0.5f * Ialpha + _SQRT3_2 * Ibeta;
+      float Ic = -0.5f * Ialpha - _SQRT3_2 * Ibeta;
+      float Udt = dead_time_compensation * driver->voltage_power_supply;
+      // 过零附近线性过渡，避免符号抖动
+      float k = dead_time_current_band > 0 ? Udt / dead_time_current_band : Udt * 1e6f;
+      Ua += _constrain(k * Ia, -Udt, Udt);
+      Ub += _constrain(k * Ib, -Udt, Udt);
+      Uc += _constrain(k * Ic, -Udt, Udt);
+    }
+
     center = driver->voltage_limit / 2;
     if (foc_modulation == FOCModulationType::SpaceVectorPWM)
     {
@@ -714,6 +765,77 @@ void BLDCMotor::setPhaseVoltage(float Uq, float Ud, float angle_el)
   driver->setPwm(Ua, Ub, Uc);
 }
 
+// 电角度所在的梯形换相扇区
+int8_t BLDCMotor::trapezoidSector(float angle_el)
+{
+  // 添加 PI/6 以与其他模式对齐，乘以常数代替除法
+  if (foc_modulation == FOCModulationType::Trapezoid_120)
+  {
+    int8_t sector = _normalizeAngle(angle_el + _PI_6) * (6.0f / _2PI);
+    return sector < 6 ? sector : 5; // 浮点舍入时 2PI 附近可能得到 6
+  }
+  int8_t sector = _normalizeAngle(angle_el + _PI_6) * (12.0f / _2PI);
+  return sector < 12 ? sector : 11;
+}
+
+// 设置梯形换相扇区的电压
+// 相状态只在启用掩码改变时写入（扇区切换时），而不是每个循环
+void BLDCMotor::trapezoidApply(int8_t sector)
+{
+  const TrapezoidSector_s *t;
+  if (foc_modulation == FOCModulationType::Trapezoid_120)
+    t = &trap_120_table[sector < 6 ? sector : 5];
+  else
+    t = &trap_150_table[sector];
+
+  float Uq = trap_voltage;
+  float center = trap_center;
+  Ua = t->mult[0] * Uq + center;
+  Ub = t->mult[1] * Uq + center;
+  Uc = t->mult[2] * Uq + center;
+
+  if (t->enable != trap_enable)
+  {
+    trap_enable = t->enable;
+    // 尽可能禁用相位
+    driver->setPhaseState(t->enable & 0b001 ? PhaseState::PHASE_ON : PhaseState::PHASE_OFF,
+                          t->enable & 0b010 ? PhaseState::PHASE_ON : PhaseState::PHASE_OFF,
+                          t->enable & 0b100 ? PhaseState::PHASE_ON : PhaseState::PHASE_OFF);
+  }
+  driver->setPwm(Ua, Ub, Uc);
+}
+
+// 梯形换相到电角度所在的扇区 - 可以在中断中调用
+void BLDCMotor::commutate(float angle_el)
+{
+  if (foc_modulation != FOCModulationType::Trapezoid_120 && foc_modulation != FOCModulationType::Trapezoid_150)
+    return;
+  trap_sector = trapezoidSector(angle_el);
+  trapezoidApply(trap_sector);
+}
+
+// 霍尔传感器扇区中断的换相
+void BLDCMotor::commutateHall(int hall_sector)
+{
+  // 仅在闭环运行时 - 对齐和开环期间的 setPhaseVoltage() 不受影响
+  if (!enabled || motor_status != FOCMotorStatus::motor_ready || hall_sector < 0 || hall_sector > 5)
+    return;
+  if (controller == MotionControlType::angle_openloop || controller == MotionControlType::velocity_openloop)
+    return;
+  // 霍尔边沿每 60 度一次 - Trapezoid_150 的 30 度全相导通扇区需要按角度切换，留给 setPhaseVoltage()
+  if (foc_modulation != FOCModulationType::Trapezoid_120)
+    return;
+  // 与 electricalAngle() 相同 - 霍尔传感器每个扇区为 60 度电角度
+  float angle_el = (float)(sensor_direction * hall_sector) * _PI_3 - zero_electric_angle;
+  if (!trap_hall) {
+    // 第一个边沿 - setPhaseVoltage() 可能正在无保护地写入，只设置扇区，由下一次 setPhaseVoltage() 写入
+    trap_sector = trapezoidSector(angle_el);
+    trap_hall = true;
+    return;
+  }
+  commutate(angle_el);
+}
+
 // 生成开环运动以达到目标速度的函数（迭代）
 // - target_velocity - 弧度/秒
 // 使用 voltage_limit 变量
@@ -70,6 +70,17 @@ class BLDCMotor: public FOCMotor
     void move(float target = NOT_SET) override;
     
     float Ua, Ub, Uc; //!< 当前相位电压Ua, Ub和Uc设置到电机
+
+    /**
+     * 死区补偿 - 死区占PWM周期的比例 [0,1]，0 禁用
+     * - 6PWM 驱动: driver.dead_zone；硬件死区: 死区时间[s] * PWM频率[Hz]
+     * - 每相加上 dead_time_compensation * voltage_power_supply 乘以相电流的符号
+     * - 相电流方向来自 current (foc_current/dc_current 测量值，或电压模式下由 phase_resistance 估算)
+     * - 只用于 SinePWM 和 SpaceVectorPWM 调制
+     */
+    float dead_time_compensation = 0;
+    float dead_time_current_band = 0.1f; //!< 过零平滑过渡的电流范围 [A] - |i| 小于此值时补偿线性减小
+    float injection_voltage_d = 0; //!< 叠加到 Ud 上的注入电压 [V] - 由 HFISensor 每个循环设置 (只用于 SinePWM 和 SpaceVectorPWM)
     
   /**
     * 使用FOC在最佳角度设置Uq到电机的方法
@@ -81,6 +92,28 @@ class BLDCMotor: public FOCMotor
     */
     void setPhaseVoltage(float Uq, float Ud, float angle_el) override;
 
+    /**
+     * 梯形换相（Trapezoid_120/150）到电角度所在的扇区 - 在中断中调用
+     * 使用上一次 setPhaseVoltage() 的电压 - setPhaseVoltage() 只在霍尔换相生效时屏蔽中断，
+     * 从其他中断直接调用时两者的写入可能交错，中断换相请使用 commutateHall()
+     * 
+     * @param angle_el 电角度
+     */
+    void commutate(float angle_el);
+
+    /**
+     * 霍尔传感器扇区中断的换相 - 在 HallSensor::attachSectorCallback() 的回调中调用
+     * 仅 Trapezoid_120 - 闭环运行时第一次调用之后扇区由霍尔中断决定，setPhaseVoltage() 只更新电压
+     * 并在写入时屏蔽中断（恢复调用者的中断状态），未使用霍尔换相时不屏蔽中断
+     * 
+     * 示例:
+     *   void onSector(int sector){ motor.commutateHall(sector); }
+     *   sensor.attachSectorCallback(onSector);
+     * 
+     * @param hall_sector 霍尔传感器的电扇区 [0, 5]
+     */
+    void commutateHall(int hall_sector);
+
   private:
     // FOC方法 
 
@@ -109,6 +142,17 @@ class BLDCMotor: public FOCMotor
     float angleOpenloop(float target_angle);
     // 开环变量
     long open_loop_timestamp;
+
+    // 梯形换相
+    /** 电角度所在的梯形换相扇区 */
+    int8_t trapezoidSector(float angle_el);
+    /** 设置梯形换相扇区的相状态和电压 */
+    void trapezoidApply(int8_t sector);
+    volatile int8_t trap_sector = 0; //!< 当前的梯形换相扇区
+    volatile uint8_t trap_enable = 0xFF; //!< 上一次设置的相状态掩码（位 0-2: 相 A-C 启用）- 0xFF 未知
+    volatile bool trap_hall = false; //!< 扇区由霍尔中断设置
+    volatile float trap_voltage = 0; //!< 梯形换相的电压 [V]
+    volatile float trap_center = 0; //!< 梯形换相的中心电压 [V]
 };
 
 #endif
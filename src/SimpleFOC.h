@@ -98,6 +98,11 @@ void loop() {
 
 #include "BLDCMotor.h"
 #include "StepperMotor.h"
+#include "common/motor_identification.h"
+#include "common/motor_tuning.h"
+#include "common/frequency_response.h"
+#include "common/sensor_alignment.h"
+#include "common/loop_rate_manager.h"
 #include "sensors/Encoder.h"
 #include "sensors/MagneticSensorSPI.h"
 #include "sensors/MagneticSensorI2C.h"
@@ -105,6 +110,8 @@ void loop() {
 #include "sensors/MagneticSensorPWM.h"
 #include "sensors/HallSensor.h"
 #include "sensors/GenericSensor.h"
+#include "sensors/FluxObserverSensor.h"
+#include "sensors/HFISensor.h"
 #include "drivers/BLDCDriver3PWM.h"
 #include "drivers/BLDCDriver6PWM.h"
 #include "drivers/StepperDriver4PWM.h"
@@ -112,8 +119,11 @@ void loop() {
 #include "current_sense/InlineCurrentSense.h"
 #include "current_sense/LowsideCurrentSense.h"
 #include "current_sense/GenericCurrentSense.h"
+#include "current_sense/BusVoltageSense.h"
 #include "communication/Commander.h"
 #include "communication/StepDirListener.h"
 #include "communication/SimpleFOCDebug.h"
+#include "communication/BufferedStream.h"
+#include "communication/DualCoreRuntime.h"
 
 #endif
@@ -1,5 +1,6 @@
 #include "StepperMotor.h"
 #include "./communication/SimpleFOCDebug.h"
+#include "./common/motor_identification.h"
 
 
 // StepperMotor(int pp)
@@ -36,7 +37,7 @@ void StepperMotor::linkDriver(StepperDriver* _driver) {
 int StepperMotor::init() {
   if (!driver || !driver->initialized) {
     motor_status = FOCMotorStatus::motor_init_failed;
-    SIMPLEFOC_DEBUG("MOT: Init not possible, driver not initialized");
+    SIMPLEFOC_ERROR("MOT: Init not possible, driver not initialized");
     return 0;
   }
   motor_status = FOCMotorStatus::motor_initializing;
@@ -105,6 +106,9 @@ int  StepperMotor::initFOC() {
   
   motor_status = FOCMotorStatus::motor_calibrating;
 
+  // field weakening motor model and MTPA table
+  if(field_weakening) field_weakening->init(phase_resistance, phase_inductance, KV_rating, pole_pairs, current_limit);
+
   // align motor if necessary
   // alignment necessary for encoders!
   // sensor and motor alignment - can be skipped
@@ -122,30 +126,33 @@ int  StepperMotor::initFOC() {
       if(current_sense){ 
         if (!current_sense->initialized) {
           motor_status = FOCMotorStatus::motor_calib_failed;
-          SIMPLEFOC_DEBUG("MOT: Init FOC error, current sense not initialized");
+          SIMPLEFOC_ERROR("MOT: Init FOC error, current sense not initialized");
           exit_flag = 0;
         }else{
           exit_flag *= alignCurrentSense();
         }
       }
-      else { SIMPLEFOC_DEBUG("MOT: No current sense."); }
+      else { SIMPLEFOC_WARN("MOT: No current sense."); }
     }
 
   } else {
-    SIMPLEFOC_DEBUG("MOT: No sensor.");
+    SIMPLEFOC_WARN("MOT: No sensor.");
     if ((controller == MotionControlType::angle_openloop || controller == MotionControlType::velocity_openloop)){
       exit_flag = 1;    
-      SIMPLEFOC_DEBUG("MOT: Openloop only!");
+      SIMPLEFOC_WARN("MOT: Openloop only!");
     }else{
       exit_flag = 0; // no FOC without sensor
     }
   }
 
-  if(exit_flag){
+  if(exit_flag && current_sense && current_sense->aligning()){
+    // current sense alignment still running - loopFOC() sets the motor status when done
+    SIMPLEFOC_DEBUG("MOT: Aligning current sense.");
+  }else if(exit_flag){
     SIMPLEFOC_DEBUG("MOT: Ready.");
     motor_status = FOCMotorStatus::motor_ready;
   }else{
-    SIMPLEFOC_DEBUG("MOT: Init FOC failed.");
+    SIMPLEFOC_ERROR("MOT: Init FOC failed.");
     motor_status = FOCMotorStatus::motor_calib_failed;
     disable();
   }
@@ -159,11 +166,18 @@ int StepperMotor::alignCurrentSense() {
 
   SIMPLEFOC_DEBUG("MOT: Align current sense.");
 
+  // non-blocking alignment - stepped by loopFOC(), the motor status is updated when it finishes
+  if(current_sense->align_nonblocking){
+    if(current_sense->alignStart(voltage_sensor_align, modulation_centered)) return 1;
+    SIMPLEFOC_ERROR("MOT: Align error!");
+    return 0;
+  }
+
   // align current sense and the driver
   exit_flag = current_sense->driverAlign(voltage_sensor_align, modulation_centered);
   if(!exit_flag){
     // error in current sense - phase either not measured or bad connection
-    SIMPLEFOC_DEBUG("MOT: Align error!");
+    SIMPLEFOC_ERROR("MOT: Align error!");
     exit_flag = 0;
   }else{
     // output the alignment status flag
@@ -213,7 +227,7 @@ int StepperMotor::alignSensor() {
     _delay(200);
     // determine the direction the sensor moved
     if (mid_angle == end_angle) {
-      SIMPLEFOC_DEBUG("MOT: Failed to notice movement");
+      SIMPLEFOC_ERROR("MOT: Failed to notice movement");
       return 0; // failed calibration
     } else if (mid_angle < end_angle) {
       SIMPLEFOC_DEBUG("MOT: sensor_direction==CCW");
@@ -226,7 +240,7 @@ int StepperMotor::alignSensor() {
     float moved =  fabs(mid_angle - end_angle);
     pp_check_result = !(fabs(moved*pole_pairs - _2PI) > 0.5f);  // 0.5f is arbitrary number it can be lower or higher!
     if( pp_check_result==false ) {
-      SIMPLEFOC_DEBUG("MOT: PP check: fail - estimated pp: ", _2PI/moved);
+      SIMPLEFOC_WARN("MOT: PP check: fail - estimated pp: ", _2PI/moved);
     } else {
       SIMPLEFOC_DEBUG("MOT: PP check: OK!");
     }
@@ -281,7 +295,7 @@ int StepperMotor::absoluteZeroSearch() {
   voltage_limit = limit_volt;
   // check if the zero found
   if(monitor_port){
-    if(sensor->needsSearch()) SIMPLEFOC_DEBUG("MOT: Error: Not found!");
+    if(sensor->needsSearch()) SIMPLEFOC_ERROR("MOT: Error: Not found!");
     else { SIMPLEFOC_DEBUG("MOT: Success!"); }
   }
   return !sensor->needsSearch();
@@ -296,6 +310,18 @@ void StepperMotor::loopFOC() {
   //                 of full rotations otherwise.
   if (sensor) sensor->update();
 
+  // bus voltage - updates the driver power supply voltage (needed in open-loop mode as well)
+  if (bus_voltage) bus_voltage->update();
+
+  // non-blocking current sense alignment - takes over the phase voltages while running
+  if (updateCurrentSenseAlign()) return;
+
+  // parameter identification - takes over the phase voltages while running
+  if (identification && identification->running()) {
+    if (enabled) identification->update();
+    return;
+  }
+
   // if open-loop do nothing
   if( controller==MotionControlType::angle_openloop || controller==MotionControlType::velocity_openloop ) return;
 
@@ -306,6 +332,7 @@ void StepperMotor::loopFOC() {
   // This function will not have numerical issues because it uses Sensor::getMechanicalAngle() 
   // which is in range 0-2PI
   electrical_angle = electricalAngle();
+  float current_target; // current setpoint (including the frequency response perturbation)
   switch (torque_controller) {
     case TorqueControlType::voltage:
       // no need to do anything really
@@ -316,10 +343,12 @@ void StepperMotor::loopFOC() {
       current.q = current_sense->getDCCurrent(electrical_angle);
       // filter the value values
       current.q = LPF_current_q(current.q);
+      // frequency response measurement - current setpoint perturbation
+      current_target = frequency_response ? frequency_response->inject(FrequencyResponseTarget::fr_current, current_sp, current.q) : current_sp;
       // calculate the phase voltage
-      voltage.q = PID_current_q(current_sp - current.q);
+      voltage.q = PID_current_q(current_target - current.q);
       // d voltage  - lag compensation
-      if(_isset(phase_inductance)) voltage.d = _constrain( -current_sp*shaft_velocity*pole_pairs*phase_inductance, -voltage_limit, voltage_limit);
+      if(_isset(phase_inductance)) voltage.d = _constrain( -current_target*shaft_velocity*pole_pairs*phase_inductance, -voltage_limit, voltage_limit);
       else voltage.d = 0;
       break;
     case TorqueControlType::foc_current:
@@ -329,19 +358,30 @@ void StepperMotor::loopFOC() {
       // filter values
       current.q = LPF_current_q(current.q);
       current.d = LPF_current_d(current.d);
+      // frequency response measurement - current setpoint perturbation
+      current_target = frequency_response ? frequency_response->inject(FrequencyResponseTarget::fr_current, current_sp, current.q) : current_sp;
       // calculate the phase voltages
-      voltage.q = PID_current_q(current_sp - current.q);
-      voltage.d = PID_current_d(-current.d);
+      if(field_weakening){
+        // field weakening/MTPA - negative d current setpoint
+        DQCurrent_s current_ref = (*field_weakening)(current_target, shaft_velocity, voltage, voltage_limit, current_limit);
+        voltage.q = PID_current_q(current_ref.q - current.q);
+        voltage.d = PID_current_d(current_ref.d - current.d);
+      }else{
+        voltage.q = PID_current_q(current_target - current.q);
+        voltage.d = PID_current_d(-current.d);
+      }
       // d voltage - lag compensation - TODO verify
       // if(_isset(phase_inductance)) voltage.d = _constrain( voltage.d - current_sp*shaft_velocity*pole_pairs*phase_inductance, -voltage_limit, voltage_limit);
       break;
     default:
       // no torque control selected
-      SIMPLEFOC_DEBUG("MOT: no torque control selected!");
+      SIMPLEFOC_ERROR("MOT: no torque control selected!");
       break;
   }
+  // frequency response measurement - q voltage perturbation
+  float Uq = frequency_response ? frequency_response->inject(FrequencyResponseTarget::fr_voltage, voltage.q, current.q) : voltage.q;
   // set the phase voltage - FOC heart function :)
-  setPhaseVoltage(voltage.q, voltage.d, electrical_angle);
+  setPhaseVoltage(Uq, voltage.d, electrical_angle);
 }
 
 // Iterative function running outer loop of the FOC algorithm
@@ -354,10 +394,19 @@ void StepperMotor::move(float new_target) {
   // set internal target variable
   if(_isset(new_target) ) target = new_target;
   
+  // no control while identifying the parameters
+  if (identification && identification->running()) return;
+
+  // no control while aligning the current sense
+  if (current_sense && current_sense->aligning()) return;
+
   // downsampling (optional)
   if(motion_cnt++ < motion_downsample) return;
   motion_cnt = 0;
 
+  // interpolate the target from the setpoint queue at the move() rate (if linked)
+  if(setpoint_queue) target = (*setpoint_queue)(_micros(), target);
+
   // shaft angle/velocity need the update() to be called first
   // get shaft angle
   // TODO sensor precision: the shaft_angle actually stores the complete position, including full rotations, as a float
@@ -401,6 +450,8 @@ void StepperMotor::move(float new_target) {
       // calculate velocity set point
       shaft_velocity_sp = feed_forward_velocity + P_angle( shaft_angle_sp - shaft_angle );
       shaft_velocity_sp = _constrain(shaft_velocity_sp,-velocity_limit, velocity_limit);
+      // frequency response measurement - velocity setpoint perturbation
+      if(frequency_response) shaft_velocity_sp = frequency_response->inject(FrequencyResponseTarget::fr_velocity, shaft_velocity_sp, shaft_velocity);
       // calculate the torque command - sensor precision: this calculation is ok, but based on bad value from previous calculation
       current_sp = PID_velocity(shaft_velocity_sp - shaft_velocity); // if voltage torque control
       // if torque controlled through voltage
@@ -416,6 +467,8 @@ void StepperMotor::move(float new_target) {
     case MotionControlType::velocity:
       // velocity set point - sensor precision: this calculation is numerically precise.
       shaft_velocity_sp = target;
+      // frequency response measurement - velocity setpoint perturbation
+      if(frequency_response) shaft_velocity_sp = frequency_response->inject(FrequencyResponseTarget::fr_velocity, shaft_velocity_sp, shaft_velocity);
       // calculate the torque command
       current_sp = PID_velocity(shaft_velocity_sp - shaft_velocity); // if current/foc_current torque control
       // if torque controlled through voltage control
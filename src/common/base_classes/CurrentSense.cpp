@@ -120,6 +120,10 @@ void CurrentSense::disable() {
     // 此处不执行任何操作，但可以覆盖此函数
 };
 
+void CurrentSense::updateADCSlots() {
+    // 此处不执行任何操作，读取时不使用预解析位置的实现无需覆盖
+};
+
 // 函数对齐电流传感器与电机驱动程序
 // 如果所有引脚连接良好，实际上没有必要执行这些操作！- 可以避免
 // 返回标志
@@ -130,17 +134,133 @@ void CurrentSense::disable() {
 // 4 - 成功但引脚重新配置且增益反转
 // 重要提示，此函数可以在子类中重写
 int CurrentSense::driverAlign(float voltage, bool modulation_centered) {
-        
-    int exit_flag = 1;
-    if (skip_align) return exit_flag;
+    if (!alignStart(voltage, modulation_centered)) return 0;
+    // 阻塞对齐 - 推进状态机直到完成
+    while (aligning()) alignUpdate();
+    return align_result;
+}
+
+// 启动非阻塞对齐
+// 重要提示，此函数可以在子类中重写
+int CurrentSense::alignStart(float voltage, bool modulation_centered) {
+    align_state = CurrentSenseAlignState::cs_align_idle;
+    align_result = 1;
+    if (skip_align) return 1;
 
+    align_result = 0;
     if (!initialized) return 0;
 
-    // 检查是步进电机还是BLDC 
+    // 步进电机需要相A和B的电流测量
+    if (driver_type == DriverType::Stepper && (!_isset(pinA) || !_isset(pinB))) {
+        SIMPLEFOC_DEBUG("CS: Pins A & B not specified!");
+        return 0;
+    }
+
+    align_voltage = voltage;
+    // 步进驱动器总是拉到0
+    align_zero = 0;
+    if (modulation_centered && driver_type != DriverType::Stepper) align_zero = driver->voltage_limit / 2.0f;
+    align_switched = false;
+    align_inverted = false;
+    align_phase = 0;
+    align_timestamp = _micros();
+    align_state = CurrentSenseAlignState::cs_align_ramp;
+    return 1;
+}
+
+// 推进对齐状态机
+// 每个相: 升压align_ramp_time，稳定align_settle_time，然后平均相电流
+// 直到平均值的标准误差低于align_tolerance（最少align_samples_min，最多align_samples_max个样本）
+void CurrentSense::alignUpdate() {
+    unsigned long now_us = _micros();
+    float elapsed = (now_us - align_timestamp) * 1e-6f;
+
+    switch (align_state) {
+        case CurrentSenseAlignState::cs_align_ramp:
+            if (elapsed < align_ramp_time) {
+                alignSetPhase(align_voltage * elapsed / align_ramp_time);
+                break;
+            }
+            alignSetPhase(align_voltage);
+            align_state = CurrentSenseAlignState::cs_align_settle;
+            align_timestamp = now_us;
+            break;
+        case CurrentSenseAlignState::cs_align_settle:
+            if (elapsed < align_settle_time) break;
+            for (int i = 0; i < 3; i++) align_mean[i] = align_m2[i] = 0;
+            align_samples = 0;
+            align_state = CurrentSenseAlignState::cs_align_sample;
+            break;
+        case CurrentSenseAlignState::cs_align_sample: {
+            if (align_samples && (now_us - align_sample_timestamp) * 1e-6f < align_sample_time) break;
+            align_sample_timestamp = now_us;
+            // Welford算法 - 平均值和方差不需要保存样本
+            PhaseCurrent_s c = getPhaseCurrents();
+            float x[3] = {c.a, c.b, c.c};
+            align_samples++;
+            bool settled = align_samples >= align_samples_min;
+            for (int i = 0; i < 3; i++) {
+                float d = x[i] - align_mean[i];
+                align_mean[i] += d / align_samples;
+                align_m2[i] += d * (x[i] - align_mean[i]);
+                // 平均值的标准误差 sqrt(var/N) < tolerance
+                if (align_samples > 1 && align_m2[i] / ((align_samples - 1.0f) * align_samples) > align_tolerance * align_tolerance) settled = false;
+            }
+            if (!settled && align_samples < align_samples_max) break;
+
+            alignSetPhase(0);
+            c.a = align_mean[0];
+            c.b = align_mean[1];
+            c.c = align_mean[2];
+            if (!alignCheckPhase(c)) {
+                alignFinish(0);
+            } else if (align_phase == 0) {
+                // 相A完成，对齐相B
+                align_phase = 1;
+                align_timestamp = now_us;
+                align_state = CurrentSenseAlignState::cs_align_ramp;
+            } else {
+                // 构建返回标志
+                // 如果成功且没有更改返回1
+                // 如果相位已交换返回2
+                // 如果增益已反转返回3
+                // 如果两者都返回4
+                int exit_flag = 1;
+                if (align_switched) exit_flag += 1;
+                if (align_inverted) exit_flag += 2;
+                alignFinish(exit_flag);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// 设置当前对齐的相为活动，其他相为关闭
+void CurrentSense::alignSetPhase(float voltage) {
+    if (driver_type == DriverType::Stepper) {
+        StepperDriver* stepper_driver = (StepperDriver*)driver;
+        if (align_phase == 0) stepper_driver->setPwm(voltage, 0);
+        else stepper_driver->setPwm(0, voltage);
+    } else {
+        BLDCDriver* bldc_driver = (BLDCDriver*)driver;
+        if (align_phase == 0) bldc_driver->setPwm(voltage + align_zero, align_zero, align_zero);
+        else bldc_driver->setPwm(align_zero, voltage + align_zero, align_zero);
+    }
+}
+
+// 检查当前对齐的相
+int CurrentSense::alignCheckPhase(PhaseCurrent_s c) {
     if (driver_type == DriverType::Stepper)
-        return alignStepperDriver(voltage, (StepperDriver*)driver, modulation_centered);
-    else
-        return alignBLDCDriver(voltage, (BLDCDriver*)driver, modulation_centered);
+        return align_phase == 0 ? alignStepperPhaseA(c) : alignStepperPhaseB(c);
+    return align_phase == 0 ? alignBLDCPhaseA(c) : alignBLDCPhaseB(c);
+}
+
+// 结束对齐
+void CurrentSense::alignFinish(int exit_flag) {
+    align_result = exit_flag;
+    align_state = CurrentSenseAlignState::cs_align_idle;
 }
 
 // 辅助函数读取和平均相电流
@@ -156,37 +276,29 @@ PhaseCurrent_s CurrentSense::readAverageCurrents(int N) {
     return c;
 };
 
-// 函数对齐电流传感器与电机驱动程序
-// 如果所有引脚连接良好，实际上没有必要执行这些操作！- 可以避免
-// 返回标志
-// 0 - 失败
-// 1 - 成功且没有更改
-// 2 - 成功但引脚重新配置
-// 3 - 成功但增益反转
-// 4 - 成功但引脚重新配置且增益反转
+// 函数对齐电流传感器与BLDC驱动程序 - 阻塞
+// 返回标志与driverAlign相同
 int CurrentSense::alignBLDCDriver(float voltage, BLDCDriver* bldc_driver, bool modulation_centered) {
-        
-    bool phases_switched = 0;
-    bool phases_inverted = 0;
-    
-    float zero = 0;
-    if (modulation_centered) zero = driver->voltage_limit / 2.0;
+    _UNUSED(bldc_driver); // 使用链接的驱动程序
+    return driverAlign(voltage, modulation_centered);
+}
 
-    // 设置相A为活动，相B和C为关闭
-    // 300毫秒的升压
-    for (int i = 0; i < 100; i++) {
-        bldc_driver->setPwm(voltage / 100.0 * ((float)i) + zero, zero, zero);
-        _delay(3);
-    }
-    _delay(500);
-    PhaseCurrent_s c_a = readAverageCurrents();
-    bldc_driver->setPwm(zero, zero, zero);
+// 函数对齐电流传感器与步进驱动程序 - 阻塞
+// 返回标志与driverAlign相同
+int CurrentSense::alignStepperDriver(float voltage, StepperDriver* stepper_driver, bool modulation_centered) {
+    _UNUSED(stepper_driver); // 使用链接的驱动程序
+    return driverAlign(voltage, modulation_centered);
+}
+
+// 检查BLDC驱动程序的相A
+// 相A为活动，相B和C为关闭时的平均电流
+int CurrentSense::alignBLDCPhaseA(PhaseCurrent_s c_a) {
     // 检查电流是否过低（低于100mA） 
     // TODO 根据ADC分辨率计算100mA阈值
     // 如果是，则抛出错误并返回0
     // 电流传感器未连接或电流过低，无法进行校准（应提高motor.voltage_sensor_align）
     if ((fabs(c_a.a) < 0.1f) && (fabs(c_a.b) < 0.1f) && (fabs(c_a.c) < 0.1f)) {
-        SIMPLEFOC_DEBUG("CS: Err too low current, rise voltage!");
+        SIMPLEFOC_ERROR("CS: Err too low current, rise voltage!");
         return 0; // 测量电流过低
     }
 
@@ -233,8 +345,9 @@ int CurrentSense::alignBLDCDriver(float voltage, BLDCDriver* bldc_driver, bool m
                 _swap(pinA, pinB);
                 _swap(offset_ia, offset_ib);
                 _swap(gain_a, gain_b);
-                _swap(c_a.b, c_a.b);
-                phases_switched = true; // 标记引脚已交换
+                _swap(c_a.a, c_a.b);
+                align_switched = true; // 标记引脚已交换
+                updateADCSlots(); // 重新解析 ADC 位置
                 break;
             case 2: // 相C是最大电流
                 SIMPLEFOC_DEBUG("CS: Switch A-C");
@@ -243,19 +356,20 @@ int CurrentSense::alignBLDCDriver(float voltage, BLDCDriver* bldc_driver, bool m
                 _swap(offset_ia, offset_ic);
                 _swap(gain_a, gain_c);
                 _swap(c_a.a, c_a.c);
-                phases_switched = true; // 标记引脚已交换
+                align_switched = true; // 标记引脚已交换
+                updateADCSlots(); // 重新解析 ADC 位置
                 break;
         }
         // 检查电流是否为负，如果是，则反转增益
         if (_sign(c_a.a) < 0) {
             SIMPLEFOC_DEBUG("CS: Inv A");
             gain_a *= -1;
-            phases_inverted = true; // 标记引脚已反转
+            align_inverted = true; // 标记引脚已反转
         }
     } else if (_isset(pinA) && _isset(pinB) && _isset(pinC)) {
         // 如果所有三个电流都被测量且没有一个显著更高
         // 我们有电流传感器的问题
-        SIMPLEFOC_DEBUG("CS: Err A - all currents same magnitude!");
+        SIMPLEFOC_ERROR("CS: Err A - all currents same magnitude!");
         return 0;
     } else { // 相A未测量，所以将_NC连接到相A
         if (_isset(pinA) && !_isset(pinB)) {
@@ -263,15 +377,15 @@ int CurrentSense::alignBLDCDriver(float voltage, BLDCDriver* bldc_driver, bool m
             _swap(pinA, pinB);
             _swap(offset_ia, offset_ib);
             _swap(gain_a, gain_b);
-            _swap(c_a.b, c_a.b);
-            phases_switched = true; // 标记引脚已交换
+            align_switched = true; // 标记引脚已交换
+            updateADCSlots(); // 重新解析 ADC 位置
         } else if (_isset(pinA) && !_isset(pinC)) {
             SIMPLEFOC_DEBUG("CS: Switch A-(C)NC");
             _swap(pinA, pinC);
             _swap(offset_ia, offset_ic);
             _swap(gain_a, gain_c);
-            _swap(c_a.b, c_a.c);
-            phases_switched = true; // 标记引脚已交换
+            align_switched = true; // 标记引脚已交换
+            updateADCSlots(); // 重新解析 ADC 位置
         }
     }
     // 此时，相A的电流感应可以是：
@@ -279,24 +393,19 @@ int CurrentSense::alignBLDCDriver(float voltage, BLDCDriver* bldc_driver, bool m
     // - 或者相A未测量而_NC连接到相A
     //
     // 在任何情况下，A都已完成，现在我们必须检查相B和C 
+    return 1;
+}
 
-    // 设置相B为活动，相A和C为关闭
-    // 300毫秒的升压
-    for (int i = 0; i < 100; i++) {
-        bldc_driver->setPwm(zero, voltage / 100.0 * ((float)i) + zero, zero);
-        _delay(3);
-    }
-    _delay(500);
-    PhaseCurrent_s c_b = readAverageCurrents();
-    bldc_driver->setPwm(zero, zero, zero);
-
+// 检查BLDC驱动程序的相B和C
+// 相B为活动，相A和C为关闭时的平均电流
+int CurrentSense::alignBLDCPhaseB(PhaseCurrent_s c_b) {
     // 检查相B
     // 找到c_b中的最大幅度
     // 并确保它比其他两个大约高2倍（至少1.5倍）
     float cb[3] = {fabs(c_b.a), fabs(c_b.b), fabs(c_b.c)};
-    max_i = -1; // 最大索引
-    max_c = 0; // 最大电流
-    max_c_ratio = 0; // 最大电流比
+    uint8_t max_i = -1; // 最大索引
+    float max_c = 0; // 最大电流
+    float max_c_ratio = 0; // 最大电流比
     for (int i = 0; i < 3; i++) {
         if (!cb[i]) continue; // 电流未测量
         if (cb[i] > max_c) {
@@ -314,7 +423,7 @@ int CurrentSense::alignBLDCDriver(float voltage, BLDCDriver* bldc_driver, bool m
         switch (max_i) {
             case 0: // 相A是最大电流
                 // 这是一个错误，因为相A已经对齐
-                SIMPLEFOC_DEBUG("CS: Err align B");
+                SIMPLEFOC_ERROR("CS: Err align B");
                 return 0;
             case 2: // 相C是最大电流
                 SIMPLEFOC_DEBUG("CS: Switch B-C");
@@ -322,19 +431,20 @@ int CurrentSense::alignBLDCDriver(float voltage, BLDCDriver* bldc_driver, bool m
                 _swap(offset_ib, offset_ic);
                 _swap(gain_b, gain_c);
                 _swap(c_b.b, c_b.c);
-                phases_switched = true; // 标记引脚已交换
+                align_switched = true; // 标记引脚已交换
+                updateADCSlots(); // 重新解析 ADC 位置
                 break;
         }
         // 检查电流是否为负，如果是，则反转增益
         if (_sign(c_b.b) < 0) {
             SIMPLEFOC_DEBUG("CS: Inv B");
             gain_b *= -1;
-            phases_inverted = true; // 标记引脚已反转
+            align_inverted = true; // 标记引脚已反转
         }
     } else if (_isset(pinB) && _isset(pinC)) {
         // 如果所有三个电流都被测量且没有一个显著更高
         // 我们有电流传感器的问题
-        SIMPLEFOC_DEBUG("CS: Err B - all currents same magnitude!");
+        SIMPLEFOC_ERROR("CS: Err B - all currents same magnitude!");
         return 0;
     } else { // 相B未测量，所以将_NC连接到相B
         if (_isset(pinB) && !_isset(pinC)) {
@@ -343,7 +453,8 @@ int CurrentSense::alignBLDCDriver(float voltage, BLDCDriver* bldc_driver, bool m
             _swap(offset_ib, offset_ic);
             _swap(gain_b, gain_c);
             _swap(c_b.b, c_b.c);
-            phases_switched = true; // 标记引脚已交换
+            align_switched = true; // 标记引脚已交换
+            updateADCSlots(); // 重新解析 ADC 位置
         }
     }
     // 此时，相A和B的电流感应可以是：
@@ -357,52 +468,17 @@ int CurrentSense::alignBLDCDriver(float voltage, BLDCDriver* bldc_driver, bool m
         if (_sign(c_b.c) > 0) { // 预期电流为-I/2（如果相A和B已对齐且C具有正确极性）
             SIMPLEFOC_DEBUG("CS: Inv C");
             gain_c *= -1;
-            phases_inverted = true; // 标记引脚已反转
+            align_inverted = true; // 标记引脚已反转
         }
     }
-
-    // 构建返回标志
-    // 如果相位已交换返回2
-    // 如果增益已反转返回3
-    // 如果两者都返回4
-    uint8_t exit_flag = 1;
-    if (phases_switched) exit_flag += 1;
-    if (phases_inverted) exit_flag += 2;
-    return exit_flag;
+    return 1;
 }
 
-// 函数对齐电流传感器与电机驱动程序
-// 如果所有引脚连接良好，实际上没有必要执行这些操作！- 可以避免
-// 返回标志
-// 0 - 失败
-// 1 - 成功且没有更改
-// 2 - 成功但引脚重新配置
-// 3 - 成功但增益反转
-// 4 - 成功但引脚重新配置且增益反转
-int CurrentSense::alignStepperDriver(float voltage, StepperDriver* stepper_driver, bool modulation_centered) {
-    
-    _UNUSED(modulation_centered);
-
-    bool phases_switched = 0;
-    bool phases_inverted = 0;
-
-    if (!_isset(pinA) || !_isset(pinB)) {
-        SIMPLEFOC_DEBUG("CS: Pins A & B not specified!");
-        return 0;
-    }
-
-    // 设置相A为活动，相B为关闭
-    // 升压300毫秒
-    for (int i = 0; i < 100; i++) {
-        stepper_driver->setPwm(voltage / 100.0 * ((float)i), 0);
-        _delay(3);
-    }
-    _delay(500);
-    PhaseCurrent_s c = readAverageCurrents();
-    // 禁用相
-    stepper_driver->setPwm(0, 0);        
+// 检查步进驱动程序的相A
+// 相A为活动，相B为关闭时的平均电流
+int CurrentSense::alignStepperPhaseA(PhaseCurrent_s c) {
     if (fabs(c.a) < 0.1f && fabs(c.b) < 0.1f) {
-        SIMPLEFOC_DEBUG("CS: Err too low current!");
+        SIMPLEFOC_ERROR("CS: Err too low current!");
         return 0; // 测量电流过低
     }
     // 对齐相A
@@ -413,48 +489,35 @@ int CurrentSense::alignStepperDriver(float voltage, StepperDriver* stepper_drive
         _swap(pinA, pinB);
         _swap(offset_ia, offset_ib);
         _swap(gain_a, gain_b);
-        phases_switched = true; // 标记引脚已交换
+        _swap(c.a, c.b);
+        align_switched = true; // 标记引脚已交换
+        updateADCSlots(); // 重新解析 ADC 位置
     }
     // 2) 检查测量的电流a是否为正，如果不是则反转
     if (c.a < 0) {
         SIMPLEFOC_DEBUG("CS: Inv A");
         gain_a *= -1;
-        phases_inverted = true; // 标记引脚已反转
+        align_inverted = true; // 标记引脚已反转
     }
-
     // 此时，驱动程序的相A已与ADC引脚A对齐
     // 引脚B应为相B
+    return 1;
+}
 
-    // 设置相B为活动，相A为关闭
-    // 升压300毫秒
-    for (int i = 0; i < 100; i++) {
-        stepper_driver->setPwm(0, voltage / 100.0 * ((float)i));
-        _delay(3);
-    }
-    _delay(500);
-    c = readAverageCurrents();
-    stepper_driver->setPwm(0, 0);
-
+// 检查步进驱动程序的相B
+// 相B为活动，相A为关闭时的平均电流
+int CurrentSense::alignStepperPhaseB(PhaseCurrent_s c) {
     // 相B应已对齐
     // 1) 我们只需验证它是否已被测量
     if (fabs(c.b) < 0.1f) {
-        SIMPLEFOC_DEBUG("CS: Err too low current on B!");
+        SIMPLEFOC_ERROR("CS: Err too low current on B!");
         return 0; // 测量电流过低
     }
     // 2) 检查测量的电流b是否为正，如果不是则反转
     if (c.b < 0) {
         SIMPLEFOC_DEBUG("CS: Inv B");
         gain_b *= -1;
-        phases_inverted = true; // 标记引脚已反转
+        align_inverted = true; // 标记引脚已反转
     }
-
-    // 构建返回标志
-    // 如果成功且没有更改返回1 
-    // 如果相位已交换返回2
-    // 如果增益已反转返回3
-    // 如果两者都返回4
-    uint8_t exit_flag = 1;
-    if (phases_switched) exit_flag += 1;
-    if (phases_inverted) exit_flag += 2;
-    return exit_flag;
+    return 1;
 }
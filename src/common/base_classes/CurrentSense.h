@@ -7,6 +7,16 @@
 #include "StepperDriver.h"
 #include "BLDCDriver.h"
 
+/**
+ * 电流感应对齐状态
+ */
+enum CurrentSenseAlignState : uint8_t {
+  cs_align_idle   = 0x00,     //!< 对齐未运行（结果在align_result中）
+  cs_align_ramp   = 0x01,     //!< 对齐电压升压
+  cs_align_settle = 0x02,     //!< 等待电流和转子稳定
+  cs_align_sample = 0x03,     //!< 采样并平均相电流
+};
+
 /**
  *  电流感应抽象类定义
  * 每个电流感应实现都需要扩展此接口
@@ -30,6 +40,17 @@ class CurrentSense {
 
     // 变量
     bool skip_align = false; //!< 变量，指示在initFOC()期间应验证相电流方向
+    bool align_nonblocking = false; //!< initFOC()只启动对齐，由loopFOC()推进（多个电机可以同时对齐）
+
+    // 对齐参数
+    float align_ramp_time = 0.3f; //!< 对齐电压升压时间 [s]
+    float align_settle_time = 0.5f; //!< 升压后的稳定时间 [s]
+    float align_sample_time = 1e-3f; //!< 两个平均样本之间的最小时间 [s]
+    int align_samples_min = 20; //!< 每个相的最少样本数
+    int align_samples_max = 300; //!< 每个相的最多样本数
+    float align_tolerance = 0.01f; //!< 平均电流的标准误差达到此值时停止采样 [A]
+    int align_result = 0; //!< 上一次对齐的结果标志（见driverAlign）
+    int align_samples = 0; //!< 上一个相使用的样本数
     
     FOCDriver* driver = nullptr; //!< 驱动器链接
     bool initialized = false; // 如果电流感应成功初始化为true   
@@ -69,6 +90,22 @@ class CurrentSense {
      */
     virtual int driverAlign(float align_voltage, bool modulation_centered = false);
 
+    /**
+     * 启动非阻塞对齐 - 之后需要迭代调用alignUpdate()直到aligning()返回false
+     * 结果标志与driverAlign()相同，保存在align_result中
+     * 
+     * @returns - 0 - 失败 & 1 - 对齐已启动或跳过
+     */
+    virtual int alignStart(float align_voltage, bool modulation_centered = false);
+
+    /**
+     * 推进对齐状态机的函数 - 不阻塞，可以在loopFOC()中调用
+     */
+    void alignUpdate();
+
+    /** 对齐正在运行 */
+    bool aligning() { return align_state != CurrentSenseAlignState::cs_align_idle; }
+
     /**
      *  读取相电流a、b和c的函数
      *   此函数将与FOC控制一起使用，通过函数 
@@ -142,6 +179,38 @@ class CurrentSense {
     */
     PhaseCurrent_s readAverageCurrents(int N=100);
 
+    protected:
+    // 对齐状态机变量
+    CurrentSenseAlignState align_state = CurrentSenseAlignState::cs_align_idle; //!< 对齐状态
+    uint8_t align_phase = 0; //!< 当前对齐的驱动器相（0 - A，1 - B）
+    float align_voltage = 0; //!< 对齐电压
+    float align_zero = 0; //!< 零电压（中心调制时为voltage_limit/2）
+    unsigned long align_timestamp = 0; //!< 当前状态的开始时间 [us]
+    unsigned long align_sample_timestamp = 0; //!< 上一个样本的时间 [us]
+    float align_mean[3]; //!< 相电流的平均值
+    float align_m2[3]; //!< 相电流偏差平方和（方差的Welford算法）
+    bool align_switched = false; //!< 引脚已交换
+    bool align_inverted = false; //!< 增益已反转
+
+    /** 将对齐电压设置到当前对齐的相 */
+    void alignSetPhase(float voltage);
+    /** 平均完成后检查当前对齐的相 - 返回0表示失败 */
+    int alignCheckPhase(PhaseCurrent_s c);
+    /** 结束对齐并设置结果标志 */
+    void alignFinish(int exit_flag);
+
+    /**
+     * 对齐交换相引脚后调用 - 重新解析硬件特定的各相 ADC 位置
+     * 默认实现不执行任何操作
+     */
+    virtual void updateADCSlots();
+
+    // 根据平均相电流检查并纠正各相
+    int alignBLDCPhaseA(PhaseCurrent_s c);
+    int alignBLDCPhaseB(PhaseCurrent_s c);
+    int alignStepperPhaseA(PhaseCurrent_s c);
+    int alignStepperPhaseB(PhaseCurrent_s c);
+
 };
 
 #endif
@@ -42,6 +42,13 @@ class FOCDriver{
 
         /** 获取驱动器类型 */
         virtual DriverType type() = 0;
+
+        /**
+         * 运行时更改PWM频率
+         * @param pwm_frequency - 新的频率（赫兹）
+         * @returns 设置的频率（赫兹），0 表示硬件不支持
+         */
+        virtual long setPwmFrequency(long pwm_frequency) { (void)pwm_frequency; return 0; }
 };
 
 #endif
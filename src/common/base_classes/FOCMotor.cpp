@@ -1,5 +1,6 @@
 #include "FOCMotor.h"
 #include "../../communication/SimpleFOCDebug.h"
+#include "../motor_identification.h"
 
 /**
  * 默认构造函数 - 将所有变量设置为默认值
@@ -44,6 +45,16 @@ FOCMotor::FOCMotor()
   sensor = nullptr;
   // 电流传感器
   current_sense = nullptr;
+  // 设定点队列
+  setpoint_queue = nullptr;
+  // 弱磁控制器
+  field_weakening = nullptr;
+  // 母线电压测量
+  bus_voltage = nullptr;
+  // 参数辨识
+  identification = nullptr;
+  // 频率响应测量
+  frequency_response = nullptr;
 }
 
 
@@ -61,6 +72,42 @@ void FOCMotor::linkCurrentSense(CurrentSense* _current_sense) {
   current_sense = _current_sense;
 }
 
+/**
+ * 设定点队列链接方法
+ */
+void FOCMotor::linkSetpointQueue(SetpointQueue* _setpoint_queue) {
+  setpoint_queue = _setpoint_queue;
+}
+
+/**
+ * 弱磁控制器链接方法
+ */
+void FOCMotor::linkFieldWeakening(FieldWeakening* _field_weakening) {
+  field_weakening = _field_weakening;
+}
+
+/**
+ * 母线电压测量链接方法
+ */
+void FOCMotor::linkBusVoltage(BusVoltageSense* _bus_voltage) {
+  bus_voltage = _bus_voltage;
+}
+
+/**
+ * 参数辨识链接方法
+ */
+void FOCMotor::linkIdentification(MotorIdentification* _identification) {
+  identification = _identification;
+  identification->linkMotor(this);
+}
+
+/**
+ * 频率响应测量链接方法
+ */
+void FOCMotor::linkFrequencyResponse(FrequencyResponse* _frequency_response) {
+  frequency_response = _frequency_response;
+}
+
 // 轴角计算
 float FOCMotor::shaftAngle() {
   // 如果没有链接传感器，则返回之前的值（用于开环控制）
@@ -81,6 +128,26 @@ float FOCMotor::electricalAngle() {
   return  _normalizeAngle( (float)(sensor_direction * pole_pairs) * sensor->getMechanicalAngle()  - zero_electric_angle );
 }
 
+// 推进非阻塞电流传感器对齐
+bool FOCMotor::updateCurrentSenseAlign() {
+  if (!current_sense || !current_sense->aligning()) return false;
+  // 与参数辨识相同 - 仅在启用时驱动相电压
+  if (enabled) current_sense->alignUpdate();
+  if (current_sense->aligning()) return true;
+
+  // 对齐完成
+  if (current_sense->align_result) {
+    SIMPLEFOC_DEBUG("MOT: 成功: ", current_sense->align_result);
+    SIMPLEFOC_DEBUG("MOT: 准备就绪。");
+    motor_status = FOCMotorStatus::motor_ready;
+  } else {
+    SIMPLEFOC_ERROR("MOT: 对齐错误！");
+    motor_status = FOCMotorStatus::motor_calib_failed;
+    disable();
+  }
+  return false;
+}
+
 /**
  * 监控功能
  */
@@ -10,6 +10,12 @@
 #include "../defaults.h"
 #include "../pid.h"
 #include "../lowpass_filter.h"
+#include "../setpoint_queue.h"
+#include "../field_weakening.h"
+#include "../frequency_response.h"
+#include "../../current_sense/BusVoltageSense.h"
+
+class MotorIdentification;
 
 // 监控位图
 #define _MON_TARGET 0b1000000 // 监控目标值
@@ -93,6 +99,44 @@ class FOCMotor
      */
     void linkCurrentSense(CurrentSense* current_sense);
 
+    /**
+     * 将电机与设定点队列链接的函数
+     * 
+     * @param setpoint_queue SetpointQueue 类，move() 从中插值目标值
+     */
+    void linkSetpointQueue(SetpointQueue* setpoint_queue);
+
+    /**
+     * 将电机与弱磁/MTPA 控制器链接的函数
+     * 
+     * @param field_weakening FieldWeakening 类，foc_current 扭矩控制从中获取 dq 电流设定点
+     */
+    void linkFieldWeakening(FieldWeakening* field_weakening);
+
+    /**
+     * 将电机与母线电压测量链接的函数
+     * 
+     * @param bus_voltage BusVoltageSense 类，loopFOC() 中与相电流一起采样并更新驱动器的电源电压
+     *
+     * 注意：大多数硬件（例如 STM32、ESP32）上 ADC 读取是阻塞的 analogRead()，耗时与一次 loopFOC() 相当，
+     * 因此默认每 BusVoltageSense::min_interval（1ms）最多读取一次，其余的 loopFOC() 只比较时间戳
+     */
+    void linkBusVoltage(BusVoltageSense* bus_voltage);
+
+    /**
+     * 将电机与参数辨识链接的函数
+     * 
+     * @param identification MotorIdentification 类，辨识期间由 loopFOC() 调用并接管相电压
+     */
+    void linkIdentification(MotorIdentification* identification);
+
+    /**
+     * 将电机与频率响应测量链接的函数
+     * 
+     * @param frequency_response FrequencyResponse 类，在 current_sp、shaft_velocity_sp 或 voltage.q 上注入正弦扰动
+     */
+    void linkFrequencyResponse(FrequencyResponse* frequency_response);
+
     /**
      * 初始化 FOC 算法的函数
      * 并对传感器和电机的零位置进行对齐 
@@ -144,6 +188,14 @@ class FOCMotor
      */
     float electricalAngle();
 
+    /**
+     * 推进非阻塞电流传感器对齐（CurrentSense::align_nonblocking）
+     * 对齐结束时更新 motor_status，失败时禁用电机
+     * 
+     * @returns 对齐正在运行 - loopFOC() 和 move() 不执行控制
+     */
+    bool updateCurrentSenseAlign();
+
     // 状态变量
     float target; //!< 当前目标值 - 取决于控制器
     float feed_forward_velocity = 0.0f; //!< 当前前馈速度
@@ -235,6 +287,26 @@ class FOCMotor
       * 电流感应链接
     */
     CurrentSense* current_sense; 
+    /** 
+      * 设定点队列链接（可选）
+    */
+    SetpointQueue* setpoint_queue; 
+    /** 
+      * 弱磁/MTPA 控制器链接（可选）
+    */
+    FieldWeakening* field_weakening; 
+    /** 
+      * 母线电压测量链接（可选）
+    */
+    BusVoltageSense* bus_voltage; 
+    /** 
+      * 参数辨识链接（可选）
+    */
+    MotorIdentification* identification; 
+    /** 
+      * 频率响应测量链接（可选）
+    */
+    FrequencyResponse* frequency_response; 
 
     // 监控函数
     Print* monitor_port; //!< 如果提供的串口终端变量
@@ -0,0 +1,147 @@
+#include "field_weakening.h"
+
+// 弱磁控制器构造函数
+FieldWeakening::FieldWeakening(float _voltage_margin, float _Ki)
+    : voltage_margin(_voltage_margin) // 弱磁开始的电压比例
+    , Ki(_Ki)                         // 反馈积分增益
+{
+    for(int i = 0; i < SIMPLEFOC_MTPA_TABLE_SIZE; i++){
+        mtpa_table[i] = 0;
+        mtpa_table_q[i] = 0;
+    }
+}
+
+// 根据电机参数计算模型和 MTPA 表
+void FieldWeakening::init(float phase_resistance, float phase_inductance, float KV_rating, int _pole_pairs, float current_limit){
+    pole_pairs = _pole_pairs;
+    R = _isset(phase_resistance) ? phase_resistance : 0;
+    Ld = _isset(phase_inductance) ? phase_inductance : 0;
+    Lq = saliency * Ld;
+    // 磁链 - 与 BLDCMotor 中的反电动势估计相同: V = 速度 / (KV * sqrt(3)) / (rpm->rad/s)
+    flux = (_isset(KV_rating) && KV_rating > 0) ? 1.0f / (KV_rating * _SQRT3 * _RPM_TO_RADS * pole_pairs) : 0;
+
+    // MTPA 表: id = (flux - sqrt(flux^2 + 8*(Lq-Ld)^2*is^2)) / (4*(Lq-Ld))
+    mtpa_step = current_limit / (SIMPLEFOC_MTPA_TABLE_SIZE - 1);
+    float dL = Lq - Ld;
+    for(int i = 0; i < SIMPLEFOC_MTPA_TABLE_SIZE; i++){
+        float is = i * mtpa_step;
+        if(dL > 0 && flux > 0) mtpa_table[i] = (flux - sqrtf(flux * flux + 8.0f * dL * dL * is * is)) / (4.0f * dL);
+        else mtpa_table[i] = 0;
+        // q 电流 - 电流幅值保持为 is
+        mtpa_table_q[i] = sqrtf(is * is - mtpa_table[i] * mtpa_table[i]);
+    }
+    reset();
+}
+
+// 重置反馈积分器
+void FieldWeakening::reset(){
+    current_d_fb = 0;
+    timestamp_prev = _micros();
+}
+
+// MTPA 表的线性插值
+DQCurrent_s FieldWeakening::mtpa(float is){
+    DQCurrent_s c = {0, is};
+    if(mtpa_step <= 0) return c;
+    float x = is / mtpa_step;
+    int i = (int)x;
+    if(i >= SIMPLEFOC_MTPA_TABLE_SIZE - 1){
+        i = SIMPLEFOC_MTPA_TABLE_SIZE - 2;
+        x = i + 1;
+    }
+    c.d = mtpa_table[i] + (mtpa_table[i + 1] - mtpa_table[i]) * (x - i);
+    c.q = mtpa_table_q[i] + (mtpa_table_q[i + 1] - mtpa_table_q[i]) * (x - i);
+    return c;
+}
+
+// 稳态电压模型下电压圆上的 d 电流
+//   vd = R*id - we*Lq*iq
+//   vq = R*iq + we*(Ld*id + flux)
+//   vd^2 + vq^2 = vmax^2 是 id 的二次方程
+float FieldWeakening::voltageLimitCurrent(float iq, float we, float vmax){
+    float a = we * Lq * iq;
+    float b = R * iq + we * flux;
+    float c = we * Ld;
+    float A = R * R + c * c;
+    float B = b * c - R * a;
+    float C = a * a + b * b - vmax * vmax;
+    // 不需要弱磁
+    if(C <= 0 || A <= 0) return 0;
+    float D = B * B - A * C;
+    // 电压圆不可达 - 最小电压点
+    if(D < 0) return -B / A;
+    float id = (-B + _sqrt(D)) / A;
+    return id < 0 ? id : 0;
+}
+
+// 电流圆和电压椭圆交点的 d 电流 (忽略电阻)
+//   (Ld*id + flux)^2 + (Lq*iq)^2 = (vmax/we)^2, iq^2 = imax^2 - id^2
+float FieldWeakening::circleLimitCurrent(float we, float vmax, float imax){
+    float psi = we != 0 ? vmax / fabs(we) : 0;
+    float a = Ld * Ld - Lq * Lq;
+    float b = Ld * flux;
+    float c = flux * flux + Lq * Lq * imax * imax - psi * psi;
+    float id;
+    if(fabs(a) < 1e-12f){
+        id = -c / (2.0f * b);
+    }else{
+        float D = b * b - a * c;
+        // 速度超出可达范围 - 最大弱磁
+        if(D < 0) return -imax;
+        float sq = _sqrt(D);
+        float r1 = (-b + sq) / a;
+        float r2 = (-b - sq) / a;
+        // 取 [-imax, 0] 内最接近 0 的根
+        id = (r1 <= 0 && (r1 > r2 || r2 > 0)) ? r1 : r2;
+    }
+    return _constrain(id, -imax, 0);
+}
+
+// 计算 dq 电流设定点
+DQCurrent_s FieldWeakening::operator() (float current_sp, float velocity, DQVoltage_s voltage, float voltage_limit, float current_limit){
+    // 计算自上次调用以来的时间
+    unsigned long timestamp_now = _micros();
+    float Ts = (timestamp_now - timestamp_prev) * 1e-6f;
+    // 快速修复异常情况（micros溢出）
+    if(Ts <= 0 || Ts > 0.5f) Ts = 1e-3f;
+    timestamp_prev = timestamp_now;
+
+    float id_limit = _isset(current_d_limit) ? current_d_limit : current_limit;
+    float vmax = voltage_margin * voltage_limit;
+
+    // MTPA - 电流幅值在 dq 之间分配
+    float is = _constrain(fabs(current_sp), 0, current_limit);
+    DQCurrent_s c = mtpa(is);
+    float id = c.d;
+    float id_mtpa = id;
+    float iq = current_sp < 0 ? -c.q : c.q;
+
+    // 电压模型前馈
+    float we = velocity * pole_pairs;
+    if(feed_forward && Ld > 0 && flux > 0){
+        float id_v = voltageLimitCurrent(iq, we, vmax);
+        // 超出电流圆 - 电流圆和电压椭圆的交点
+        if(id_v * id_v + iq * iq > current_limit * current_limit) id_v = circleLimitCurrent(we, vmax, current_limit);
+        if(id_v < id) id = _constrain(id_v, -id_limit, 0);
+    }
+
+    // 反馈 - 电压矢量超过 vmax 时积分负 d 电流，低于时减小（也修正前馈误差）
+    // 误差 (vmax^2 - vs^2) / (2*vmax) 在 vs = vmax 附近等于 vmax - vs，且不需要开方
+    float vs2 = voltage.d * voltage.d + voltage.q * voltage.q;
+    float error = vmax > 0 ? (vmax * vmax - vs2) / (2.0f * vmax) : 0;
+    // 抗饱和 - 总 d 电流在 [-id_limit, id_mtpa] 内
+    current_d_fb = _constrain(current_d_fb + Ki * error * Ts, -id_limit - id, id_mtpa - id);
+
+    DQCurrent_s current;
+    current.d = _constrain(id + current_d_fb, -id_limit, 0);
+    // q 电流限制在电流圆内
+    float iq_max2 = current_limit * current_limit - current.d * current.d;
+    float iq_max = 0;
+    if(iq_max2 > 0){
+        iq_max = _sqrt(iq_max2);
+        // 一次牛顿迭代 - 近似开方的误差会超出电流限制
+        iq_max = 0.5f * (iq_max + iq_max2 / iq_max);
+    }
+    current.q = _constrain(iq, -iq_max, iq_max);
+    return current;
+}
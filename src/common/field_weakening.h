@@ -0,0 +1,83 @@
+#ifndef FIELD_WEAKENING_H
+#define FIELD_WEAKENING_H
+
+#include "time_utils.h"
+#include "foc_utils.h"
+
+// MTPA 查找表点数
+#ifndef SIMPLEFOC_MTPA_TABLE_SIZE
+#define SIMPLEFOC_MTPA_TABLE_SIZE 16
+#endif
+
+/**
+ *  弱磁和最大转矩电流比 (MTPA) 控制器 - foc_current 扭矩控制的 dq 电流设定点
+ *
+ *  - MTPA: 凸极电机 (Lq > Ld) 的负 d 电流查找表，使每安培转矩最大
+ *  - 弱磁前馈: 稳态电压模型 (R, Ld, Lq, 磁链) 求解电压圆上的 d 电流
+ *  - 弱磁反馈: 当电压矢量超过 voltage_margin * voltage_limit 时，积分器注入负的 d 电流
+ *  - q 电流被限制在电流圆 sqrt(current_limit^2 - id^2) 内
+ *
+ *  模型参数来自 FOCMotor: phase_resistance, phase_inductance (Ld), KV_rating (磁链) 和 pole_pairs。
+ *  未设置的参数会禁用对应的部分 - 仅反馈积分器不需要任何电机参数。
+ */
+class FieldWeakening
+{
+public:
+    /**
+     * @param voltage_margin - 弱磁开始的电压比例 (voltage_limit 的分数)
+     * @param Ki - 反馈积分增益 [A/(V*s)]
+     */
+    FieldWeakening(float voltage_margin = 0.95f, float Ki = 200.0f);
+    ~FieldWeakening() = default; // 默认析构函数
+
+    /**
+     * 根据电机参数计算模型和 MTPA 表 - 参数改变后需要重新调用
+     * @param phase_resistance - 相电阻 [Ohm] (可以是 NOT_SET)
+     * @param phase_inductance - 相电感 Ld [H] (可以是 NOT_SET)
+     * @param KV_rating - 电机 KV [rpm/V] (可以是 NOT_SET)
+     * @param pole_pairs - 极对数
+     * @param current_limit - MTPA 表的最大电流 [A]
+     */
+    void init(float phase_resistance, float phase_inductance, float KV_rating, int pole_pairs, float current_limit);
+
+    /**
+     * 计算 dq 电流设定点
+     * @param current_sp - 转矩电流设定点 [A] (电流矢量幅值，带符号)
+     * @param velocity - 轴速度 [rad/s]
+     * @param voltage - 上一次循环的 dq 电压 [V]
+     * @param voltage_limit - 电压限制 [V]
+     * @param current_limit - 电流限制 [A]
+     */
+    DQCurrent_s operator() (float current_sp, float velocity, DQVoltage_s voltage, float voltage_limit, float current_limit);
+
+    /** 重置反馈积分器 */
+    void reset();
+
+    float voltage_margin; //!< 弱磁开始的电压比例
+    float Ki; //!< 反馈积分增益 [A/(V*s)]
+    float current_d_limit = NOT_SET; //!< 最大负 d 电流幅值 [A] - NOT_SET 则使用 current_limit
+    float saliency = 1.0f; //!< 凸极比 Lq/Ld - 大于 1 时启用 MTPA
+    bool feed_forward = true; //!< 使用电压模型前馈 (需要 phase_inductance 和 KV_rating)
+
+    float current_d_fb = 0; //!< 反馈积分器的 d 电流 [A]
+
+protected:
+    float R = 0; //!< 相电阻 [Ohm]
+    float Ld = 0; //!< d 轴电感 [H]
+    float Lq = 0; //!< q 轴电感 [H]
+    float flux = 0; //!< 永磁磁链 [V*s/rad]
+    int pole_pairs = 1; //!< 极对数
+    float mtpa_table[SIMPLEFOC_MTPA_TABLE_SIZE]; //!< MTPA d 电流 [A]，电流幅值均匀分布
+    float mtpa_table_q[SIMPLEFOC_MTPA_TABLE_SIZE]; //!< MTPA q 电流 [A]
+    float mtpa_step = 0; //!< MTPA 表的电流间隔 [A]
+    unsigned long timestamp_prev = 0; //!< 上一次执行的时间戳
+
+    /** 电流幅值 is 的 MTPA dq 电流 */
+    DQCurrent_s mtpa(float is);
+    /** 稳态电压模型下电压圆上的 d 电流 */
+    float voltageLimitCurrent(float iq, float we, float vmax);
+    /** 电流圆和电压椭圆交点的 d 电流 */
+    float circleLimitCurrent(float we, float vmax, float imax);
+};
+
+#endif // FIELD_WEAKENING_H
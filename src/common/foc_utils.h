@@ -16,6 +16,23 @@
 
 #define _swap(a, b) { auto temp = a; a = b; b = temp; }
 
+// 屏蔽中断并保存之前的中断状态 / 恢复之前的中断状态
+// 与 noInterrupts()/interrupts() 不同，在中断中或已屏蔽中断时调用也不会错误地重新启用中断
+#if defined(__AVR__)
+#define _IRQ_SAVE(state)    uint8_t state = SREG; cli()
+#define _IRQ_RESTORE(state) SREG = state
+#elif defined(__arm__)
+#define _IRQ_SAVE(state)    uint32_t state; __asm__ volatile ("mrs %0, primask\n cpsid i" : "=r" (state) :: "memory")
+#define _IRQ_RESTORE(state) __asm__ volatile ("msr primask, %0" :: "r" (state) : "memory")
+#elif defined(ESP_H) && defined(ARDUINO_ARCH_ESP32)
+#define _IRQ_SAVE(state)    UBaseType_t state = portSET_INTERRUPT_MASK_FROM_ISR()
+#define _IRQ_RESTORE(state) portCLEAR_INTERRUPT_MASK_FROM_ISR(state)
+#else
+// 通用 - 退出时重新启用中断
+#define _IRQ_SAVE(state)    noInterrupts()
+#define _IRQ_RESTORE(state) interrupts()
+#endif
+
 // 工具定义
 #define _2_SQRT3 1.15470053838f
 #define _SQRT3 1.73205080757f
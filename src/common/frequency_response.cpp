@@ -0,0 +1,87 @@
+#include "frequency_response.h"
+
+// 频率响应构造函数
+FrequencyResponse::FrequencyResponse(FrequencyResponseTarget _target, float _amplitude)
+    : target(_target)       // 注入点
+    , amplitude(_amplitude) // 扰动幅值
+{
+}
+
+// 开始扫频 - 对数分布的频率点
+void FrequencyResponse::start(float _f_start, float f_end, uint8_t _points){
+    if(_points > SIMPLEFOC_FR_POINTS) _points = SIMPLEFOC_FR_POINTS;
+    if(_points < 1 || _f_start <= 0 || f_end <= 0) return;
+    points = _points;
+    f_start = _f_start;
+    f_step = points > 1 ? powf(f_end / f_start, 1.0f / (points - 1)) : 1.0f;
+    count = 0;
+    reported = 0;
+    angle = 0;
+    point(0);
+    timestamp_prev = _micros();
+    active = true;
+}
+
+// 停止扫频
+void FrequencyResponse::stop(){
+    active = false;
+}
+
+// 扫频是否正在进行
+bool FrequencyResponse::running(){
+    return active;
+}
+
+// 开始频率点 i
+void FrequencyResponse::point(uint8_t i){
+    f = f_start * powf(f_step, i);
+    u_re = u_im = y_re = y_im = 0;
+}
+
+// 注入扰动并关联响应
+float FrequencyResponse::inject(FrequencyResponseTarget _target, float input, float output){
+    if(!active || _target != target) return input;
+    // 计算自上次调用以来的时间
+    unsigned long timestamp_now = _micros();
+    float Ts = (timestamp_now - timestamp_prev) * 1e-6f;
+    // 快速修复异常情况（micros溢出）
+    if(Ts <= 0 || Ts > 0.5f) Ts = 1e-3f;
+    timestamp_prev = timestamp_now;
+
+    // 输入和当前采样的响应关联 - 响应来自之前的输入，一个采样的延迟包含在相位中
+    float _sa, _ca;
+    _sincos(angle, &_sa, &_ca);
+    float cycles = angle / _2PI;
+    if(cycles >= settle_cycles){
+        // 单频点 DFT，按采样间隔加权
+        float u = input + amplitude * _sa;
+        u_re += u * _ca * Ts;
+        u_im -= u * _sa * Ts;
+        y_re += output * _ca * Ts;
+        y_im -= output * _sa * Ts;
+    }
+
+    // 频率点结束 - 整周期
+    if(cycles >= settle_cycles + measure_cycles){
+        float u = _sqrt(u_re * u_re + u_im * u_im);
+        frequency[count] = f;
+        gain[count] = u > 0 ? _sqrt(y_re * y_re + y_im * y_im) / u : 0;
+        float p = (_atan2(y_im, y_re) - _atan2(u_im, u_re)) * 180.0f / _PI;
+        // 相位范围 (-180, 180]
+        while(p > 180.0f) p -= 360.0f;
+        while(p <= -180.0f) p += 360.0f;
+        phase[count] = p;
+        count++;
+        // 保持正弦连续
+        angle -= _2PI * (settle_cycles + measure_cycles);
+        if(count >= points){
+            active = false;
+            return input;
+        }
+        point(count);
+    }
+
+    float value = input + amplitude * _sa;
+    angle += _2PI * f * Ts;
+    return value;
+}
@@ -0,0 +1,95 @@
+#ifndef FREQUENCY_RESPONSE_H
+#define FREQUENCY_RESPONSE_H
+
+#include "time_utils.h"
+#include "foc_utils.h"
+
+// 频率响应表的最大点数
+#ifndef SIMPLEFOC_FR_POINTS
+#define SIMPLEFOC_FR_POINTS 32
+#endif
+
+/**
+ *  频率响应的注入点
+ */
+enum FrequencyResponseTarget : uint8_t {
+  fr_current  = 0x00, //!< current_sp 注入，响应 current.q - 电流闭环 (loopFOC() 速率)
+  fr_velocity = 0x01, //!< shaft_velocity_sp 注入，响应 shaft_velocity - 速度闭环 (move() 速率)
+  fr_voltage  = 0x02  //!< voltage.q 注入，响应 current.q - 电机对象 (loopFOC() 速率)
+};
+
+/**
+ *  频率响应 (伯德图) 测量 - 正弦扫频
+ *
+ *  - 在注入点的设定值上叠加 amplitude * sin(2*pi*f*t)，对数分布的 points 个频率点
+ *  - 每个频率点先等待 settle_cycles 个周期，然后在 measure_cycles 个整周期上对输入 (设定值 + 扰动)
+ *    和响应做单频点 DFT (按采样间隔加权，允许循环周期抖动) - 不需要采样缓冲区
+ *  - 增益 |Y|/|U| 和相位 arg(Y) - arg(U) 存入表中，可以通过 Commander::frequencyResponse() 读取
+ *  - 每次调用的开销: 一次 _sincos 和几次乘加
+ *
+ *  注入点由电机调用 inject() - 频率应低于调用速率的 1/4。
+ *
+ *  示例:
+ *    FrequencyResponse bode(FrequencyResponseTarget::fr_current, 0.2f);
+ *    motor.linkFrequencyResponse(&bode);
+ *    bode.start(10, 1000, 20);
+ */
+class FrequencyResponse
+{
+public:
+    /**
+     * @param target - 注入点
+     * @param amplitude - 扰动幅值 (注入点的单位)
+     */
+    FrequencyResponse(FrequencyResponseTarget target = FrequencyResponseTarget::fr_current, float amplitude = 0.1f);
+    ~FrequencyResponse() = default; // 默认析构函数
+
+    /**
+     * 开始扫频
+     * @param f_start - 起始频率 [Hz]
+     * @param f_end - 结束频率 [Hz]
+     * @param points - 频率点数 (最多 SIMPLEFOC_FR_POINTS)
+     */
+    void start(float f_start, float f_end, uint8_t points);
+    /** 停止扫频 */
+    void stop();
+    /** 扫频是否正在进行 */
+    bool running();
+
+    /**
+     * 注入扰动并关联响应 - 由电机在注入点调用
+     * @param target - 调用的注入点 - 与 this->target 不同时直接返回 input
+     * @param input - 设定值
+     * @param output - 测量的响应
+     * @returns 加上扰动的设定值
+     */
+    float inject(FrequencyResponseTarget target, float input, float output);
+
+    FrequencyResponseTarget target; //!< 注入点
+    float amplitude; //!< 扰动幅值
+    uint8_t settle_cycles = 2; //!< 每个频率点的稳定周期数
+    uint8_t measure_cycles = 4; //!< 每个频率点的测量周期数
+
+    // 结果表
+    float frequency[SIMPLEFOC_FR_POINTS]; //!< 频率 [Hz]
+    float gain[SIMPLEFOC_FR_POINTS]; //!< 增益 |Y/U|
+    float phase[SIMPLEFOC_FR_POINTS]; //!< 相位 [度]
+    uint8_t points = 0; //!< 扫频的点数
+    volatile uint8_t count = 0; //!< 已测量的点数
+    uint8_t reported = 0; //!< 已输出的点数 - Commander 只输出新的点
+
+protected:
+    float f_start = 0; //!< 起始频率 [Hz]
+    float f_step = 1.0f; //!< 相邻频率点的比例
+    float f = 0; //!< 当前频率 [Hz]
+    float angle = 0; //!< 正弦的相位 [rad]
+    bool active = false; //!< 扫频进行中
+    unsigned long timestamp_prev = 0; //!< 上一次执行的时间戳
+    float u_re = 0, u_im = 0; //!< 输入的 DFT
+    float y_re = 0, y_im = 0; //!< 响应的 DFT
+
+    /** 开始频率点 i */
+    void point(uint8_t i);
+};
+
+#endif // FREQUENCY_RESPONSE_H
@@ -0,0 +1,79 @@
+#include "loop_rate_manager.h"
+#include "../communication/SimpleFOCDebug.h"
+
+// 循环速率管理构造函数
+LoopRateManager::LoopRateManager(FOCMotor& _motor, FOCDriver& _driver)
+    : motor(&_motor)   // 管理的电机
+    , driver(&_driver) // 电机的驱动器
+{
+}
+
+// 保存整定的值
+void LoopRateManager::init(){
+    P_q = motor->PID_current_q.P;
+    I_q = motor->PID_current_q.I;
+    P_d = motor->PID_current_d.P;
+    I_d = motor->PID_current_d.I;
+    Tf_q = motor->LPF_current_q.Tf;
+    Tf_d = motor->LPF_current_d.Tf;
+    scale = 1.0f;
+    written_P_q = P_q; written_I_q = I_q;
+    written_P_d = P_d; written_I_d = I_d;
+    written_Tf_q = Tf_q; written_Tf_d = Tf_d;
+    loop_count = 0;
+    timestamp_prev = _micros();
+}
+
+// 测量循环频率
+void LoopRateManager::update(){
+    loop_count++;
+    unsigned long timestamp_now = _micros();
+    float dt = (timestamp_now - timestamp_prev) * 1e-6f;
+    if(dt < interval) return;
+    // 间隔内的平均频率（micros溢出时差值仍然正确）
+    loop_frequency = loop_count / dt;
+    loop_count = 0;
+    timestamp_prev = timestamp_now;
+    retune();
+}
+
+// 根据测量的循环频率调整
+void LoopRateManager::retune(){
+    if(!_isset(loop_frequency_nominal)) loop_frequency_nominal = loop_frequency;
+
+    // PWM 频率 - 只有变化超过滞后时才更改，避免频繁重新配置定时器
+    float pwm_frequency = _constrain(loop_frequency * pwm_per_loop, pwm_frequency_min, pwm_frequency_max);
+    float pwm_current = driver->pwm_frequency > 0 ? (float)driver->pwm_frequency : 0;
+    if(fabs(pwm_frequency - pwm_current) > hysteresis * pwm_current){
+        if(driver->setPwmFrequency((long)pwm_frequency)){
+            pwm_changes++;
+            SIMPLEFOC_DEBUG("LR: PWM: ", (float)driver->pwm_frequency);
+        }
+    }
+
+    // 循环分频 - move() 的执行频率保持不变
+    if(_isset(motion_frequency) && motion_frequency > 0){
+        float downsample = loop_frequency / motion_frequency - 0.5f;
+        motor->motion_downsample = downsample > 0 ? (unsigned int)downsample : 0;
+    }
+
+    // 电流环 - PI 零点抵消电机极点时 P 和 I 都与带宽成比例
+    if(loop_frequency_nominal <= 0) return;
+    // 在外部修改的值（Commander、RegisterMap、MotorTuning）保持有效 - 作为当前比例下的新整定值
+    if(motor->PID_current_q.P != written_P_q) P_q = motor->PID_current_q.P / scale;
+    if(motor->PID_current_q.I != written_I_q) I_q = motor->PID_current_q.I / scale;
+    if(motor->PID_current_d.P != written_P_d) P_d = motor->PID_current_d.P / scale;
+    if(motor->PID_current_d.I != written_I_d) I_d = motor->PID_current_d.I / scale;
+    if(motor->LPF_current_q.Tf != written_Tf_q) Tf_q = motor->LPF_current_q.Tf * scale;
+    if(motor->LPF_current_d.Tf != written_Tf_d) Tf_d = motor->LPF_current_d.Tf * scale;
+    // 只在比例改变时写入
+    float new_scale = _constrain(loop_frequency / loop_frequency_nominal, scale_min, 1.0f);
+    if(new_scale == scale) return;
+    scale = new_scale;
+    motor->PID_current_q.P = written_P_q = P_q * scale;
+    motor->PID_current_q.I = written_I_q = I_q * scale;
+    motor->PID_current_d.P = written_P_d = P_d * scale;
+    motor->PID_current_d.I = written_I_d = I_d * scale;
+    motor->LPF_current_q.Tf = written_Tf_q = Tf_q / scale;
+    motor->LPF_current_d.Tf = written_Tf_d = Tf_d / scale;
+}
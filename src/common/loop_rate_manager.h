@@ -0,0 +1,77 @@
+#ifndef LOOP_RATE_MANAGER_H
+#define LOOP_RATE_MANAGER_H
+
+#include "time_utils.h"
+#include "foc_utils.h"
+#include "base_classes/FOCMotor.h"
+#include "base_classes/FOCDriver.h"
+
+/**
+ *  PWM 频率和循环速率管理 - 根据实际的 loopFOC() 速率在运行时调整
+ *
+ *  - 测量 interval 时间内的平均循环频率
+ *  - PWM 频率: 循环频率 * pwm_per_loop，限制在 [pwm_frequency_min, pwm_frequency_max]，
+ *    变化超过 hysteresis 时通过 driver.setPwmFrequency() 设置（硬件不支持时不改变）
+ *  - 循环分频: 设置 motion_frequency 时调整 motion_downsample，move() 的执行频率保持不变
+ *  - 电流环: 循环频率低于 loop_frequency_nominal 时电流 PI 的 P 和 I 按比例减小（带宽与采样率成比例），
+ *    电流低通滤波器的时间常数按比例增大 - 慢的循环保持稳定，恢复后回到整定的值
+ *
+ *  init() 保存当前的电流环增益和滤波器时间常数作为整定值。增益只在比例改变时写入，
+ *  运行时在外部修改的增益（Commander、RegisterMap、MotorTuning）保持有效，并按当前比例换算成新的整定值。
+ *
+ *  示例:
+ *    LoopRateManager rate(motor, driver);
+ *    ...
+ *    motor.initFOC();
+ *    rate.init();
+ *    loop(){ motor.loopFOC(); motor.move(); rate.update(); }
+ */
+class LoopRateManager
+{
+public:
+    /**
+     * @param motor - 管理的电机
+     * @param driver - 电机的驱动器
+     */
+    LoopRateManager(FOCMotor& motor, FOCDriver& driver);
+    ~LoopRateManager() = default; // 默认析构函数
+
+    /** 保存整定的电流环增益和滤波器时间常数，重新开始测量 */
+    void init();
+    /** 每次控制循环调用一次 - 测量循环频率并每 interval 调整一次 */
+    void update();
+
+    float pwm_frequency_min = 10000; //!< 最小 PWM 频率 [Hz]
+    float pwm_frequency_max = 40000; //!< 最大 PWM 频率 [Hz]
+    float pwm_per_loop = 1.0f; //!< 每个 loopFOC() 的 PWM 周期数
+    float motion_frequency = NOT_SET; //!< move() 的目标执行频率 [Hz] - NOT_SET 不调整 motion_downsample
+    float loop_frequency_nominal = NOT_SET; //!< 电流环整定时的循环频率 [Hz] - NOT_SET 则使用第一次测量的值
+    float scale_min = 0.2f; //!< 电流环增益的最小比例
+    float interval = 0.1f; //!< 测量和调整的间隔 [s]
+    float hysteresis = 0.1f; //!< PWM 频率的相对变化阈值
+
+    float loop_frequency = 0; //!< 测量的循环频率 [Hz]
+    float scale = 1.0f; //!< 当前的电流环增益比例
+    unsigned long pwm_changes = 0; //!< PWM 频率更改的次数
+
+protected:
+    FOCMotor* motor; //!< 管理的电机
+    FOCDriver* driver; //!< 电机的驱动器
+
+    unsigned long timestamp_prev = 0; //!< 测量间隔的开始时间 [us]
+    unsigned long loop_count = 0; //!< 测量间隔内的循环数
+
+    // 整定的值
+    float P_q = 0, I_q = 0; //!< q 电流 PI 增益
+    float P_d = 0, I_d = 0; //!< d 电流 PI 增益
+    float Tf_q = 0, Tf_d = 0; //!< 电流低通滤波器时间常数 [s]
+    // 上一次写入电机的值 - 不同时说明在外部被修改
+    float written_P_q = 0, written_I_q = 0; //!< 写入的 q 电流 PI 增益
+    float written_P_d = 0, written_I_d = 0; //!< 写入的 d 电流 PI 增益
+    float written_Tf_q = 0, written_Tf_d = 0; //!< 写入的电流低通滤波器时间常数 [s]
+
+    /** 根据测量的循环频率调整 */
+    void retune();
+};
+
+#endif // LOOP_RATE_MANAGER_H
@@ -0,0 +1,272 @@
+#include "motor_identification.h"
+#include "../communication/SimpleFOCDebug.h"
+
+// 参数辨识构造函数
+MotorIdentification::MotorIdentification(float _test_current, float _spin_velocity)
+    : test_current(_test_current)   // 测试电流
+    , spin_velocity(_spin_velocity) // 旋转测试的电速度
+{
+}
+
+// 链接电机
+void MotorIdentification::linkMotor(FOCMotor* _motor){
+    motor = _motor;
+}
+
+// 开始辨识
+void MotorIdentification::start(){
+    if(!motor || !motor->current_sense){
+        SIMPLEFOC_ERROR("ID: 没有电机或电流检测！");
+        state = id_error;
+        return;
+    }
+    SIMPLEFOC_DEBUG("ID: 开始参数辨识");
+    state = id_resistance;
+    Ud = 0;
+    Uq = 0;
+    next(0);
+    timestamp_prev = _micros();
+}
+
+// 辨识是否正在进行
+bool MotorIdentification::running(){
+    return state != id_idle && state != id_done && state != id_error;
+}
+
+// 进入下一步
+void MotorIdentification::next(uint8_t _step){
+    step = _step;
+    step_time = 0;
+    ramp_sign = 0;
+    clear();
+}
+
+// 清零平均值
+void MotorIdentification::clear(){
+    sum_a = sum_b = sum_c = sum_d = sum_t = 0;
+    cnt = 0;
+}
+
+// 停止并设置状态
+void MotorIdentification::finish(IdentificationState _state){
+    Ud = 0;
+    Uq = 0;
+    motor->voltage.d = 0;
+    motor->voltage.q = 0;
+    motor->setPhaseVoltage(0, 0, 0);
+    state = _state;
+    if(state != id_done) return;
+
+    // 结果写入电机
+    motor->phase_resistance = resistance;
+    motor->phase_inductance = inductance_d;
+    if(pole_pairs > 0) motor->pole_pairs = pole_pairs;
+    if(_isset(flux_linkage) && flux_linkage > 0) motor->KV_rating = 1.0f / (flux_linkage * _SQRT3 * _RPM_TO_RADS * motor->pole_pairs);
+    SIMPLEFOC_DEBUG("ID: R: ", resistance);
+    SIMPLEFOC_DEBUG("ID: Ld: ", inductance_d * 1e6f);
+    SIMPLEFOC_DEBUG("ID: Lq: ", inductance_q * 1e6f);
+    if(_isset(flux_linkage)){
+        SIMPLEFOC_DEBUG("ID: 磁链: ", flux_linkage * 1e3f);
+        SIMPLEFOC_DEBUG("ID: KV: ", motor->KV_rating);
+        SIMPLEFOC_DEBUG("ID: 极对数: ", pole_pairs);
+        SIMPLEFOC_DEBUG("ID: 粘滞摩擦: ", friction_viscous * 1e6f);
+        SIMPLEFOC_DEBUG("ID: 库仑摩擦: ", friction_coulomb * 1e3f);
+        SIMPLEFOC_DEBUG("ID: 惯量: ", inertia * 1e6f);
+    }
+}
+
+// 旋转测试的电流环 - PI 零点抵消电机极点: Kp = L*bw, Ki = R*bw
+void MotorIdentification::spinCurrent(DQCurrent_s i, float Ts){
+    float Kp = inductance_d * current_bandwidth;
+    float Ki = resistance * current_bandwidth;
+    float e_d = test_current - i.d;
+    float e_q = -i.q;
+    float limit = motor->voltage_limit;
+    int_d = _constrain(int_d + Ki * e_d * Ts, -limit, limit);
+    int_q = _constrain(int_q + Ki * e_q * Ts, -limit, limit);
+    Ud = Kp * e_d + int_d;
+    Uq = Kp * e_q + int_q;
+    // 电压矢量限制
+    float U = _sqrt(Ud * Ud + Uq * Uq);
+    if(U > limit){
+        Ud *= limit / U;
+        Uq *= limit / U;
+    }
+}
+
+// 状态机的一步
+void MotorIdentification::update(){
+    if(!running()) return;
+    // 计算自上次调用以来的时间
+    unsigned long timestamp_now = _micros();
+    float Ts = (timestamp_now - timestamp_prev) * 1e-6f;
+    // 快速修复异常情况（micros溢出）
+    if(Ts <= 0 || Ts > 0.5f) Ts = 1e-3f;
+    timestamp_prev = timestamp_now;
+    step_time += Ts;
+
+    float angle_el = 0;
+    switch(state){
+    case id_resistance: {
+        // 步骤: 0-2 test_current, 3-5 test_current/2 - 斜坡, 稳定, 测量
+        DQCurrent_s i = motor->current_sense->getFOCCurrents(0);
+        float target = step < 3 ? test_current : 0.5f * test_current;
+        if(step == 0 || step == 3){
+            if(ramp_sign == 0) ramp_sign = i.d < target ? 1.0f : -1.0f;
+            Ud += ramp_sign * voltage_ramp * Ts;
+            if((i.d - target) * ramp_sign >= 0) next(step + 1);
+            else if(fabs(Ud) > motor->voltage_limit){
+                SIMPLEFOC_ERROR("ID: 未达到测试电流！");
+                finish(id_error);
+                return;
+            }
+        }else if(step == 1 || step == 4){
+            if(step_time > settle_time) next(step + 1);
+        }else{
+            sum_a += Ud;
+            sum_b += i.d;
+            cnt++;
+            if(step_time > measure_time){
+                float V = sum_a / cnt;
+                float I = sum_b / cnt;
+                if(step == 2){
+                    V1 = V;
+                    I1 = I;
+                    next(3);
+                }else{
+                    // 两点斜率 - 消除电压偏差
+                    if(I1 - I < 0.1f * test_current || V1 <= V){
+                        SIMPLEFOC_ERROR("ID: 电阻测量失败！");
+                        finish(id_error);
+                        return;
+                    }
+                    resistance = (V1 - V) / (I1 - I);
+                    dc_voltage = Ud;
+                    state = id_inductance;
+                    next(0);
+                }
+            }
+        }
+        break;
+    }
+    case id_inductance: {
+        // 步骤: 0-1 d 轴注入, 2-3 q 轴注入 - 稳定, 测量
+        DQCurrent_s i = motor->current_sense->getFOCCurrents(0);
+        float Vh = _constrain(resistance * test_current, 0, 0.5f * motor->voltage_limit);
+        float ix = step < 2 ? i.d : i.q;
+        if(step == 1 || step == 3){
+            sum_a += fabs(ix - i_prev);
+            sum_t += Ts;
+            cnt++;
+        }
+        i_prev = ix;
+        if((step == 0 || step == 2) && step_time > settle_time) next(step + 1);
+        else if((step == 1 || step == 3) && step_time > measure_time){
+            if(sum_a <= 0){
+                SIMPLEFOC_ERROR("ID: 电感测量失败！");
+                finish(id_error);
+                return;
+            }
+            // |di| = V*Ts/L
+            float L = Vh * sum_t / sum_a;
+            if(step == 1){
+                inductance_d = L;
+                next(2);
+            }else{
+                inductance_q = L;
+                if(spin_velocity <= 0){
+                    finish(id_done);
+                    return;
+                }
+                state = id_spin;
+                angle = 0;
+                angle_total = 0;
+                velocity = 0;
+                int_d = dc_voltage;
+                int_q = 0;
+                if(motor->sensor) sensor_angle_start = motor->sensor->getAngle();
+                next(0);
+            }
+        }
+        injection_sign = -injection_sign;
+        Ud = dc_voltage + (step < 2 ? injection_sign * Vh : 0);
+        Uq = step < 2 ? 0 : injection_sign * Vh;
+        break;
+    }
+    case id_spin: {
+        // 步骤: 0 加速到 spin_velocity/2, 1 稳定, 2 测量, 3 加速到 spin_velocity (测量加速转矩), 4 稳定, 5 测量, 6 减速
+        // 电压在整个周期内以固定角度施加，而电流在周期末采样 - 电流变换加半个周期的角度
+        DQCurrent_s i = motor->current_sense->getFOCCurrents(angle + 0.5f * velocity * Ts);
+        // 反电动势 e = u - R*i - j*w*L*i (I/f 坐标系)
+        float e_d = Ud - resistance * i.d + velocity * inductance_d * i.q;
+        float e_q = Uq - resistance * i.q - velocity * inductance_d * i.d;
+        if(step == 2 || step == 3 || step == 5){
+            sum_a += e_d;
+            sum_b += e_q;
+            sum_c += e_d * i.d + e_q * i.q;
+            sum_d += velocity;
+            cnt++;
+        }
+        float v_target = step < 3 ? 0.5f * spin_velocity : spin_velocity;
+        if(step == 0 || step == 3){
+            velocity = _constrain(velocity + spin_acceleration * Ts, 0, v_target);
+            if(velocity >= v_target){
+                // 加速转矩 (每极对) 和平均电速度
+                if(step == 3 && cnt > 0){
+                    T_acc = 1.5f * sum_c / sum_d;
+                    W_acc = sum_d / cnt;
+                }
+                next(step + 1);
+            }
+        }else if(step == 1 || step == 4){
+            if(step_time > settle_time) next(step + 1);
+        }else if(step == 2 || step == 5){
+            if(step_time > measure_time){
+                // 转矩 (每极对) = 1.5*(e.i)/w_电
+                float W = sum_d / cnt;
+                float T = 1.5f * sum_c / sum_d;
+                if(step == 2){
+                    T1 = T;
+                    W1 = W;
+                    next(3);
+                }else{
+                    flux_linkage = _sqrt(sum_a * sum_a + sum_b * sum_b) / sum_d;
+                    // 极对数 - I/f 电角度与传感器机械角度之比
+                    if(motor->sensor){
+                        float d_angle = fabs(motor->sensor->getAngle() - sensor_angle_start);
+                        if(d_angle > 1.0f) pole_pairs = (int)(angle_total / d_angle + 0.5f);
+                    }
+                    int pp = pole_pairs > 0 ? pole_pairs : motor->pole_pairs;
+                    // 转换为机械量 - T = pp*T_pp, w = w_电/pp
+                    friction_viscous = (T - T1) * pp * pp / (W - W1);
+                    friction_coulomb = T1 * pp - friction_viscous * W1 / pp;
+                    inertia = (T_acc * pp - friction_coulomb - friction_viscous * W_acc / pp) * pp / spin_acceleration;
+                    next(6);
+                }
+            }
+        }else{
+            velocity -= spin_acceleration * Ts;
+            if(velocity <= 0){
+                finish(id_done);
+                return;
+            }
+        }
+        spinCurrent(i, Ts);
+        if((Ud * Ud + Uq * Uq) >= 0.99f * motor->voltage_limit * motor->voltage_limit){
+            SIMPLEFOC_ERROR("ID: 电压饱和 - 降低 spin_velocity！");
+            finish(id_error);
+            return;
+        }
+        angle = _normalizeAngle(angle + velocity * Ts);
+        angle_total += velocity * Ts;
+        angle_el = angle;
+        break;
+    }
+    default:
+        break;
+    }
+
+    motor->voltage.d = Ud;
+    motor->voltage.q = Uq;
+    motor->setPhaseVoltage(Uq, Ud, angle_el);
+}
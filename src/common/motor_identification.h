@@ -0,0 +1,118 @@
+#ifndef MOTOR_IDENTIFICATION_H
+#define MOTOR_IDENTIFICATION_H
+
+#include "time_utils.h"
+#include "foc_utils.h"
+#include "base_classes/FOCMotor.h"
+
+/**
+ *  参数辨识状态
+ */
+enum IdentificationState : uint8_t {
+  id_idle       = 0x00, //!< 未启动
+  id_resistance = 0x01, //!< 相电阻 - 两个直流电流点
+  id_inductance = 0x02, //!< d/q 电感 - 方波电压注入
+  id_spin       = 0x03, //!< 磁链、极对数、摩擦和惯量 - 电流闭环的 I/f 开环旋转
+  id_done       = 0x04, //!< 完成 - 结果已写入电机
+  id_error      = 0x05  //!< 失败
+};
+
+/**
+ *  电机参数自动辨识 - 非阻塞状态机，由 loopFOC() 调用
+ *
+ *  - 相电阻: 电角度 0 处的 d 轴直流电压，两个电流点 (test_current 和 test_current/2) 的 dV/dI，
+ *    消除死区和开关管压降造成的电压偏差
+ *  - Ld/Lq: 在直流偏置上叠加 +-注入电压方波，每个周期电流变化 |di| = V*Ts/L
+ *  - 磁链: 以 test_current 的电流矢量开环旋转 (I/f)，反电动势 e = u - R*i - j*w*L*i，磁链 = |e|/w
+ *  - 极对数: 旋转的电角度与传感器角度之比 (需要链接传感器)
+ *  - 摩擦: 两个速度下的转矩 1.5*(e.i)/w_机械 - 粘滞和库仑摩擦
+ *  - 惯量: 两个速度之间加速时的转矩减去摩擦转矩，除以角加速度
+ *
+ *  辨识期间 loopFOC() 和 move() 不执行控制，相电压由本类通过 setPhaseVoltage() 设置。
+ *  完成后结果写入电机: phase_resistance, phase_inductance (Ld), KV_rating 和 pole_pairs (如果有传感器)。
+ *  需要电流检测; 电机时间常数 L/R 应大于循环周期。
+ *
+ *  示例:
+ *    MotorIdentification identification;
+ *    motor.linkIdentification(&identification);
+ *    ...
+ *    identification.start();
+ *    loop(){ motor.loopFOC(); motor.move(); }
+ */
+class MotorIdentification
+{
+public:
+    /**
+     * @param test_current - 测试电流 [A]
+     * @param spin_velocity - 旋转测试的电速度 [rad/s] - 0 跳过旋转测试
+     */
+    MotorIdentification(float test_current = 1.0f, float spin_velocity = 100.0f);
+    ~MotorIdentification() = default; // 默认析构函数
+
+    /** 链接电机 - 由 FOCMotor::linkIdentification() 调用 */
+    void linkMotor(FOCMotor* motor);
+    /** 开始辨识 */
+    void start();
+    /** 辨识是否正在进行 */
+    bool running();
+    /** 状态机的一步 - 由 loopFOC() 调用 */
+    void update();
+
+    float test_current; //!< 测试电流 [A]
+    float spin_velocity; //!< 旋转测试的电速度 [rad/s]
+    float spin_acceleration = 200.0f; //!< 旋转测试的电角加速度 [rad/s^2]
+    float voltage_ramp = 2.0f; //!< 直流电压斜坡 [V/s]
+    float settle_time = 0.2f; //!< 每个测量前的稳定时间 [s]
+    float measure_time = 0.3f; //!< 每个测量的平均时间 [s]
+    float current_bandwidth = 300.0f; //!< 旋转测试电流环带宽 [rad/s]
+
+    IdentificationState state = id_idle; //!< 当前状态
+
+    // 结果
+    float resistance = NOT_SET; //!< 相电阻 [Ohm]
+    float inductance_d = NOT_SET; //!< d 轴电感 [H]
+    float inductance_q = NOT_SET; //!< q 轴电感 [H]
+    float flux_linkage = NOT_SET; //!< 永磁磁链 [V*s/rad]
+    int pole_pairs = 0; //!< 极对数 - 0 如果没有传感器
+    float friction_viscous = NOT_SET; //!< 粘滞摩擦 [Nm/(rad/s)]
+    float friction_coulomb = NOT_SET; //!< 库仑摩擦 [Nm]
+    float inertia = NOT_SET; //!< 转动惯量 [kg*m^2]
+
+protected:
+    FOCMotor* motor = nullptr; //!< 被辨识的电机
+    uint8_t step = 0; //!< 当前状态内的步骤
+    float step_time = 0; //!< 当前步骤的时间 [s]
+    unsigned long timestamp_prev = 0; //!< 上一次执行的时间戳
+
+    float Ud = 0; //!< d 电压 [V]
+    float Uq = 0; //!< q 电压 [V]
+    float ramp_sign = 0; //!< 直流电压斜坡方向
+    float dc_voltage = 0; //!< 电感测试的直流偏置电压 [V]
+    float injection_sign = 1.0f; //!< 方波注入的符号
+    float i_prev = 0; //!< 上一次的电流 (电感测试) [A]
+
+    float angle = 0; //!< I/f 电角度 [rad]
+    float angle_total = 0; //!< I/f 累积电角度 [rad]
+    float velocity = 0; //!< I/f 电速度 [rad/s]
+    float sensor_angle_start = 0; //!< 旋转测试开始时的传感器角度 [rad]
+    float int_d = 0; //!< 电流环 d 积分 [V]
+    float int_q = 0; //!< 电流环 q 积分 [V]
+
+    // 平均值
+    float sum_a = 0, sum_b = 0, sum_c = 0, sum_d = 0, sum_t = 0;
+    long cnt = 0;
+    float V1 = 0, I1 = 0; //!< 第一个电阻测量点
+    float T1 = 0, W1 = 0; //!< 低速转矩 [Nm] 和机械速度 [rad/s]
+    float T_acc = 0, W_acc = 0; //!< 加速时的平均转矩和机械速度
+
+    /** 进入下一步 */
+    void next(uint8_t step);
+    /** 清零平均值 */
+    void clear();
+    /** 停止并设置状态 */
+    void finish(IdentificationState state);
+    /** 旋转测试的电流环 - 电流矢量在 I/f 角度方向 */
+    void spinCurrent(DQCurrent_s i, float Ts);
+};
+
+#endif // MOTOR_IDENTIFICATION_H
@@ -0,0 +1,228 @@
+#include "motor_tuning.h"
+#include "../communication/SimpleFOCDebug.h"
+
+// 频率扫描的点数和范围
+#define _TUNE_SWEEP_POINTS 200
+#define _TUNE_SWEEP_DECADES 3.0f
+
+// 自动整定构造函数
+MotorTuning::MotorTuning(float _current_bandwidth, float _velocity_bandwidth)
+    : current_bandwidth(_current_bandwidth)   // 电流环目标带宽
+    , velocity_bandwidth(_velocity_bandwidth) // 速度环目标带宽
+{
+}
+
+// 链接电机
+void MotorTuning::linkMotor(FOCMotor* _motor){
+    motor = _motor;
+}
+
+// 开始整定 - 先测量循环周期
+void MotorTuning::start(){
+    if(!motor){
+        SIMPLEFOC_ERROR("TUNE: 没有电机！");
+        state = tune_error;
+        return;
+    }
+    state = tune_timing;
+    state_time = 0;
+    cnt = 0;
+    current_tuned = false;
+    timestamp_prev = _micros();
+}
+
+// 整定是否正在进行
+bool MotorTuning::running(){
+    return state == tune_timing || state == tune_relay;
+}
+
+// 停止并设置状态
+void MotorTuning::finish(TuningState _state){
+    if(state == tune_relay){
+        // 恢复控制模式和目标值
+        motor->controller = controller_prev;
+        motor->target = target_prev;
+    }
+    state = _state;
+}
+
+// 开环频率响应 - 幅值相乘，相位相加 (不需要复数运算，相位不卷绕)
+void MotorTuning::openLoop(bool velocity_loop, float w, float* mag, float* phase){
+    PIDController& pid = velocity_loop ? motor->PID_velocity : motor->PID_current_q;
+    // PI: Kp + Ki/(jw)
+    float m = _sqrt(pid.P * pid.P + pid.I * pid.I / (w * w));
+    float p = _atan2(-pid.I / w, pid.P);
+    if(velocity_loop){
+        // 对象: g/(jw)
+        m *= plant_gain / w;
+        p -= _PI_2;
+        // 闭环电流环 Lc/(1+Lc)
+        if(current_tuned){
+            float mc, pc;
+            openLoop(false, w, &mc, &pc);
+            float re = 1.0f + mc * _cos(pc);
+            float im = mc * _sin(pc);
+            m *= mc / _sqrt(re * re + im * im);
+            p += pc - _atan2(im, re);
+        }
+        // 速度滤波器
+        float Tf = motor->LPF_velocity.Tf;
+        m /= _sqrt(1.0f + w * w * Tf * Tf);
+        p -= _atan2(w * Tf, 1.0f);
+        // move() 的延迟 - 下采样加上 1.5 个周期 (计算和 PWM 保持)
+        p -= w * loop_period * (motor->motion_downsample + 1.5f);
+    }else{
+        // 对象: 1/(R + jwL)
+        float R = motor->phase_resistance;
+        float L = motor->phase_inductance;
+        m /= _sqrt(R * R + w * w * L * L);
+        p -= _atan2(w * L, R);
+        // 电流滤波器
+        float Tf = motor->LPF_current_q.Tf;
+        m /= _sqrt(1.0f + w * w * Tf * Tf);
+        p -= _atan2(w * Tf, 1.0f);
+        // 1.5 个周期的延迟
+        p -= w * loop_period * 1.5f;
+    }
+    *mag = m;
+    *phase = p;
+}
+
+// 扫频计算闭环带宽和相位裕度
+void MotorTuning::analyse(bool velocity_loop, float w_max, float* bandwidth, float* phase_margin){
+    *bandwidth = NOT_SET;
+    *phase_margin = NOT_SET;
+    float k = powf(10.0f, _TUNE_SWEEP_DECADES / _TUNE_SWEEP_POINTS);
+    float w = w_max / powf(10.0f, _TUNE_SWEEP_DECADES);
+    for(int i = 0; i < _TUNE_SWEEP_POINTS; i++, w *= k){
+        float m, p;
+        openLoop(velocity_loop, w, &m, &p);
+        // 穿越频率处的相位裕度
+        if(!_isset(*phase_margin) && m < 1.0f) *phase_margin = 180.0f + p * 180.0f / _PI;
+        // 闭环 |L/(1+L)| < 0.707
+        float re = 1.0f + m * _cos(p);
+        float im = m * _sin(p);
+        if(m * m < 0.5f * (re * re + im * im)){
+            *bandwidth = w;
+            break;
+        }
+    }
+}
+
+// 电流环整定 - Kp = L*wc, Ki = R*wc
+void MotorTuning::tuneCurrent(){
+    if(motor->torque_controller == TorqueControlType::voltage) return;
+    if(!_isset(motor->phase_resistance) || !_isset(motor->phase_inductance)){
+        SIMPLEFOC_WARN("TUNE: 电流环需要 phase_resistance 和 phase_inductance！");
+        return;
+    }
+    float wc = _constrain(current_bandwidth, 0, 0.2f / loop_period);
+    motor->PID_current_q.P = motor->PID_current_d.P = motor->phase_inductance * wc;
+    motor->PID_current_q.I = motor->PID_current_d.I = motor->phase_resistance * wc;
+    motor->PID_current_q.D = motor->PID_current_d.D = 0;
+    motor->PID_current_q.reset();
+    motor->PID_current_d.reset();
+    current_tuned = true;
+    analyse(false, _PI / loop_period, &current_bandwidth_achieved, &current_phase_margin);
+    SIMPLEFOC_DEBUG("TUNE: 电流环 P: ", motor->PID_current_q.P);
+    SIMPLEFOC_DEBUG("TUNE: 电流环 I: ", motor->PID_current_q.I);
+    SIMPLEFOC_DEBUG("TUNE: 电流环带宽: ", current_bandwidth_achieved);
+    SIMPLEFOC_DEBUG("TUNE: 电流环相位裕度: ", current_phase_margin);
+}
+
+// 速度环和位置环整定 - PI 零点在 wv/4
+void MotorTuning::tuneVelocity(){
+    float wv = velocity_bandwidth;
+    if(current_tuned) wv = _constrain(wv, 0, 0.2f * current_bandwidth_achieved);
+    wv = _constrain(wv, 0, 0.2f / (loop_period * (motor->motion_downsample + 1.5f)));
+    motor->PID_velocity.P = wv / plant_gain;
+    motor->PID_velocity.I = motor->PID_velocity.P * wv / 4.0f;
+    motor->PID_velocity.D = 0;
+    motor->PID_velocity.reset();
+    motor->P_angle.P = wv / 4.0f;
+    analyse(true, _PI / (loop_period * (motor->motion_downsample + 1)), &velocity_bandwidth_achieved, &velocity_phase_margin);
+    SIMPLEFOC_DEBUG("TUNE: 对象增益: ", plant_gain);
+    SIMPLEFOC_DEBUG("TUNE: 速度环 P: ", motor->PID_velocity.P);
+    SIMPLEFOC_DEBUG("TUNE: 速度环 I: ", motor->PID_velocity.I);
+    SIMPLEFOC_DEBUG("TUNE: 速度环带宽: ", velocity_bandwidth_achieved);
+    SIMPLEFOC_DEBUG("TUNE: 速度环相位裕度: ", velocity_phase_margin);
+    SIMPLEFOC_DEBUG("TUNE: 位置环 P: ", motor->P_angle.P);
+}
+
+// 状态机的一步
+void MotorTuning::update(){
+    if(!running()) return;
+    // 计算自上次调用以来的时间
+    unsigned long timestamp_now = _micros();
+    float Ts = (timestamp_now - timestamp_prev) * 1e-6f;
+    // 快速修复异常情况（micros溢出）
+    if(Ts <= 0 || Ts > 0.5f) Ts = 1e-3f;
+    timestamp_prev = timestamp_now;
+    state_time += Ts;
+    cnt++;
+
+    if(state == tune_timing){
+        if(state_time < 0.2f) return;
+        // 平均循环周期
+        loop_period = state_time / cnt;
+        tuneCurrent();
+        if(!tune_velocity){
+            finish(tune_done);
+            return;
+        }
+        // 开始继电实验
+        controller_prev = motor->controller;
+        target_prev = motor->target;
+        motor->controller = MotionControlType::torque;
+        relay_sign = 1.0f;
+        motor->target = relay_amplitude;
+        cycle_start = -1.0f;
+        cycles = 0;
+        sum_period = sum_amplitude = 0;
+        v_max = v_min = motor->shaft_velocity;
+        state = tune_relay;
+        state_time = 0;
+        return;
+    }
+
+    // 继电实验
+    float v = motor->shaft_velocity;
+    if(v > v_max) v_max = v;
+    if(v < v_min) v_min = v;
+    if(relay_sign > 0 && v > relay_hysteresis){
+        relay_sign = -1.0f;
+    }else if(relay_sign < 0 && v < -relay_hysteresis){
+        relay_sign = 1.0f;
+        // 一个完整周期 - 跳过第一个 (起始瞬态)
+        if(cycle_start >= 0){
+            sum_period += state_time - cycle_start;
+            sum_amplitude += 0.5f * (v_max - v_min);
+            cycles++;
+        }
+        cycle_start = state_time;
+        v_max = v_min = v;
+    }
+    motor->target = relay_sign * relay_amplitude;
+
+    if(cycles >= relay_cycles){
+        float Tu = sum_period / cycles;
+        float a = sum_amplitude / cycles;
+        float Tf = motor->LPF_velocity.Tf;
+        // 周期相对于速度滤波器太短 - 加倍滞环重新开始
+        if(0.25f * Tu < 4.0f * Tf){
+            relay_hysteresis *= 2.0f;
+            cycles = 0;
+            sum_period = sum_amplitude = 0;
+            cycle_start = -1.0f;
+            return;
+        }
+        // 三角波 a = g*d*Tu/4 经过一阶滤波后的峰值: g*d*(Tu/4 - Tf*ln(1 + tanh(Tu/(4*Tf))))
+        float t = 0.25f * Tu - Tf * logf(1.0f + tanhf(0.25f * Tu / Tf));
+        plant_gain = a / (relay_amplitude * t);
+        finish(tune_done);
+        tuneVelocity();
+    }else if(state_time > relay_timeout){
+        SIMPLEFOC_ERROR("TUNE: 继电实验超时！");
+        finish(tune_error);
+    }
+}
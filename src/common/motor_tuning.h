@@ -0,0 +1,116 @@
+#ifndef MOTOR_TUNING_H
+#define MOTOR_TUNING_H
+
+#include "time_utils.h"
+#include "foc_utils.h"
+#include "base_classes/FOCMotor.h"
+
+/**
+ *  自动整定状态
+ */
+enum TuningState : uint8_t {
+  tune_idle    = 0x00, //!< 未启动
+  tune_timing  = 0x01, //!< 测量循环周期
+  tune_relay   = 0x02, //!< 速度环继电反馈实验
+  tune_done    = 0x03, //!< 完成 - 增益已写入电机
+  tune_error   = 0x04  //!< 失败
+};
+
+/**
+ *  电流环和速度环自动整定 - 非阻塞状态机，与 loopFOC() 和 move() 一起在 loop() 中调用
+ *
+ *  - 电流环: PI 零点抵消电机极点 Kp = L*wc, Ki = R*wc (phase_resistance 和 phase_inductance 来自用户或 MotorIdentification)
+ *  - 速度环: 继电反馈实验 - 力矩模式下 +-relay_amplitude 的继电器使速度在零附近振荡 (三角波)，
+ *    对象增益 g = 加速度 / 力矩指令 = 4*a / (d*Tu)，速度滤波器的衰减已补偿;
+ *    振荡周期相对于 LPF_velocity 太短时自动加倍 relay_hysteresis。
+ *    Kp = wv/g, Ki = Kp*wv/4; 位置环 P = wv/4
+ *  - 增益写入 PID_current_q/d, PID_velocity 和 P_angle，并根据模型 (包括滤波器和循环延迟)
+ *    计算实际的闭环带宽和相位裕度
+ *
+ *  继电实验期间电机在力矩模式下运行，完成后恢复控制模式和目标值。
+ *  力矩指令的单位与 PID_velocity 的输出相同 (电流 [A] 或电压 [V])。
+ *
+ *  示例:
+ *    MotorTuning tuning(2000, 100);
+ *    tuning.linkMotor(&motor);
+ *    tuning.start();
+ *    loop(){ motor.loopFOC(); motor.move(); tuning.update(); }
+ */
+class MotorTuning
+{
+public:
+    /**
+     * @param current_bandwidth - 电流环目标带宽 [rad/s]
+     * @param velocity_bandwidth - 速度环目标带宽 [rad/s]
+     */
+    MotorTuning(float current_bandwidth = 1000.0f, float velocity_bandwidth = 50.0f);
+    ~MotorTuning() = default; // 默认析构函数
+
+    /** 链接电机 */
+    void linkMotor(FOCMotor* motor);
+    /** 开始整定 */
+    void start();
+    /** 整定是否正在进行 */
+    bool running();
+    /** 状态机的一步 - 每次 loop() 调用 */
+    void update();
+
+    float current_bandwidth; //!< 电流环目标带宽 [rad/s] - 限制在循环频率的 1/5 以内
+    float velocity_bandwidth; //!< 速度环目标带宽 [rad/s] - 限制在电流环带宽的 1/5 以内
+    bool tune_velocity = true; //!< 运行继电实验并整定速度环和位置环
+    float relay_amplitude = 0.5f; //!< 继电器力矩指令 [A 或 V]
+    float relay_hysteresis = 2.0f; //!< 继电器速度滞环 [rad/s] - 振荡太快时自动加倍
+    uint8_t relay_cycles = 4; //!< 测量的振荡周期数
+    float relay_timeout = 5.0f; //!< 继电实验超时 [s]
+
+    TuningState state = tune_idle; //!< 当前状态
+
+    // 结果
+    float loop_period = 0; //!< 测量的 loop() 周期 [s]
+    float plant_gain = NOT_SET; //!< 速度对象增益 [rad/s^2 每 A 或 V]
+    float current_bandwidth_achieved = NOT_SET; //!< 电流环闭环带宽 [rad/s]
+    float current_phase_margin = NOT_SET; //!< 电流环相位裕度 [度]
+    float velocity_bandwidth_achieved = NOT_SET; //!< 速度环闭环带宽 [rad/s]
+    float velocity_phase_margin = NOT_SET; //!< 速度环相位裕度 [度]
+
+protected:
+    FOCMotor* motor = nullptr; //!< 被整定的电机
+    unsigned long timestamp_prev = 0; //!< 上一次执行的时间戳
+    float state_time = 0; //!< 当前状态的时间 [s]
+    long cnt = 0; //!< 循环计数
+    bool current_tuned = false; //!< 电流环已整定
+
+    // 继电实验
+    MotionControlType controller_prev; //!< 实验前的控制模式
+    float target_prev = 0; //!< 实验前的目标值
+    float relay_sign = 1.0f; //!< 继电器输出符号
+    float cycle_start = -1.0f; //!< 当前周期开始时间 [s]
+    float v_max = 0, v_min = 0; //!< 当前周期的速度极值 [rad/s]
+    float sum_period = 0, sum_amplitude = 0; //!< 周期和幅值之和
+    uint8_t cycles = 0; //!< 已完成的周期数
+
+    /** 电流环整定 */
+    void tuneCurrent();
+    /** 速度环和位置环整定 */
+    void tuneVelocity();
+    /** 停止并设置状态 */
+    void finish(TuningState state);
+    /**
+     * 开环频率响应
+     * @param velocity_loop - 速度环 (否则电流环)
+     * @param w - 频率 [rad/s]
+     * @param mag - 幅值
+     * @param phase - 相位 [rad] (不卷绕)
+     */
+    void openLoop(bool velocity_loop, float w, float* mag, float* phase);
+    /**
+     * 扫频计算闭环带宽和相位裕度
+     * @param velocity_loop - 速度环 (否则电流环)
+     * @param w_max - 最大频率 [rad/s]
+     * @param bandwidth - 闭环 -3dB 带宽 [rad/s]
+     * @param phase_margin - 相位裕度 [度]
+     */
+    void analyse(bool velocity_loop, float w_max, float* bandwidth, float* phase_margin);
+};
+
+#endif // MOTOR_TUNING_H
@@ -0,0 +1,237 @@
+#include "sensor_alignment.h"
+#include "../communication/SimpleFOCDebug.h"
+
+// 传感器对齐构造函数
+SensorAlignment::SensorAlignment(FOCMotor& _motor, int _revolutions)
+    : revolutions(_revolutions) // 每个方向扫描的电周期数
+    , motor(&_motor)            // 对齐的电机
+{
+}
+
+// 开始对齐
+void SensorAlignment::start(){
+    if(!motor->sensor){
+        SIMPLEFOC_ERROR("SA: 没有传感器！");
+        state = sa_error;
+        return;
+    }
+    if(revolutions < 1) revolutions = 1;
+    time = 0;
+    timestamp_prev = _micros();
+    // 检查传感器是否需要零搜索
+    if(motor->sensor->needsSearch()){
+        SIMPLEFOC_DEBUG("SA: 索引搜索...");
+        angle = 0;
+        next(sa_search);
+    }else{
+        startSweep();
+    }
+}
+
+// 对齐是否正在进行
+bool SensorAlignment::running(){
+    return state != sa_idle && state != sa_done && state != sa_error;
+}
+
+// 中止对齐
+void SensorAlignment::abort(){
+    if(running()) finish(sa_error);
+}
+
+// 进入状态
+void SensorAlignment::next(SensorAlignState _state){
+    state = _state;
+    step_time = 0;
+}
+
+// 索引搜索之后 - 开始扫描或直接完成
+void SensorAlignment::startSweep(){
+    if(motor->sensor_direction != Direction::UNKNOWN && _isset(motor->zero_electric_angle)){
+        SIMPLEFOC_DEBUG("SA: 跳过方向和偏移校准。");
+        finish(sa_done);
+        return;
+    }
+    sum_cw_sin = sum_cw_cos = sum_ccw_sin = sum_ccw_cos = 0;
+    angle = _3PI_2;
+    next(sa_settle);
+}
+
+// 设置磁场角度并累加两个可能方向的偏移
+// 磁场在 3PI/2 时转子电角度即为零电角，因此偏移 = 传感器电角度 - (磁场角度 - 3PI/2)
+void SensorAlignment::sweep(float _angle){
+    angle = _angle;
+    motor->setPhaseVoltage(motor->voltage_sensor_align, 0, angle);
+    float angle_el = motor->pole_pairs * motor->sensor->getMechanicalAngle();
+    float s, c;
+    _sincos(_normalizeAngle(angle_el - angle + _3PI_2), &s, &c);
+    sum_cw_sin += s;
+    sum_cw_cos += c;
+    _sincos(_normalizeAngle(-angle_el - angle + _3PI_2), &s, &c);
+    sum_ccw_sin += s;
+    sum_ccw_cos += c;
+}
+
+// 状态机的一步
+void SensorAlignment::update(){
+    if(!running()) return;
+
+    // 计算自上次调用以来的时间
+    unsigned long timestamp_now = _micros();
+    float Ts = (timestamp_now - timestamp_prev) * 1e-6f;
+    // 快速修复异常情况（micros溢出）
+    if(Ts <= 0 || Ts > 0.5f) Ts = 1e-3f;
+    timestamp_prev = timestamp_now;
+    time += Ts;
+    step_time += Ts;
+
+    motor->sensor->update();
+
+    // 限制监视
+    if(timeout > 0 && time > timeout){
+        SIMPLEFOC_ERROR("SA: 超时！");
+        finish(sa_error);
+        return;
+    }
+    if(motor->current_sense && motor->current_sense->initialized){
+        float limit = _isset(current_limit) ? current_limit : motor->current_limit;
+        if(fabs(motor->current_sense->getDCCurrent()) > limit){
+            SIMPLEFOC_ERROR("SA: 过流！");
+            finish(sa_error);
+            return;
+        }
+    }
+
+    float sweep_end = _3PI_2 + _2PI * revolutions;
+    switch(state){
+        case sa_search:
+            // 以小速度搜索绝对零，最多一圈
+            angle += motor->velocity_index_search * Ts;
+            motor->setPhaseVoltage(motor->voltage_sensor_align, 0, _electricalAngle(angle, motor->pole_pairs));
+            if(!motor->sensor->needsSearch()){
+                SIMPLEFOC_DEBUG("SA: 索引找到！");
+                motor->setPhaseVoltage(0, 0, 0);
+                startSweep();
+            }else if(angle >= _2PI){
+                SIMPLEFOC_ERROR("SA: 错误: 未找到索引！");
+                finish(sa_error);
+            }
+            break;
+        case sa_settle:
+            motor->setPhaseVoltage(motor->voltage_sensor_align, 0, _3PI_2);
+            if(step_time >= settle_time) next(sa_forward);
+            break;
+        case sa_forward:
+            sweep(_constrain(angle + sweep_velocity * Ts, _3PI_2, sweep_end));
+            if(angle >= sweep_end){
+                mid_angle = motor->sensor->getAngle();
+                next(sa_backward);
+            }
+            break;
+        case sa_backward:
+            sweep(_constrain(angle - sweep_velocity * Ts, _3PI_2, sweep_end));
+            if(angle <= _3PI_2) finish(sweepResult() ? sa_done : sa_error);
+            break;
+        default:
+            break;
+    }
+}
+
+// 停止并设置状态
+void SensorAlignment::finish(SensorAlignState _state){
+    motor->setPhaseVoltage(0, 0, 0);
+    state = _state;
+}
+
+// 根据扫描结果设置方向、极对数检查和零电角
+bool SensorAlignment::sweepResult(){
+    // 确定传感器移动的方向
+    float end_angle = motor->sensor->getAngle();
+    float moved = fabs(mid_angle - end_angle);
+    if(moved < MIN_ANGLE_DETECT_MOVEMENT){
+        SIMPLEFOC_ERROR("SA: 未能注意到移动");
+        return false;
+    }
+    if(motor->sensor_direction == Direction::UNKNOWN){
+        if(mid_angle < end_angle){
+            SIMPLEFOC_DEBUG("SA: sensor_direction==CCW");
+            motor->sensor_direction = Direction::CCW;
+        }else{
+            SIMPLEFOC_DEBUG("SA: sensor_direction==CW");
+            motor->sensor_direction = Direction::CW;
+        }
+        // 检查极对数 - 每个电周期的移动
+        moved /= revolutions;
+        motor->pp_check_result = !(fabs(moved * motor->pole_pairs - _2PI) > 0.5f);
+        if(motor->pp_check_result == false){
+            SIMPLEFOC_WARN("SA: PP 检查: 失败 - 估计的极对数: ", _2PI / moved);
+        }else{
+            SIMPLEFOC_DEBUG("SA: PP 检查: 成功！");
+        }
+    }
+    if(!_isset(motor->zero_electric_angle)){
+        // 偏移的圆周平均
+        if(motor->sensor_direction == Direction::CW)
+            motor->zero_electric_angle = _normalizeAngle(_atan2(sum_cw_sin, sum_cw_cos));
+        else
+            motor->zero_electric_angle = _normalizeAngle(_atan2(sum_ccw_sin, sum_ccw_cos));
+        SIMPLEFOC_DEBUG("SA: 零电气角: ", motor->zero_electric_angle);
+    }
+    return true;
+}
+
+
+// 添加任务
+bool AlignmentCoordinator::add(SensorAlignment* job){
+    if(count >= SIMPLEFOC_ALIGNMENT_MAX_JOBS) return false;
+    jobs[count++] = job;
+    return true;
+}
+
+// 开始所有任务
+void AlignmentCoordinator::start(){
+    started = 0;
+    for(int i = 0; i < count; i++) jobs[i]->state = sa_idle;
+    update();
+}
+
+// 所有正在运行的任务的一步
+bool AlignmentCoordinator::update(){
+    int active = 0;
+    bool error = false;
+    for(int i = 0; i < started; i++){
+        if(!jobs[i]->running()) continue;
+        jobs[i]->update();
+        if(jobs[i]->running()) active++;
+        else if(jobs[i]->state == sa_error) error = true;
+    }
+    // 启动排队的任务 - max_active 为 0 时不限制
+    while(started < count && (active < max_active || !max_active)){
+        jobs[started]->start();
+        if(jobs[started]->running()) active++;
+        else if(jobs[started]->state == sa_error) error = true;
+        started++;
+    }
+    if(error && abort_on_error){
+        SIMPLEFOC_ERROR("SA: 中止所有对齐！");
+        for(int i = 0; i < started; i++) jobs[i]->abort();
+        // 排队的任务不再启动
+        for(int i = started; i < count; i++) jobs[i]->state = sa_error;
+        started = count;
+        return false;
+    }
+    return active > 0 || started < count;
+}
+
+// 阻塞运行所有任务直到完成
+int AlignmentCoordinator::run(){
+    start();
+    while(update());
+    return failed() == 0;
+}
+
+// 失败的任务数
+int AlignmentCoordinator::failed(){
+    int n = 0;
+    for(int i = 0; i < count; i++) if(jobs[i]->state == sa_error) n++;
+    return n;
+}
@@ -0,0 +1,135 @@
+#ifndef SENSOR_ALIGNMENT_H
+#define SENSOR_ALIGNMENT_H
+
+#include "time_utils.h"
+#include "foc_utils.h"
+#include "base_classes/FOCMotor.h"
+
+// 协调器可以管理的最大对齐任务数
+#ifndef SIMPLEFOC_ALIGNMENT_MAX_JOBS
+#define SIMPLEFOC_ALIGNMENT_MAX_JOBS 4
+#endif
+
+/**
+ *  传感器对齐状态
+ */
+enum SensorAlignState : uint8_t {
+  sa_idle     = 0x00, //!< 未启动
+  sa_search   = 0x01, //!< 索引搜索 - 开环慢速旋转直到找到索引
+  sa_settle   = 0x02, //!< 在电角度 3PI/2 处等待转子稳定
+  sa_forward  = 0x03, //!< 正向扫描 revolutions 个电周期
+  sa_backward = 0x04, //!< 反向扫描 revolutions 个电周期
+  sa_done     = 0x05, //!< 完成 - 结果已写入电机
+  sa_error    = 0x06  //!< 失败或中止
+};
+
+/**
+ *  传感器对齐 - BLDCMotor::alignSensor() 和 absoluteZeroSearch() 的非阻塞状态机
+ *
+ *  - 索引搜索: 以 velocity_index_search 开环旋转，最多一圈
+ *  - 方向和极对数检查: 正向和反向各扫描 revolutions 个电周期，比较传感器角度
+ *  - 零电角: 扫描期间每个样本的偏移 (传感器电角度 - 磁场角度) 的圆周平均，
+ *    正反两个方向的平均抵消了摩擦引起的滞后，多个电周期的平均抵消了传感器的非线性
+ *
+ *  完成后 sensor_direction、zero_electric_angle 和 pp_check_result 写入电机，
+ *  之后的 initFOC() 跳过阻塞的传感器对齐。多个电机的任务由 AlignmentCoordinator 并行运行。
+ */
+class SensorAlignment
+{
+public:
+    /**
+     * @param motor - 对齐的电机（需要链接传感器，init() 之后启用）
+     * @param revolutions - 每个方向扫描的电周期数
+     */
+    SensorAlignment(FOCMotor& motor, int revolutions = 2);
+    ~SensorAlignment() = default; // 默认析构函数
+
+    /** 开始对齐 */
+    void start();
+    /** 对齐是否正在进行 */
+    bool running();
+    /** 状态机的一步 - 迭代调用 */
+    void update();
+    /** 中止对齐并关闭相电压 */
+    void abort();
+
+    int revolutions; //!< 每个方向扫描的电周期数
+    float sweep_velocity = _2PI; //!< 扫描的电速度 [rad/s]
+    float settle_time = 0.7f; //!< 扫描前的稳定时间 [s]
+    float timeout = 30.0f; //!< 最长对齐时间 [s] - 0 不限制
+    float current_limit = NOT_SET; //!< 对齐期间的最大电流 [A]（需要电流检测）- NOT_SET 则使用电机的 current_limit
+
+    SensorAlignState state = sa_idle; //!< 当前状态
+    FOCMotor* motor; //!< 对齐的电机
+
+protected:
+    unsigned long timestamp_prev = 0; //!< 上一次执行的时间戳
+    float time = 0; //!< 对齐开始后的时间 [s]
+    float step_time = 0; //!< 当前状态的时间 [s]
+    float angle = 0; //!< 磁场电角度 [rad]（索引搜索时为轴角度）
+    float mid_angle = 0; //!< 正向扫描结束时的传感器角度 [rad]
+    // 两个可能方向的偏移圆周平均
+    float sum_cw_sin = 0, sum_cw_cos = 0; //!< 方向 CW 的偏移累加
+    float sum_ccw_sin = 0, sum_ccw_cos = 0; //!< 方向 CCW 的偏移累加
+
+    /** 进入状态 */
+    void next(SensorAlignState state);
+    /** 索引搜索之后 - 开始扫描或直接完成 */
+    void startSweep();
+    /** 扫描的一步 - 设置磁场角度并累加偏移 */
+    void sweep(float angle);
+    /** 停止并设置状态 */
+    void finish(SensorAlignState state);
+    /** 根据扫描结果设置方向和零电角 - 返回 false 如果没有检测到移动 */
+    bool sweepResult();
+};
+
+/**
+ *  并行运行多个电机的传感器对齐
+ *
+ *  - 最多 max_active 个任务同时运行（例如电源无法同时为所有电机供电），其余的排队
+ *  - 每个任务监视自己的超时和电流限制
+ *  - abort_on_error 时一个任务失败会中止所有任务
+ *
+ *  示例:
+ *    SensorAlignment align1(motor1), align2(motor2);
+ *    AlignmentCoordinator alignment;
+ *    alignment.add(&align1); alignment.add(&align2);
+ *    alignment.run();           // 或者在 loop() 中迭代调用 alignment.update()
+ *    motor1.initFOC(); motor2.initFOC();
+ */
+class AlignmentCoordinator
+{
+public:
+    AlignmentCoordinator() = default;
+
+    /**
+     * 添加任务
+     * @returns false 如果已有 SIMPLEFOC_ALIGNMENT_MAX_JOBS 个任务
+     */
+    bool add(SensorAlignment* job);
+    /** 开始所有任务（最多 max_active 个同时运行） */
+    void start();
+    /**
+     * 所有正在运行的任务的一步 - 非阻塞
+     * @returns true 如果还有任务正在运行或排队
+     */
+    bool update();
+    /**
+     * 阻塞运行所有任务直到完成
+     * @returns 1 - 所有任务成功 & 0 - 至少一个任务失败
+     */
+    int run();
+    /** 失败的任务数 */
+    int failed();
+
+    uint8_t max_active = SIMPLEFOC_ALIGNMENT_MAX_JOBS; //!< 同时运行的最大任务数 - 0 不限制
+    bool abort_on_error = true; //!< 一个任务失败时中止所有任务
+
+protected:
+    SensorAlignment* jobs[SIMPLEFOC_ALIGNMENT_MAX_JOBS]; //!< 任务
+    uint8_t count = 0; //!< 任务数
+    uint8_t started = 0; //!< 已启动的任务数（按添加顺序）
+};
+
+#endif // SENSOR_ALIGNMENT_H
@@ -0,0 +1,159 @@
+#include "setpoint_queue.h"
+
+#define _SETPOINT_QUEUE_MASK (SIMPLEFOC_SETPOINT_QUEUE_SIZE - 1)
+
+// 索引访问 - acquire 读取保证之后的槽位访问不会提前，release 写入保证之前的槽位访问已经完成
+#ifdef SIMPLEFOC_SETPOINT_QUEUE_ATOMIC
+static inline uint8_t _loadAcquire(std::atomic<uint8_t>& index){ return index.load(std::memory_order_acquire); }
+static inline uint8_t _loadRelaxed(std::atomic<uint8_t>& index){ return index.load(std::memory_order_relaxed); }
+static inline void _storeRelease(std::atomic<uint8_t>& index, uint8_t value){ index.store(value, std::memory_order_release); }
+#else
+#if defined(__AVR__)
+// 单核 - 只需要阻止编译器重排
+#define _SETPOINT_QUEUE_BARRIER() __asm__ __volatile__("" ::: "memory")
+#else
+#define _SETPOINT_QUEUE_BARRIER() __sync_synchronize()
+#endif
+static inline uint8_t _loadAcquire(volatile uint8_t& index){ uint8_t value = index; _SETPOINT_QUEUE_BARRIER(); return value; }
+static inline uint8_t _loadRelaxed(volatile uint8_t& index){ return index; }
+static inline void _storeRelease(volatile uint8_t& index, uint8_t value){ _SETPOINT_QUEUE_BARRIER(); index = value; }
+#endif
+
+// 设定点队列构造函数
+SetpointQueue::SetpointQueue(SetpointInterpolation _interpolation, unsigned long _playback_delay)
+    : interpolation(_interpolation)   // 插值类型
+    , playback_delay(_playback_delay) // 回放延迟 [us]
+{
+    prev.timestamp = 0;
+    prev.value = 0;
+    prev2 = prev;
+}
+
+// 添加设定点 - 生产者端
+// 只修改 head，因此可以从中断或 Commander 回调中安全调用
+bool SetpointQueue::push(float value, unsigned long timestamp){
+    uint8_t h = _loadRelaxed(head);
+    uint8_t next = (h + 1) & _SETPOINT_QUEUE_MASK;
+    // 队列已满 - 丢弃新样本，消费者拥有 tail
+    // acquire - 消费者读完槽位之后才能覆盖它
+    if(next == _loadAcquire(tail)){
+        overruns++;
+        return false;
+    }
+    buffer[h].timestamp = timestamp;
+    buffer[h].value = value;
+    // release - 写入数据后再发布索引
+    _storeRelease(head, next);
+    return true;
+}
+
+// 使用本地接收时间添加设定点
+bool SetpointQueue::push(float value){
+    return push(value, _micros());
+}
+
+// 队列中的设定点数量
+uint8_t SetpointQueue::available(){
+    return (_loadRelaxed(head) - _loadRelaxed(tail)) & _SETPOINT_QUEUE_MASK;
+}
+
+// 清空队列 - 消费者端
+void SetpointQueue::reset(){
+    _storeRelease(tail, _loadAcquire(head));
+    history = 0;
+    synced = false;
+    underrun = false;
+    velocity = 0;
+}
+
+// 在本地时间 now_us 插值设定点 - 消费者端
+float SetpointQueue::operator() (unsigned long now_us, float current){
+    // 消费者端的索引快照 - acquire 保证 head 之前的槽位已经写入
+    uint8_t t_idx = _loadRelaxed(tail);
+    uint8_t h_idx = _loadAcquire(head);
+
+    // 欠载后新样本已经过时 - 流重新开始，重新同步时间
+    if(underrun && t_idx != h_idx && (long)(now_us - time_offset - buffer[t_idx].timestamp) >= 0)
+        synced = false;
+
+    // 将主机时间映射到本地时间 - 第一个样本在 playback_delay 之后回放
+    if(!synced){
+        if(t_idx == h_idx) return history ? prev.value : current;
+        time_offset = (long)(now_us - buffer[t_idx].timestamp) + (long)playback_delay;
+        synced = true;
+    }
+    // 主机时间基准中的回放时间
+    unsigned long t = now_us - time_offset;
+
+    // 弹出所有已经到期的设定点
+    while(t_idx != h_idx && (long)(t - buffer[t_idx].timestamp) >= 0){
+        prev2 = prev;
+        prev = buffer[t_idx];
+        if(history < 2) history++;
+        t_idx = (t_idx + 1) & _SETPOINT_QUEUE_MASK;
+    }
+    // release - 弹出的槽位读取完成后才交还给生产者
+    _storeRelease(tail, t_idx);
+
+    // 第一个设定点尚未到期 - 保持当前值
+    if(!history) return current;
+
+    // 没有未来的设定点 - 欠载，保持最后一个设定点
+    if(t_idx == h_idx){
+        if(!underrun) underruns++;
+        underrun = true;
+        velocity = 0;
+        return prev.value;
+    }
+    underrun = false;
+
+    // 插值区间 [prev, p1]
+    Setpoint_s p1 = buffer[t_idx];
+    float h = (float)(long)(p1.timestamp - prev.timestamp);
+    if(h <= 0){
+        velocity = 0;
+        return p1.value;
+    }
+    float s = (float)(long)(t - prev.timestamp) / h;
+    // 割线斜率 [单位/us]
+    float m = (p1.value - prev.value) / h;
+
+    switch(interpolation){
+        case SetpointInterpolation::setpoint_hold:
+            velocity = 0;
+            return prev.value;
+        case SetpointInterpolation::setpoint_linear:
+            velocity = m * 1e6f;
+            return prev.value + (p1.value - prev.value) * s;
+        case SetpointInterpolation::setpoint_cubic:
+        default:
+            break;
+    }
+
+    // Catmull-Rom 切线 - 如果相邻点不可用则使用割线斜率
+    float m0 = m, m1 = m;
+    if(history > 1){
+        float h0 = (float)(long)(p1.timestamp - prev2.timestamp);
+        if(h0 > 0) m0 = (p1.value - prev2.value) / h0;
+    }
+    uint8_t i2 = (t_idx + 1) & _SETPOINT_QUEUE_MASK;
+    if(i2 != h_idx){
+        float h1 = (float)(long)(buffer[i2].timestamp - prev.timestamp);
+        if(h1 > 0) m1 = (buffer[i2].value - prev.value) / h1;
+    }
+
+    // 三次Hermite基函数
+    float s2 = s * s;
+    float s3 = s2 * s;
+    float h00 = 2.0f * s3 - 3.0f * s2 + 1.0f;
+    float h10 = s3 - 2.0f * s2 + s;
+    float h01 = -2.0f * s3 + 3.0f * s2;
+    float h11 = s3 - s2;
+    // 导数 d/dt = d/ds / h
+    float dh00 = 6.0f * s2 - 6.0f * s;
+    float dh10 = 3.0f * s2 - 4.0f * s + 1.0f;
+    float dh11 = 3.0f * s2 - 2.0f * s;
+    velocity = (dh00 * (prev.value - p1.value) / h + dh10 * m0 + dh11 * m1) * 1e6f;
+
+    return h00 * prev.value + h10 * h * m0 + h01 * p1.value + h11 * h * m1;
+}
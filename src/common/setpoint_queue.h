@@ -0,0 +1,106 @@
+#ifndef SETPOINT_QUEUE_H
+#define SETPOINT_QUEUE_H
+
+#include "time_utils.h"
+#include "foc_utils.h"
+
+// 生产者和消费者可能运行在不同的核心上 (DualCoreRuntime) - 索引使用 acquire/release 语义
+#if defined(ARDUINO_ARCH_ESP32) || defined(TARGET_RP2040) || defined(ARDUINO_ARCH_RP2040)
+#include <atomic>
+#define SIMPLEFOC_SETPOINT_QUEUE_ATOMIC
+#endif
+
+// 设定点队列容量 - 必须是2的幂
+#ifndef SIMPLEFOC_SETPOINT_QUEUE_SIZE
+#define SIMPLEFOC_SETPOINT_QUEUE_SIZE 16
+#endif
+// 索引为 uint8_t - 容量最大256
+static_assert(SIMPLEFOC_SETPOINT_QUEUE_SIZE >= 2 && (SIMPLEFOC_SETPOINT_QUEUE_SIZE & (SIMPLEFOC_SETPOINT_QUEUE_SIZE - 1)) == 0 && SIMPLEFOC_SETPOINT_QUEUE_SIZE <= 256,
+              "SIMPLEFOC_SETPOINT_QUEUE_SIZE must be a power of 2 between 2 and 256");
+
+/**
+ *  设定点插值类型
+ */
+enum SetpointInterpolation : uint8_t {
+  setpoint_hold   = 0x00,     //!< 保持最近的设定点（阶跃）
+  setpoint_linear = 0x01,     //!< 相邻设定点之间线性插值
+  setpoint_cubic  = 0x02,     //!< 三次Hermite插值（Catmull-Rom切线）
+};
+
+/**
+ *  带时间戳的设定点
+ */
+struct Setpoint_s
+{
+    unsigned long timestamp; //!< 主机时间戳 [us]
+    float value; //!< 设定点值
+};
+
+/**
+ *  带时间戳的设定点FIFO
+ *
+ *  - 单生产者（Commander、中断）/ 单消费者（move()）无锁环形缓冲区
+ *  - 主机以较粗的速率发送带时间戳的设定点，队列在 move() 速率下插值
+ *  - 主机时间在第一个样本（或欠载后）映射到本地时间，并加上 playback_delay 作为抖动缓冲
+ */
+class SetpointQueue
+{
+public:
+    /**
+     * @param interpolation - 插值类型
+     * @param playback_delay - 回放延迟 [us] - 应大于主机发送周期加上通信抖动
+     */
+    SetpointQueue(SetpointInterpolation interpolation = SetpointInterpolation::setpoint_linear, unsigned long playback_delay = 20000);
+    ~SetpointQueue() = default; // 默认析构函数
+
+    /**
+     * 添加设定点（生产者端）
+     * @param value - 设定点值
+     * @param timestamp - 主机时间戳 [us]
+     * @returns 如果队列已满（溢出）返回 false
+     */
+    bool push(float value, unsigned long timestamp);
+    /**
+     * 添加没有主机时间戳的设定点 - 使用本地接收时间
+     * @param value - 设定点值
+     */
+    bool push(float value);
+
+    /**
+     * 计算给定本地时间的插值设定点（消费者端）
+     * @param now_us - 本地时间 [us]
+     * @param current - 队列为空时返回的值（通常是当前目标值）
+     */
+    float operator() (unsigned long now_us, float current);
+
+    /** 清空队列并重新同步时间 - 仅在消费者端调用 */
+    void reset();
+    /** 队列中的设定点数量 */
+    uint8_t available();
+
+    SetpointInterpolation interpolation; //!< 插值类型
+    unsigned long playback_delay; //!< 回放延迟 [us]
+    float velocity = 0; //!< 插值轨迹的导数 [单位/s] - 可以用作前馈
+
+    volatile unsigned long underruns = 0; //!< 欠载计数 - 回放时间超过最后一个设定点
+    volatile unsigned long overruns = 0; //!< 溢出计数 - 队列已满时丢弃的设定点
+
+protected:
+    Setpoint_s buffer[SIMPLEFOC_SETPOINT_QUEUE_SIZE]; //!< 环形缓冲区
+#ifdef SIMPLEFOC_SETPOINT_QUEUE_ATOMIC
+    std::atomic<uint8_t> head{0}; //!< 写索引 - 仅由生产者修改
+    std::atomic<uint8_t> tail{0}; //!< 读索引 - 仅由消费者修改
+#else
+    volatile uint8_t head = 0; //!< 写索引 - 仅由生产者修改
+    volatile uint8_t tail = 0; //!< 读索引 - 仅由消费者修改
+#endif
+
+    Setpoint_s prev; //!< 最近弹出的设定点 - 插值起点
+    Setpoint_s prev2; //!< 倒数第二个弹出的设定点 - 三次插值的切线
+    uint8_t history = 0; //!< 有效的已弹出设定点数量 (0-2)
+    bool synced = false; //!< 主机时间是否已映射到本地时间
+    bool underrun = false; //!< 当前是否处于欠载状态
+    long time_offset = 0; //!< 主机时间 = 本地时间 - time_offset
+};
+
+#endif // SETPOINT_QUEUE_H
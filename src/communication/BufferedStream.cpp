@@ -0,0 +1,99 @@
+#include "BufferedStream.h"
+
+#define _RX_MASK (SIMPLEFOC_STREAM_RX_SIZE - 1)
+#define _TX_MASK (SIMPLEFOC_STREAM_TX_SIZE - 1)
+
+BufferedStream::BufferedStream(Stream &port, bool poll_rx){
+  this->port = &port;
+  this->poll_rx = poll_rx;
+}
+
+void BufferedStream::update(){
+  // receive - bounded number of bytes from the wrapped stream
+  if (poll_rx) {
+    int n = port->available();
+    if (n > max_bytes) n = max_bytes;
+    while (n-- > 0) receive((uint8_t)port->read());
+  }
+  // transmit - only as much as the wrapped stream accepts without blocking
+  int space = port->availableForWrite();
+  if (space > 0) tx_space_reported = true;
+  // streams not implementing availableForWrite() always report 0 - write fixed chunks (may block)
+  else if (!tx_space_reported) space = tx_chunk;
+  drain(space < max_bytes ? space : max_bytes);
+}
+
+void BufferedStream::drain(int max){
+  while (max > 0 && tx_tail != tx_head) {
+    // write the contiguous part of the ring at once
+    int n = (tx_head > tx_tail ? tx_head : SIMPLEFOC_STREAM_TX_SIZE) - tx_tail;
+    if (n > max) n = max;
+    port->write(&tx_buffer[tx_tail], n);
+    tx_tail = (tx_tail + n) & _TX_MASK;
+    max -= n;
+  }
+}
+
+bool BufferedStream::receive(uint8_t byte){
+  uint16_t next = (rx_head + 1) & _RX_MASK;
+  if (next == rx_tail) {
+    rx_overruns++;
+    return false;
+  }
+  rx_buffer[rx_head] = byte;
+  // publish the index after the data
+  rx_head = next;
+  return true;
+}
+
+int BufferedStream::receive(const uint8_t* data, int length){
+  int i = 0;
+  while (i < length && receive(data[i])) i++;
+  return i;
+}
+
+int BufferedStream::available(){
+  return (rx_head - rx_tail) & _RX_MASK;
+}
+
+int BufferedStream::read(){
+  if (rx_tail == rx_head) return -1;
+  uint8_t byte = rx_buffer[rx_tail];
+  rx_tail = (rx_tail + 1) & _RX_MASK;
+  return byte;
+}
+
+int BufferedStream::peek(){
+  if (rx_tail == rx_head) return -1;
+  return rx_buffer[rx_tail];
+}
+
+size_t BufferedStream::write(uint8_t byte){
+  uint16_t next = (tx_head + 1) & _TX_MASK;
+  if (next == tx_tail) {
+    tx_overruns++;
+    return 0;
+  }
+  tx_buffer[tx_head] = byte;
+  tx_head = next;
+  return 1;
+}
+
+size_t BufferedStream::write(const uint8_t* data, size_t length){
+  size_t n = 0;
+  while (n < length && ((tx_head + 1) & _TX_MASK) != tx_tail) {
+    tx_buffer[tx_head] = data[n++];
+    tx_head = (tx_head + 1) & _TX_MASK;
+  }
+  tx_overruns += length - n;
+  return n;
+}
+
+int BufferedStream::availableForWrite(){
+  return (tx_tail - tx_head - 1) & _TX_MASK;
+}
+
+void BufferedStream::flush(){
+  while (tx_tail != tx_head) drain(SIMPLEFOC_STREAM_TX_SIZE);
+  port->flush();
+}
@@ -0,0 +1,94 @@
+#ifndef BUFFERED_STREAM_H
+#define BUFFERED_STREAM_H
+
+#include "Arduino.h"
+
+// receive and transmit ring sizes - must be powers of 2
+#ifndef SIMPLEFOC_STREAM_RX_SIZE
+#define SIMPLEFOC_STREAM_RX_SIZE 128
+#endif
+#ifndef SIMPLEFOC_STREAM_TX_SIZE
+#define SIMPLEFOC_STREAM_TX_SIZE 256
+#endif
+// uint16_t indexes - at most 65536 bytes
+static_assert(SIMPLEFOC_STREAM_RX_SIZE >= 2 && (SIMPLEFOC_STREAM_RX_SIZE & (SIMPLEFOC_STREAM_RX_SIZE - 1)) == 0 && SIMPLEFOC_STREAM_RX_SIZE <= 65536,
+              "SIMPLEFOC_STREAM_RX_SIZE must be a power of 2 between 2 and 65536");
+static_assert(SIMPLEFOC_STREAM_TX_SIZE >= 2 && (SIMPLEFOC_STREAM_TX_SIZE & (SIMPLEFOC_STREAM_TX_SIZE - 1)) == 0 && SIMPLEFOC_STREAM_TX_SIZE <= 65536,
+              "SIMPLEFOC_STREAM_TX_SIZE must be a power of 2 between 2 and 65536");
+
+/**
+ * Non-blocking Stream with receive and transmit ring buffers
+ *
+ *  - The receive ring is filled either by an ISR/DMA callback with receive() or by update() from the wrapped stream
+ *  - Everything written to the stream (ex. Commander replies) goes to the transmit ring
+ *    which is drained to the wrapped stream by update() - writing never blocks, bytes are dropped if the ring is full
+ *  - update() moves a bounded number of bytes per call so it can be called in between the loopFOC() calls
+ *
+ * Example:
+ *    BufferedStream buffered(Serial);
+ *    Commander command(buffered);
+ *    loop(){ motor.loopFOC(); buffered.update(); command.run(); }
+ */
+class BufferedStream : public Stream
+{
+  public:
+    /**
+     * @param port - wrapped stream (ex. Serial) - the transmit ring is written to it
+     * @param poll_rx - read the wrapped stream in update() - set to false if the receive ring is filled by receive()
+     */
+    BufferedStream(Stream &port, bool poll_rx = true);
+
+    /**
+     * Move the received bytes from the wrapped stream to the receive ring (if polling)
+     * and drain the transmit ring to the wrapped stream
+     *  - at most max_bytes in each direction
+     *  - transmit is limited to the availableForWrite() of the wrapped stream - it does not block
+     *  - if the wrapped stream never reported any space (availableForWrite() not implemented, always 0)
+     *    tx_chunk bytes are written per call instead - the write may block then
+     */
+    void update();
+
+    /**
+     * Add a received byte - producer side, safe to call from the UART ISR
+     * @returns false if the receive ring is full (byte dropped)
+     */
+    bool receive(uint8_t byte);
+    /**
+     * Add a block of received bytes - ex. from the DMA half/full transfer callback
+     * @returns number of bytes added
+     */
+    int receive(const uint8_t* data, int length);
+
+    // Stream interface
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t byte) override;
+    size_t write(const uint8_t* data, size_t length) override;
+    int availableForWrite() override;
+    using Print::write;
+    /** drain the transmit ring completely - blocking */
+    void flush() override;
+
+    uint16_t max_bytes = 32; //!< maximal number of bytes moved by update() in each direction
+    uint16_t tx_chunk = 16; //!< bytes written by update() to a stream not implementing availableForWrite() (0 - none)
+    bool poll_rx; //!< read the wrapped stream in update()
+    volatile unsigned long rx_overruns = 0; //!< bytes dropped because the receive ring was full
+    unsigned long tx_overruns = 0; //!< bytes dropped because the transmit ring was full
+
+  protected:
+    Stream* port; //!< wrapped stream
+
+    uint8_t rx_buffer[SIMPLEFOC_STREAM_RX_SIZE]; //!< receive ring
+    volatile uint16_t rx_head = 0; //!< receive write index - producer (ISR)
+    volatile uint16_t rx_tail = 0; //!< receive read index - consumer (Commander)
+    uint8_t tx_buffer[SIMPLEFOC_STREAM_TX_SIZE]; //!< transmit ring
+    uint16_t tx_head = 0; //!< transmit write index
+    uint16_t tx_tail = 0; //!< transmit read index
+    bool tx_space_reported = false; //!< the wrapped stream reported free space at least once - availableForWrite() is implemented
+
+    /** write at most max bytes of the transmit ring to the wrapped stream */
+    void drain(int max);
+};
+
+#endif
@@ -30,10 +30,46 @@ void Commander::run(Stream& serial, char eol){
   this->eol = eol;
   com_port = &serial;
 
+  // bounded work per call - at most max_bytes_per_run bytes and one executed command
+  unsigned int budget = max_bytes_per_run;
   // a string to hold incoming data
   while (serial.available()) {
+    if (max_bytes_per_run && !budget--) break;
     // get the new byte:
     int ch = serial.read();
+    // binary frame delimiter - never appears in the string commands
+    if (ch == 0) {
+      // end of the oversized frame - the next 0x00 starts a new one
+      if (discard) {
+        discard = false;
+        continue;
+      }
+      // end of the binary frame - execute it
+      bool executed = binary && rec_cnt;
+      if (executed) {
+        run((uint8_t*)received_chars, rec_cnt);
+        binary = false;
+      }else{
+        // start of the binary frame - discard the incomplete string command
+        binary = true;
+      }
+      received_chars[0] = 0;
+      rec_cnt = 0;
+      if (executed) break;
+      continue;
+    }
+    // rest of the oversized frame - never executed as string commands
+    if (discard) continue;
+    if (binary) {
+      received_chars[rec_cnt++] = (char)ch;
+      if (rec_cnt >= MAX_FRAME_LENGTH) { // prevent buffer overrun if frame is too long
+        frame_errors++;
+        binary = false;
+        discard = true;
+        rec_cnt = 0;
+      }
+      continue;
+    }
     received_chars[rec_cnt++] = (char)ch;
     // end of user input
     if(echo)
@@ -45,6 +81,7 @@ void Commander::run(Stream& serial, char eol){
       // reset the command buffer
       received_chars[0] = 0;
       rec_cnt=0;
+      break;
     }
     if (rec_cnt>=MAX_COMMAND_LENGTH) { // prevent buffer overrun if message is too long
         received_chars[0] = 0;
@@ -95,6 +132,7 @@ void Commander::run(char* user_input){
     default:
       for(int i=0; i < call_count; i++){
         if(id == call_ids[i]){
+          call_id = id;
           printMachineReadable(user_input[0]);
           call_list[i](&user_input[1]);
           break;
@@ -104,6 +142,144 @@ void Commander::run(char* user_input){
   }
 }
 
+int Commander::addMotor(FOCMotor* motor){
+  if (motor_count >= MAX_BINARY_MOTORS) return -1;
+  motors[motor_count] = motor;
+  return motor_count++;
+}
+
+void Commander::run(uint8_t* frame, int length){
+  // decode in place and verify the checksum
+  length = cobsDecode(frame, length);
+  if (length < 3 || crc16(frame, length - 2) != (uint16_t)(frame[length-2] | (frame[length-1] << 8))) {
+    frame_errors++;
+    return;
+  }
+  length -= 2;
+  if (length > (int)sizeof(received_chars)) {
+    frame_errors++;
+    return;
+  }
+
+  // reply - sequence number, status for each operation (+ value for reads) and the checksum
+  // built in the received message buffer - the frame is moved to its end and the reply,
+  // written from the start, is never allowed to overtake the operation being parsed
+  uint8_t* reply = (uint8_t*)received_chars;
+  int offset = (int)sizeof(received_chars) - length;
+  memmove(reply + offset, frame, length);
+  frame = reply + offset;
+  int reply_len = 0;
+  reply[reply_len++] = frame[0];
+
+  int i = 1;
+  while (i < length) {
+    uint8_t op = frame[i] & BIN_OP_MASK;
+    uint8_t index = frame[i] & ~BIN_OP_MASK;
+    int op_len = (op == BIN_OP_WRITE) ? 7 : (op == BIN_OP_READ_ID) ? 2 : (op == BIN_OP_WRITE_ID) ? 6 : 3;
+    // truncated operation - stop parsing
+    if (i + op_len > length || reply_len + 5 > (int)sizeof(received_chars) - 2 || reply_len + 5 > offset + i) {
+      reply[reply_len++] = BIN_STATUS_ERR;
+      break;
+    }
+    FOCMotor* motor = (index < motor_count) ? motors[index] : nullptr;
+    char cmd = (char)frame[i+1];
+    char sub_cmd = (char)frame[i+2];
+    float value;
+    switch (op) {
+      case BIN_OP_READ:
+        if (motor && readRegister(motor, cmd, sub_cmd, &value)) {
+          reply[reply_len++] = BIN_STATUS_OK;
+          memcpy(&reply[reply_len], &value, 4);
+          reply_len += 4;
+        } else {
+          reply[reply_len++] = BIN_STATUS_ERR;
+        }
+        break;
+      case BIN_OP_WRITE:
+        memcpy(&value, &frame[i+3], 4);
+        reply[reply_len++] = (motor && writeRegister(motor, cmd, sub_cmd, value)) ? BIN_STATUS_OK : BIN_STATUS_ERR;
+        break;
+      case BIN_OP_READ_ID:
+        if (motor && RegisterMap::read(motor, frame[i+1], &value)) {
+          reply[reply_len++] = BIN_STATUS_OK;
+          memcpy(&reply[reply_len], &value, 4);
+          reply_len += 4;
+        } else {
+          reply[reply_len++] = BIN_STATUS_ERR;
+        }
+        break;
+      case BIN_OP_WRITE_ID:
+        memcpy(&value, &frame[i+2], 4);
+        reply[reply_len++] = (motor && RegisterMap::write(motor, frame[i+1], value)) ? BIN_STATUS_OK : BIN_STATUS_ERR;
+        break;
+      default:
+        reply[reply_len++] = BIN_STATUS_ERR;
+        op_len = length; // unknown opcode - the rest of the frame cannot be parsed
+        break;
+    }
+    i += op_len;
+  }
+
+  uint16_t crc = crc16(reply, reply_len);
+  reply[reply_len++] = crc & 0xFF;
+  reply[reply_len++] = crc >> 8;
+  writeFrame(reply, reply_len);
+}
+
+bool Commander::readRegister(FOCMotor* motor, char cmd, char sub_cmd, float* value){
+  RegisterEntry entry;
+  if (!RegisterMap::entry(RegisterMap::find(cmd, sub_cmd), &entry)) return false;
+  if (!RegisterMap::read(motor, entry, value)) return false;
+  // optional parameters not set are read as 0
+  if ((entry.access & REGISTER_OPTIONAL) && !_isset(*value)) *value = 0;
+  return true;
+}
+
+bool Commander::writeRegister(FOCMotor* motor, char cmd, char sub_cmd, float value){
+  RegisterEntry entry;
+  if (!RegisterMap::entry(RegisterMap::find(cmd, sub_cmd), &entry)) return false;
+  return RegisterMap::write(motor, entry, value);
+}
+
+int Commander::cobsDecode(uint8_t* buffer, int length){
+  // the decoded frame is never longer than the encoded one - decode in place
+  int read = 0, write = 0;
+  while (read < length) {
+    uint8_t code = buffer[read++];
+    if (code == 0 || read + code - 1 > length) return 0; // invalid frame
+    for (uint8_t i = 1; i < code; i++) buffer[write++] = buffer[read++];
+    if (code != 0xFF && read < length) buffer[write++] = 0;
+  }
+  return write;
+}
+
+uint16_t Commander::crc16(const uint8_t* data, int length){
+  uint16_t crc = 0xFFFF;
+  for (int i = 0; i < length; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (uint8_t b = 0; b < 8; b++)
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+  }
+  return crc;
+}
+
+void Commander::writeFrame(const uint8_t* data, int length){
+  if (!com_port) return;
+  com_port->write((uint8_t)0);
+  // COBS encoding - each block is prefixed with the distance to the next zero
+  int start = 0;
+  while (start <= length) {
+    int end = start;
+    while (end < length && data[end] != 0 && end - start < 254) end++;
+    com_port->write((uint8_t)(end - start + 1));
+    com_port->write(&data[start], end - start);
+    // block of 254 non-zero bytes has no implicit zero
+    if (end - start == 254 && end < length) start = end;
+    else start = end + 1;
+  }
+  com_port->write((uint8_t)0);
+}
+
 void Commander::motor(FOCMotor* motor, char* user_command) {
 
   // if target setting
@@ -128,148 +304,41 @@ void Commander::motor(FOCMotor* motor, char* user_command) {
 
   // a bit of optimisation of variable memory for Arduino UNO (atmega328)
   switch(cmd){
-    case CMD_C_Q_PID:      //
-      printVerbose(F("PID curr q| "));
-      if(sub_cmd == SCMD_LPF_TF) lpf(&motor->LPF_current_q, &user_command[1]);
-      else pid(&motor->PID_current_q,&user_command[1]);
-      break;
-    case CMD_C_D_PID:      //
-      printVerbose(F("PID curr d| "));
-      if(sub_cmd == SCMD_LPF_TF) lpf(&motor->LPF_current_d, &user_command[1]);
-      else pid(&motor->PID_current_d, &user_command[1]);
-      break;
-    case CMD_V_PID:      //
-      printVerbose(F("PID vel| "));
-      if(sub_cmd == SCMD_LPF_TF) lpf(&motor->LPF_velocity, &user_command[1]);
-      else pid(&motor->PID_velocity, &user_command[1]);
-      break;
-    case CMD_A_PID:      //
-      printVerbose(F("PID angle| "));
-      if(sub_cmd == SCMD_LPF_TF) lpf(&motor->LPF_angle, &user_command[1]);
-      else pid(&motor->P_angle, &user_command[1]);
-      break;
-    case CMD_LIMITS:      //
-     printVerbose(F("Limits| "));
-      switch (sub_cmd){
-        case SCMD_LIM_VOLT:      // voltage limit change
-          printVerbose(F("volt: "));
-          if(!GET) {
-            motor->voltage_limit = value;
-            motor->PID_current_d.limit = value;
-            motor->PID_current_q.limit = value;
-            // change velocity pid limit if in voltage mode and no phase resistance set
-            if( !_isset(motor->phase_resistance) && motor->torque_controller==TorqueControlType::voltage) motor->PID_velocity.limit = value;
-          }
-          println(motor->voltage_limit);
-          break;
-        case SCMD_LIM_CURR:      // current limit
-          printVerbose(F("curr: "));
-          if(!GET){
-            motor->current_limit = value;
-            // if phase resistance specified or the current control is on set the current limit to the velocity PID
-            if(_isset(motor->phase_resistance) || motor->torque_controller != TorqueControlType::voltage ) motor->PID_velocity.limit = value;
-          }
-          println(motor->current_limit);
-          break;
-        case SCMD_LIM_VEL:      // velocity limit
-          printVerbose(F("vel: "));
-          if(!GET){
-            motor->velocity_limit = value;
-            motor->P_angle.limit = value;
-          }
-          println(motor->velocity_limit);
-          break;
-        default:
-          printError();
-          break;
-      }
-      break;
     case CMD_MOTION_TYPE:
     case CMD_TORQUE_TYPE:
     case CMD_STATUS:
       motion(motor, &user_command[0]);
       break;
     case CMD_PWMMOD:
-       // PWM modulation change
-       printVerbose(F("PWM Mod | "));
-       switch (sub_cmd){
-        case SCMD_PWMMOD_TYPE:      // zero offset
-          printVerbose(F("type: "));
-          if(!GET) motor->foc_modulation = (FOCModulationType)value;
-          switch(motor->foc_modulation){
-            case FOCModulationType::SinePWM:
-              println(F("SinePWM"));
-              break;
-            case FOCModulationType::SpaceVectorPWM:
-              println(F("SVPWM"));
-              break;
-            case FOCModulationType::Trapezoid_120:
-              println(F("Trap 120"));
-              break;
-            case FOCModulationType::Trapezoid_150:
-              println(F("Trap 150"));
-              break;
-          }
+      if(sub_cmd != SCMD_PWMMOD_TYPE){
+        motorRegister(motor, cmd, sub_cmd, value, GET);
+        break;
+      }
+      // PWM modulation change
+      printVerbose(F("PWM Mod | type: "));
+      if(!GET) writeRegister(motor, cmd, sub_cmd, value);
+      switch(motor->foc_modulation){
+        case FOCModulationType::SinePWM:
+          println(F("SinePWM"));
           break;
-        case SCMD_PWMMOD_CENTER:      // centered modulation
-          printVerbose(F("center: "));
-          if(!GET) motor->modulation_centered = value;
-          println(motor->modulation_centered);
+        case FOCModulationType::SpaceVectorPWM:
+          println(F("SVPWM"));
           break;
-        default:
-          printError();
+        case FOCModulationType::Trapezoid_120:
+          println(F("Trap 120"));
+          break;
+        case FOCModulationType::Trapezoid_150:
+          println(F("Trap 150"));
           break;
-       }
-      break;
-    case CMD_RESIST:
-      printVerbose(F("R phase: "));
-      if(!GET){
-        motor->phase_resistance = value;
-        if(motor->torque_controller==TorqueControlType::voltage)
-          motor->PID_velocity.limit= motor->current_limit;
       }
-      if(_isset(motor->phase_resistance)) println(motor->phase_resistance);
-      else println(0);
       break;
-    case CMD_INDUCTANCE:
-      printVerbose(F("L phase: "));
-      if(!GET){
-        motor->phase_inductance = value;
-      }
-      if(_isset(motor->phase_inductance)) println(motor->phase_inductance);
-      else println(0);
-      break;
-    case CMD_KV_RATING:
-      printVerbose(F("Motor KV: "));
-      if(!GET){
-        motor->KV_rating = value;
-      }
-      if(_isset(motor->KV_rating)) println(motor->KV_rating);
-      else println(0);
-      break;
-    case CMD_SENSOR:
-      // Sensor zero offset
-       printVerbose(F("Sensor | "));
-       switch (sub_cmd){
-        case SCMD_SENS_MECH_OFFSET:      // zero offset
-          printVerbose(F("offset: "));
-          if(!GET) motor->sensor_offset = value;
-          println(motor->sensor_offset);
-          break;
-        case SCMD_SENS_ELEC_OFFSET:      // electrical zero offset - not suggested to touch
-          printVerbose(F("el. offset: "));
-          if(!GET) motor->zero_electric_angle = value;
-          println(motor->zero_electric_angle);
-          break;
-        default:
-          printError();
-          break;
-       }
+    case CMD_CONFIG:
+      motorConfig(motor);
       break;
     case CMD_MONITOR:     // get current values of the state variables
-      printVerbose(F("Monitor | "));
       switch (sub_cmd){
         case SCMD_GET:      // get command
+          printVerbose(F("Monitor | "));
           switch((uint8_t)value){
             case 0: // get target
               printVerbose(F("target: "));
@@ -320,21 +389,13 @@ void Commander::motor(FOCMotor* motor, char* user_command) {
               break;
           }
           break;
-        case SCMD_DOWNSAMPLE:
-          printVerbose(F("downsample: "));
-          if(!GET) motor->monitor_downsample = value;
-          println((int)motor->monitor_downsample);
-          break;
         case SCMD_CLEAR:
+          printVerbose(F("Monitor | "));
           motor->monitor_variables = (uint8_t) 0;
           println(F("clear"));
           break;
-        case CMD_DECIMAL:
-          printVerbose(F("decimal: "));
-          motor->monitor_decimals = value;
-          println((int)motor->monitor_decimals);
-          break;
         case SCMD_SET:
+          printVerbose(F("Monitor | "));
           if(!GET){
             // set the variables
             motor->monitor_variables = (uint8_t) 0;
@@ -350,16 +411,71 @@ void Commander::motor(FOCMotor* motor, char* user_command) {
           println("");
           break;
         default:
-          printError();
+          motorRegister(motor, cmd, sub_cmd, value, GET);
           break;
        }
       break;
-    default:  // unknown cmd
-      printVerbose(F("unknown cmd "));
-      printError();
+    default:  // registers - PID & LPF, limits, motor parameters, sensor and current sense
+      motorRegister(motor, cmd, value_index == 2 ? sub_cmd : 0, value, GET);
+      break;
   }
 }
 
+void Commander::motorRegister(FOCMotor* motor, char cmd, char sub_cmd, float value, bool GET){
+  RegisterEntry entry;
+  if(!RegisterMap::entry(RegisterMap::find(cmd, sub_cmd), &entry) || (entry.sub_cmd && entry.sub_cmd != sub_cmd)){
+    printVerbose(F("unknown cmd "));
+    printError();
+    return;
+  }
+  printVerbose((const __FlashStringHelper*)entry.label);
+  printVerbose(F(": "));
+  // write first - failed write (out of range or not available) is an error
+  if(!GET && !RegisterMap::write(motor, entry, value)){
+    printError();
+    return;
+  }
+  if(!RegisterMap::read(motor, entry, &value)){
+    printError();
+    return;
+  }
+  // optional parameters not set are displayed as 0
+  if((entry.access & REGISTER_OPTIONAL) && !_isset(value)) println(0);
+  else{
+    printRegister(entry, value);
+    println("");
+  }
+}
+
+void Commander::motorConfig(FOCMotor* motor){
+  RegisterEntry entry;
+  float value;
+  // terminate the machine readable command echo - each register is printed on its own line
+  printlnMachineReadable("");
+  for(int i = 0; i < RegisterMap::count(); i++){
+    RegisterMap::entry(i, &entry);
+    if(!(entry.access & REGISTER_CONFIG)) continue;
+    // skip the registers not available for this motor (ex. no current sense linked)
+    if(!RegisterMap::read(motor, entry, &value)) continue;
+    if((entry.access & REGISTER_OPTIONAL) && !_isset(value)) continue;
+    print(call_id);
+    print(entry.cmd);
+    if(entry.sub_cmd) print(entry.sub_cmd);
+    if(entry.id == REGISTER_MONITOR_VARIABLES){
+      // monitored variables are set as a bit string
+      for(int b = 6; b >= 0; b--) print((int)((motor->monitor_variables >> b) & 1));
+    }else{
+      printRegister(entry, value);
+    }
+    println("");
+  }
+}
+
+void Commander::printRegister(const RegisterEntry& entry, float value){
+  if(entry.type == reg_float) print(value);
+  else print((int)value);
+}
+
 void Commander::motion(FOCMotor* motor, char* user_cmd, char* separator){
   char cmd = user_cmd[0];
   char sub_cmd = user_cmd[1];
@@ -372,13 +488,12 @@ void Commander::motion(FOCMotor* motor, char* user_cmd, char* separator){
       switch(sub_cmd){
         case SCMD_DOWNSAMPLE:
             printVerbose(F(" downsample: "));
-            if(!GET) motor->motion_downsample = value;
+            if(!GET) writeRegister(motor, cmd, sub_cmd, value);
             println((int)motor->motion_downsample);
           break;
         default:
           // change control type
-          if(!GET && value >= 0 && (int)value < 5) // if set command
-            motor->controller = (MotionControlType)value;
+          if(!GET) writeRegister(motor, cmd, 0, value); // if set command
           switch(motor->controller){
             case MotionControlType::torque:
               println(F("torque"));
@@ -402,30 +517,24 @@ void Commander::motion(FOCMotor* motor, char* user_cmd, char* separator){
     case CMD_TORQUE_TYPE:
       // change control type
       printVerbose(F("Torque: "));
-      if(!GET && (int8_t)value >= 0 && (int8_t)value < 3)// if set command
-        motor->torque_controller = (TorqueControlType)value;
+      // the velocity control limits are changed if necessary
+      if(!GET) writeRegister(motor, cmd, 0, value); // if set command
       switch(motor->torque_controller){
         case TorqueControlType::voltage:
           println(F("volt"));
-          // change the velocity control limits if necessary
-          if( !_isset(motor->phase_resistance) ) motor->PID_velocity.limit = motor->voltage_limit;
           break;
         case TorqueControlType::dc_current:
           println(F("dc curr"));
-          // change the velocity control limits if necessary
-          motor->PID_velocity.limit = motor->current_limit;
           break;
         case TorqueControlType::foc_current:
           println(F("foc curr"));
-          // change the velocity control limits if necessary
-          motor->PID_velocity.limit = motor->current_limit;
           break;
       }
       break;
     case CMD_STATUS:
       // enable/disable
       printVerbose(F("Status: "));
-      if(!GET) (bool)value ? motor->enable() : motor->disable();
+      if(!GET) writeRegister(motor, cmd, 0, (bool)value);
        println(motor->enabled);
       break;
     default:
@@ -585,6 +694,90 @@ void Commander::target(FOCMotor* motor,  char* user_cmd, char* separator){
   println(motor->target);
 }
 
+void Commander::setpoint(SetpointQueue* queue,  char* user_cmd, char* separator){
+  // if no values sent - display the queue state
+  if(isSentinel(user_cmd[0])) {
+    printVerbose(F("Queue: "));
+    print((int)queue->available());
+    print(";");
+    print((int)queue->underruns);
+    print(";");
+    println((int)queue->overruns);
+    return;
+  }
+
+  float value = atof(strtok (user_cmd, separator));
+  char* next_value = strtok (NULL, separator);
+  bool ok;
+  // host timestamp in microseconds - if not provided use the reception time
+  if (next_value) ok = queue->push(value, strtoul(next_value, NULL, 10));
+  else ok = queue->push(value);
+  if(!ok) printError();
+}
+
+
+void Commander::frequencyResponse(FrequencyResponse* fr, char* user_cmd, char* separator){
+  char cmd = user_cmd[0];
+  // if no values sent - display the sweep progress
+  if(isSentinel(cmd)) {
+    printVerbose(F("FR: "));
+    print((int)fr->count);
+    print(";");
+    println((int)fr->points);
+    return;
+  }
+  bool GET  = isSentinel(user_cmd[1]);
+  float value = atof(&user_cmd[1]);
+
+  switch (cmd){
+    case SCMD_FR_TARGET:      // injection point
+      printVerbose(F("target: "));
+      if(!GET && !fr->running()) fr->target = (FrequencyResponseTarget)_constrain((int)value, 0, 2);
+      println((int)fr->target);
+      break;
+    case SCMD_FR_AMPLITUDE:   // perturbation amplitude
+      printVerbose(F("amplitude: "));
+      if(!GET) fr->amplitude = value;
+      println(fr->amplitude);
+      break;
+    case SCMD_FR_START: {     // start the sweep - f_start f_end points
+      char* f_start = strtok(&user_cmd[1], separator);
+      char* f_end = f_start ? strtok(NULL, separator) : NULL;
+      char* points = f_end ? strtok(NULL, separator) : NULL;
+      if(!points){
+        printError();
+        break;
+      }
+      fr->start(atof(f_start), atof(f_end), (uint8_t)atoi(points));
+      printVerbose(F("start: "));
+      println((int)fr->points);
+      break;
+    }
+    case SCMD_FR_STOP:        // stop the sweep
+      fr->stop();
+      printVerbose(F("stop: "));
+      println((int)fr->count);
+      break;
+    case SCMD_FR_GET:         // stream the new points
+      if(fr->reported >= fr->count){
+        println("");
+        break;
+      }
+      while(fr->reported < fr->count){
+        uint8_t i = fr->reported++;
+        print(fr->frequency[i]);
+        print(";");
+        print(fr->gain[i]);
+        print(";");
+        println(fr->phase[i]);
+      }
+      break;
+    default:
+      printError();
+      break;
+  }
+}
+
 
 bool Commander::isSentinel(char ch)
 {
@@ -5,10 +5,19 @@
 #include "../common/base_classes/FOCMotor.h"
 #include "../common/pid.h"
 #include "../common/lowpass_filter.h"
+#include "../common/setpoint_queue.h"
+#include "../common/frequency_response.h"
 #include "commands.h"
+#include "RegisterMap.h"
 
 
 #define MAX_COMMAND_LENGTH 20
+#ifndef MAX_FRAME_LENGTH
+#define MAX_FRAME_LENGTH 64 //!< maximal length of the (COBS encoded) binary frame
+#endif
+#define MAX_BINARY_MOTORS 4 //!< maximal number of motors addressable by the binary protocol
+// the shortest operation (2 bytes) has the longest reply (status and float, 5 bytes) + sequence number and checksum
+#define MAX_REPLY_LENGTH (1 + (MAX_FRAME_LENGTH / 2) * 5 + 2) //!< maximal length of the (decoded) binary reply
 
 
 // Commander verbose display to the user type
@@ -34,6 +43,13 @@ typedef void (* CommandCallback)(char*); //!< command callback function pointer
  *     - LowPassFilter
  *  - Commander also provides a very simple command > callback interface that enables user to
  *    attach a callback function to certain command id - see function add()
+ *  - Commander also implements a binary protocol for the motors added with addMotor(), coexisting with the string protocol
+ *     - frames are COBS encoded and delimited by 0x00 (which never appears in the string commands): 0x00 <frame> 0x00
+ *     - decoded frame: sequence number (1 byte), operations, CRC16-CCITT of the sequence number and operations (2 bytes, little endian)
+ *     - operation: opcode | motor index (1 byte), register address - the command and sub-command letters (2 bytes), 
+ *                  float value for writes (4 bytes, little endian)
+ *     - the registers can also be addressed with the numeric register id (1 byte, see RegisterMap.h) - BIN_OP_READ_ID/BIN_OP_WRITE_ID
+ *     - reply frame: sequence number, status (1 byte) for each operation followed by the float value for reads, CRC16
  */
 class Commander
 {
@@ -57,6 +73,8 @@ class Commander
      *    '@' - Verbose mode
      *    '#' - Number of decimal places
      *    '?' - Scan command - displays all the labels of attached nodes
+     *  - The work per call is bounded - it reads at most max_bytes_per_run bytes and executes at most one command,
+     *    the rest is handled in the next calls. Use BufferedStream to receive in the ISR/DMA and defer the replies.
      */
     void run();
     /**
@@ -93,6 +111,23 @@ class Commander
      */
     void add(char id , CommandCallback onCommand, const char* label = nullptr);
 
+    /**
+     *  Function adding a motor to the binary protocol
+     * @param motor - FOCMotor (BLDCMotor or StepperMotor) instance
+     * @returns motor index used in the binary operations or -1 if no more motors can be added
+     */
+    int addMotor(FOCMotor* motor);
+
+    /**
+     * Function executing one binary frame
+     *  - the frame is decoded in place and the reply is written to the com_port
+     *  - the reply is built in the received message buffer, no reply buffer on the stack
+     *
+     * @param frame  - COBS encoded frame, without the 0x00 delimiters
+     * @param length - frame length
+     */
+    void run(uint8_t* frame, int length);
+
     // printing variables
     VerboseMode verbose = VerboseMode::user_friendly; //!< flag signaling that the commands should output user understanable text
     uint8_t decimal_places = 3; //!< number of decimal places to be used when displaying numbers
@@ -101,6 +136,7 @@ class Commander
     Stream* com_port = nullptr; //!< Serial terminal variable if provided
     char eol = '\n'; //!< end of line sentinel character
     bool echo = false; //!< echo last typed character (for command line feedback)
+    unsigned int max_bytes_per_run = MAX_FRAME_LENGTH; //!< maximal number of bytes read by one run() call (0 - no limit)
 
     /**
      *
@@ -134,10 +170,34 @@ class Commander
      *          '0' - enable
      *          '1' - disable
      *    'R' - Motor resistance
+     *    'I' - Motor inductance
+     *    'K' - Motor KV rating
+     *    'P' - Motor pole pairs
+     *    'W' - PWM modulation
+     *          sub-commands:
+     *          'T' - modulation type
+     *          'C' - centered modulation
      *    'S' - Sensor offsets
      *          sub-commands:
      *          'M' - sensor offset
      *          'E' - sensor electrical zero
+     *          'D' - sensor direction
+     *          'A' - alignment voltage
+     *          'I' - index search velocity
+     *          'T' - velocity calculation minimal elapsed time
+     *    'G' - Current sense
+     *          sub-commands:
+     *          'A','B','C' - phase gains
+     *          'X','Y','Z' - phase offsets
+     *          'S' - skip alignment
+     *    'F' - Field weakening & MTPA (if linked)
+     *          sub-commands:
+     *          'M' - voltage margin
+     *          'I' - integral gain
+     *          'L' - d current limit
+     *          'S' - saliency Lq/Ld
+     *          'D' - feedback d current (read only)
+     *    'X' - Configuration dump - prints all the configuration registers as commands that can be sent back to restore it
      *    'M' - Monitoring control
      *          sub-commands:
      *          'D' - downsample monitoring
@@ -152,6 +212,7 @@ class Commander
      *
      *  - Each of them can be get by sening the command letter -(ex. 'R' - to get the phase resistance)
      *  - Each of them can be set by sending 'IdSubidValue' - (ex. SM1.5 for setting sensor zero offset to 1.5f)
+     *  - The parameters are the registers of the RegisterMap - see RegisterMap.h for the full list
      *
      */
     void motor(FOCMotor* motor, char* user_cmd);
@@ -210,6 +271,38 @@ class Commander
      */
     void target(FOCMotor* motor, char* user_cmd, char* separator = (char *)" ");
 
+    /**
+     *  Streaming setpoint interface, pushes a timestamped setpoint to the setpoint queue linked to a motor.
+     *  The values are sent separated by a separator specified as the third argument. The default separator is the space.
+     * 
+     * @param queue     - SetpointQueue instance 
+     * @param user_cmd  - the string command
+     * @param separator - the string separator in between the setpoint and the timestamp, default is space - " "
+     *  
+     *  Example: S2.34 150000
+     *  `S` is the user defined command, `2.34` is the setpoint and `150000` is the host timestamp in microseconds. 
+     *  If the timestamp is not sent the time of reception is used.
+     *  Sending an empty command returns the number of queued setpoints, underruns and overruns (ex. 3;0;1).
+     */
+    void setpoint(SetpointQueue* queue, char* user_cmd, char* separator = (char *)" ");
+
+    /**
+     *  Frequency response (Bode) measurement interface
+     * 
+     * @param fr        - FrequencyResponse instance linked to a motor
+     * @param user_cmd  - the string command
+     * @param separator - the string separator in between the sweep parameters, default is space - " "
+     * 
+     * Commands:
+     *    'T' - injection point (0 - current, 1 - velocity, 2 - voltage)
+     *    'A' - perturbation amplitude
+     *    'S' - start the sweep (ex. BS10 1000 20 - from 10Hz to 1kHz in 20 points)
+     *    'X' - stop the sweep
+     *    'G' - get the points measured since the last 'G', one per line: frequency;gain;phase
+     *    ''  - number of measured points and the number of points of the sweep (ex. 5;20)
+     */
+    void frequencyResponse(FrequencyResponse* fr, char* user_cmd, char* separator = (char *)" ");
+
     /**
      * FOC motor (StepperMotor and BLDCMotor) motion control interfaces
      * @param motor     - FOCMotor (BLDCMotor or StepperMotor) instance 
@@ -240,6 +333,32 @@ class Commander
      */
     void motion(FOCMotor* motor, char* user_cmd, char* separator = (char *)" ");
 
+    /**
+     * FOC motor register read interface
+     * @param motor   - FOCMotor (BLDCMotor or StepperMotor) instance 
+     * @param cmd     - command letter (see commands.h)
+     * @param sub_cmd - sub-command letter, 0 if the command has no sub-commands
+     * @param value   - read value
+     * 
+     *  - The registers are addressed with the same letters as the string commands (ex. 'V','P' - velocity PID P gain)
+     *  - The state variables are read with the monitoring command and the variable index (ex. 'M','5' - velocity)
+     * 
+     * @returns true if the register exists
+     */
+    bool readRegister(FOCMotor* motor, char cmd, char sub_cmd, float* value);
+    /**
+     * FOC motor register write interface
+     * @param motor   - FOCMotor (BLDCMotor or StepperMotor) instance 
+     * @param cmd     - command letter (see commands.h)
+     * @param sub_cmd - sub-command letter, 0 if the command has no sub-commands
+     * @param value   - value to be written
+     * 
+     * @returns true if the register exists and is writable and the value is in range
+     */
+    bool writeRegister(FOCMotor* motor, char cmd, char sub_cmd, float value);
+
+    unsigned long frame_errors = 0; //!< number of dropped binary frames (CRC, framing or overrun errors)
+
     bool isSentinel(char ch);
   private:
     // Subscribed command callback variables
@@ -247,10 +366,44 @@ class Commander
     char call_ids[20]; //!< added callback commands
     char* call_label[20]; //!< added callback labels
     int call_count = 0;//!< number callbacks that are subscribed
+    char call_id = 0; //!< command id of the callback being executed
+
+    // binary protocol motors
+    FOCMotor* motors[MAX_BINARY_MOTORS]; //!< motors addressable by the binary protocol
+    int motor_count = 0; //!< number of added motors
 
     // helping variable for serial communication reading
-    char received_chars[MAX_COMMAND_LENGTH] = {0}; //!< so far received user message - waiting for newline
+    char received_chars[MAX_REPLY_LENGTH > MAX_COMMAND_LENGTH ? MAX_REPLY_LENGTH : MAX_COMMAND_LENGTH] = {0}; //!< so far received user message - waiting for newline or frame delimiter, shared with the binary reply
     int rec_cnt = 0; //!< number of characters receives
+    bool binary = false; //!< receiving a binary frame
+    bool discard = false; //!< dropping the rest of an oversized binary frame until the next 0x00
+
+    /**
+     *  COBS decoding in place
+     *  @returns decoded length or 0 if the frame is invalid
+     */
+    static int cobsDecode(uint8_t* buffer, int length);
+    /**
+     *  CRC16-CCITT (polynomial 0x1021, initial value 0xFFFF)
+     */
+    static uint16_t crc16(const uint8_t* data, int length);
+    /**
+     *  Write the frame COBS encoded and delimited by 0x00 to the com_port
+     */
+    void writeFrame(const uint8_t* data, int length);
+
+    /**
+     *  Generic register get/set command - prints the label and the register value
+     */
+    void motorRegister(FOCMotor* motor, char cmd, char sub_cmd, float value, bool GET);
+    /**
+     *  Print all the configuration registers as commands (ex. MVP0.2)
+     */
+    void motorConfig(FOCMotor* motor);
+    /**
+     *  Print the register value in the format of its type
+     */
+    void printRegister(const RegisterEntry& entry, float value);
 
     // serial printing functions
     /**
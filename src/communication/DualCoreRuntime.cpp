@@ -0,0 +1,131 @@
+#include "DualCoreRuntime.h"
+#include "../common/time_utils.h"
+
+#define _CMD_MASK (SIMPLEFOC_MAILBOX_COMMAND_SIZE - 1)
+#define _TEL_MASK (SIMPLEFOC_MAILBOX_TELEMETRY_SIZE - 1)
+
+// the other core has to see the data before the index that publishes it
+#if defined(ARDUINO_ARCH_ESP32) || defined(TARGET_RP2040) || defined(ARDUINO_ARCH_RP2040)
+#define _MAILBOX_BARRIER() __sync_synchronize()
+#else
+#define _MAILBOX_BARRIER() __asm__ __volatile__("" ::: "memory")
+#endif
+
+DualCoreRuntime::DualCoreRuntime(FOCMotor &motor){
+  this->motor = &motor;
+}
+
+void DualCoreRuntime::run(){
+  unsigned long now = _micros();
+  if (reset_timing) {
+    loop_time_max = 0;
+    loop_period_max = 0;
+    reset_timing = false;
+  } else if (loop_count > 0) {
+    // time since the previous loop - worst case latency of the control
+    unsigned long period = now - timestamp_prev;
+    if (period > loop_period_max) loop_period_max = period;
+  }
+  timestamp_prev = now;
+
+  // apply a bounded number of commands
+  for (int i = 0; i < max_commands && command_tail != command_head; i++) {
+    _MAILBOX_BARRIER();
+    MotorCommand_s cmd = commands[command_tail];
+    _MAILBOX_BARRIER();
+    command_tail = (command_tail + 1) & _CMD_MASK;
+    if (!RegisterMap::write(motor, cmd.id, cmd.value)) rejected_commands++;
+  }
+
+  motor->loopFOC();
+  motor->move();
+
+  loop_time = _micros() - now;
+  if (loop_time > loop_time_max) loop_time_max = loop_time;
+  loop_count++;
+
+  if (telemetry_downsample > 0 && ++telemetry_count >= telemetry_downsample) {
+    telemetry_count = 0;
+    publishTelemetry(now);
+  }
+}
+
+void DualCoreRuntime::publishTelemetry(unsigned long now){
+  uint8_t next = (telemetry_head + 1) & _TEL_MASK;
+  if (next == telemetry_tail) {
+    telemetry_overruns++;
+    return;
+  }
+  MotorTelemetry_s& t = telemetry[telemetry_head];
+  t.timestamp = now;
+  t.target = motor->target;
+  t.shaft_angle = motor->shaft_angle;
+  t.shaft_velocity = motor->shaft_velocity;
+  t.voltage = motor->voltage;
+  t.current = motor->current;
+  t.loop_time = loop_time;
+  t.loop_time_max = loop_time_max;
+  t.loop_period_max = loop_period_max;
+  _MAILBOX_BARRIER();
+  telemetry_head = next;
+}
+
+bool DualCoreRuntime::setTarget(float target){
+  return write(REGISTER_TARGET, target);
+}
+
+bool DualCoreRuntime::write(uint8_t id, float value){
+  uint8_t next = (command_head + 1) & _CMD_MASK;
+  if (next == command_tail) {
+    command_overruns++;
+    return false;
+  }
+  commands[command_head].id = id;
+  commands[command_head].value = value;
+  _MAILBOX_BARRIER();
+  command_head = next;
+  return true;
+}
+
+bool DualCoreRuntime::readTelemetry(MotorTelemetry_s* t){
+  if (telemetry_tail == telemetry_head) return false;
+  _MAILBOX_BARRIER();
+  *t = telemetry[telemetry_tail];
+  _MAILBOX_BARRIER();
+  telemetry_tail = (telemetry_tail + 1) & _TEL_MASK;
+  return true;
+}
+
+void DualCoreRuntime::resetTiming(){
+  reset_timing = true;
+}
+
+
+#if defined(ESP_H) && defined(ARDUINO_ARCH_ESP32)
+
+static void _dualCoreControlTask(void* param){
+  DualCoreRuntime* runtime = (DualCoreRuntime*)param;
+  uint16_t loops = 0;
+  for (;;) {
+    runtime->run();
+    // let the lower priority tasks of the core (idle - watchdog) run
+    if (runtime->yield_loops && ++loops >= runtime->yield_loops) {
+      loops = 0;
+      vTaskDelay(1);
+    }
+  }
+}
+
+bool DualCoreRuntime::start(int core, int priority){
+  // without yielding the idle task of its core cannot feed the watchdog
+  // the higher priority tasks (network stack with the default priority) still preempt the control task
+  if (!yield_loops) {
+    if (core == 0) disableCore0WDT();
+#if !CONFIG_FREERTOS_UNICORE
+    else disableCore1WDT();
+#endif
+  }
+  return xTaskCreatePinnedToCore(_dualCoreControlTask, "simplefoc", 4096, this, priority, NULL, core) == pdPASS;
+}
+
+#endif
@@ -0,0 +1,151 @@
+#ifndef DUAL_CORE_RUNTIME_H
+#define DUAL_CORE_RUNTIME_H
+
+#include "Arduino.h"
+#include "../common/base_classes/FOCMotor.h"
+#include "RegisterMap.h"
+
+// command and telemetry mailbox sizes - must be powers of 2
+#ifndef SIMPLEFOC_MAILBOX_COMMAND_SIZE
+#define SIMPLEFOC_MAILBOX_COMMAND_SIZE 16
+#endif
+#ifndef SIMPLEFOC_MAILBOX_TELEMETRY_SIZE
+#define SIMPLEFOC_MAILBOX_TELEMETRY_SIZE 8
+#endif
+// uint8_t indexes - at most 256 entries
+static_assert(SIMPLEFOC_MAILBOX_COMMAND_SIZE >= 2 && (SIMPLEFOC_MAILBOX_COMMAND_SIZE & (SIMPLEFOC_MAILBOX_COMMAND_SIZE - 1)) == 0 && SIMPLEFOC_MAILBOX_COMMAND_SIZE <= 256,
+              "SIMPLEFOC_MAILBOX_COMMAND_SIZE must be a power of 2 between 2 and 256");
+static_assert(SIMPLEFOC_MAILBOX_TELEMETRY_SIZE >= 2 && (SIMPLEFOC_MAILBOX_TELEMETRY_SIZE & (SIMPLEFOC_MAILBOX_TELEMETRY_SIZE - 1)) == 0 && SIMPLEFOC_MAILBOX_TELEMETRY_SIZE <= 256,
+              "SIMPLEFOC_MAILBOX_TELEMETRY_SIZE must be a power of 2 between 2 and 256");
+// ESP32 control task priority - below the WiFi (23), BT and lwIP (18) tasks of the core 0
+#ifndef SIMPLEFOC_DUALCORE_TASK_PRIORITY
+#define SIMPLEFOC_DUALCORE_TASK_PRIORITY 10
+#endif
+
+/**
+ * Register write sent from the communication core to the control core
+ */
+struct MotorCommand_s {
+  uint8_t id; //!< register id (see RegisterMap)
+  float value; //!< register value
+};
+
+/**
+ * Motor state snapshot sent from the control core to the communication core
+ */
+struct MotorTelemetry_s {
+  unsigned long timestamp; //!< control core time [us]
+  float target; //!< motor target
+  float shaft_angle; //!< shaft angle [rad]
+  float shaft_velocity; //!< shaft velocity [rad/s]
+  DQVoltage_s voltage; //!< dq voltages [V]
+  DQCurrent_s current; //!< dq currents [A]
+  unsigned long loop_time; //!< execution time of the last control loop [us]
+  unsigned long loop_time_max; //!< worst case control loop execution time [us]
+  unsigned long loop_period_max; //!< worst case time between two control loops [us]
+};
+
+/**
+ * Dual core runtime - the motor control runs alone on one core, the communication on the other
+ *
+ *  - The control core calls run() in a tight loop: it applies the received register writes,
+ *    runs loopFOC() and move(), measures the loop timing and publishes the telemetry
+ *  - The communication core sends the setpoints and the parameters with setTarget() and write()
+ *    and receives the motor state with readTelemetry()
+ *  - The cores exchange data only through two single-producer/single-consumer ring buffers,
+ *    no locks are taken and none of the sides ever waits for the other
+ *  - The parameters are written by the control core through the RegisterMap, between two control loops,
+ *    so the write hooks (ex. enable/disable, limits) run on the control core as well
+ *
+ * RP2040 (Arduino-Pico) example:
+ *    DualCoreRuntime runtime(motor);
+ *    void loop(){ command.run(); if (runtime.readTelemetry(&t)) { ... } }   // core 0
+ *    void loop1(){ runtime.run(); }                                         // core 1
+ *
+ * ESP32 example:
+ *    runtime.start(0);   // control task pinned to core 0, loop() (core 1) is free for the communication
+ *
+ * On ESP32 the core 0 also runs the WiFi, BT and lwIP tasks. By default the control task runs below them:
+ * the network stack keeps working but preempts the control loop (jitter of the loop timing, see loop_period_max).
+ * Started above them (ex. configMAX_PRIORITIES - 1) the loop timing is tight, but the network stack starves.
+ * The task never blocks, so the lower priority tasks of its core (idle - the task watchdog) do not run:
+ * the watchdog of the core is disabled, unless yield_loops lets them run periodically.
+ *
+ * Do not call the motor functions (ex. move(), monitor() or the Commander motor commands) from the communication
+ * core while the runtime is running - use write() with the register ids instead.
+ */
+class DualCoreRuntime
+{
+  public:
+    /**
+     * @param motor - controlled motor, initialised (init() and initFOC()) before the control core starts
+     */
+    DualCoreRuntime(FOCMotor &motor);
+
+    /**
+     * One iteration of the control core - apply the commands, loopFOC(), move(), timing and telemetry
+     */
+    void run();
+
+#if defined(ESP_H) && defined(ARDUINO_ARCH_ESP32)
+    /**
+     * Start a FreeRTOS task calling run() forever, pinned to the core
+     * @param core - core of the control task (the Arduino loop() runs on the core 1)
+     * @param priority - task priority
+     * @returns false if the task could not be created
+     */
+    bool start(int core = 0, int priority = SIMPLEFOC_DUALCORE_TASK_PRIORITY);
+#endif
+
+    /**
+     * Send a new target to the control core - communication core side
+     * @returns false if the command mailbox is full
+     */
+    bool setTarget(float target);
+    /**
+     * Send a register write to the control core - communication core side
+     * @param id - register id (see RegisterMap)
+     * @returns false if the command mailbox is full
+     */
+    bool write(uint8_t id, float value);
+    /**
+     * Receive the oldest telemetry snapshot - communication core side
+     * @returns false if there is no new telemetry
+     */
+    bool readTelemetry(MotorTelemetry_s* telemetry);
+    /** Reset the worst case timing - applied by the control core in the next run() */
+    void resetTiming();
+
+    uint16_t telemetry_downsample = 100; //!< control loops between two telemetry snapshots (0 - no telemetry)
+    uint8_t max_commands = 4; //!< maximal number of commands applied per control loop
+    uint16_t yield_loops = 0; //!< ESP32 - control loops between two 1 tick delays of the control task (0 - never, the core watchdog is disabled)
+
+    // control core statistics - written only by the control core
+    volatile unsigned long loop_count = 0; //!< number of control loops
+    volatile unsigned long loop_time = 0; //!< execution time of the last control loop [us]
+    volatile unsigned long loop_time_max = 0; //!< worst case control loop execution time [us]
+    volatile unsigned long loop_period_max = 0; //!< worst case time between two control loops [us] - the control latency
+    volatile unsigned long rejected_commands = 0; //!< register writes refused by the RegisterMap
+    volatile unsigned long telemetry_overruns = 0; //!< snapshots dropped because the telemetry mailbox was full
+    // communication core statistics
+    unsigned long command_overruns = 0; //!< commands dropped because the command mailbox was full
+
+  protected:
+    FOCMotor* motor; //!< controlled motor
+
+    MotorCommand_s commands[SIMPLEFOC_MAILBOX_COMMAND_SIZE]; //!< command ring
+    volatile uint8_t command_head = 0; //!< command write index - communication core
+    volatile uint8_t command_tail = 0; //!< command read index - control core
+    MotorTelemetry_s telemetry[SIMPLEFOC_MAILBOX_TELEMETRY_SIZE]; //!< telemetry ring
+    volatile uint8_t telemetry_head = 0; //!< telemetry write index - control core
+    volatile uint8_t telemetry_tail = 0; //!< telemetry read index - communication core
+
+    volatile bool reset_timing = false; //!< timing reset requested by the communication core
+    unsigned long timestamp_prev = 0; //!< start of the previous control loop [us]
+    uint16_t telemetry_count = 0; //!< control loops since the last telemetry snapshot
+
+    /** publish the telemetry snapshot - control core */
+    void publishTelemetry(unsigned long now);
+};
+
+#endif
@@ -0,0 +1,203 @@
+#include "RegisterMap.h"
+
+// the table and the labels are stored in flash on AVR - copied to RAM on access
+#if defined(__AVR__)
+#define REGISTER_PROGMEM PROGMEM
+#define _reg_memcpy memcpy_P
+#else
+#define REGISTER_PROGMEM
+#define _reg_memcpy memcpy
+#endif
+
+
+// write hooks - keep the dependent parameters consistent, same as the string commands used to
+
+static void _regOnEnable(FOCMotor* m){
+  m->enabled ? m->enable() : m->disable();
+}
+
+static void _regOnTorqueController(FOCMotor* m){
+  // change the velocity control limits if necessary
+  if (m->torque_controller != TorqueControlType::voltage) m->PID_velocity.limit = m->current_limit;
+  else if (!_isset(m->phase_resistance)) m->PID_velocity.limit = m->voltage_limit;
+}
+
+static void _regOnVoltageLimit(FOCMotor* m){
+  m->PID_current_d.limit = m->voltage_limit;
+  m->PID_current_q.limit = m->voltage_limit;
+  // change velocity pid limit if in voltage mode and no phase resistance set
+  if (!_isset(m->phase_resistance) && m->torque_controller == TorqueControlType::voltage) m->PID_velocity.limit = m->voltage_limit;
+}
+
+static void _regOnCurrentLimit(FOCMotor* m){
+  // if phase resistance specified or the current control is on set the current limit to the velocity PID
+  if (_isset(m->phase_resistance) || m->torque_controller != TorqueControlType::voltage) m->PID_velocity.limit = m->current_limit;
+}
+
+static void _regOnVelocityLimit(FOCMotor* m){
+  m->P_angle.limit = m->velocity_limit;
+}
+
+static void _regOnPhaseResistance(FOCMotor* m){
+  if (m->torque_controller == TorqueControlType::voltage) m->PID_velocity.limit = m->current_limit;
+}
+
+static void _regOnFieldWeakening(FOCMotor* m){
+  // recompute the MTPA table
+  m->field_weakening->init(m->phase_resistance, m->phase_inductance, m->KV_rating, m->pole_pairs, m->current_limit);
+}
+
+
+// field address getters
+#define _REGISTER_POINTER(id, name, cmd, sub_cmd, type, access, min, max, pointer, on_write, label) \
+  static void* _reg_pointer_##name(FOCMotor* m){ return (void*)(pointer); }
+SIMPLEFOC_REGISTERS(_REGISTER_POINTER)
+#undef _REGISTER_POINTER
+
+// labels
+#define _REGISTER_LABEL(id, name, cmd, sub_cmd, type, access, min, max, pointer, on_write, label) \
+  static const char _reg_label_##name[] REGISTER_PROGMEM = label;
+SIMPLEFOC_REGISTERS(_REGISTER_LABEL)
+#undef _REGISTER_LABEL
+
+// register table
+#define _REGISTER_ENTRY(id, name, cmd, sub_cmd, type, access, min, max, pointer, on_write, label) \
+  { id, cmd, sub_cmd, type, access, min, max, _reg_pointer_##name, on_write, _reg_label_##name },
+static const RegisterEntry _registers[] REGISTER_PROGMEM = {
+  SIMPLEFOC_REGISTERS(_REGISTER_ENTRY)
+};
+#undef _REGISTER_ENTRY
+
+#define _REGISTER_COUNT ((int)(sizeof(_registers) / sizeof(RegisterEntry)))
+
+
+int RegisterMap::count(){
+  return _REGISTER_COUNT;
+}
+
+bool RegisterMap::entry(int index, RegisterEntry* entry){
+  if (index < 0 || index >= _REGISTER_COUNT) return false;
+  _reg_memcpy(entry, &_registers[index], sizeof(RegisterEntry));
+  return true;
+}
+
+int RegisterMap::find(char cmd, char sub_cmd){
+  // exact match or the command without the sub-commands (ex. 'R' ignores the sub-command letter)
+  int fallback = -1;
+  RegisterEntry e;
+  for (int i = 0; i < _REGISTER_COUNT; i++) {
+    entry(i, &e);
+    if (e.cmd != cmd) continue;
+    if (e.sub_cmd == sub_cmd) return i;
+    if (e.sub_cmd == 0) fallback = i;
+  }
+  return fallback;
+}
+
+int RegisterMap::find(uint8_t id){
+  RegisterEntry e;
+  for (int i = 0; i < _REGISTER_COUNT; i++) {
+    entry(i, &e);
+    if (e.id == id) return i;
+  }
+  return -1;
+}
+
+bool RegisterMap::read(FOCMotor* motor, const RegisterEntry& entry, float* value){
+  if (!(entry.access & REGISTER_R)) return false;
+  void* p = entry.pointer(motor);
+  if (!p) return false;
+  switch (entry.type) {
+    case reg_float: *value = *(float*)p; break;
+    case reg_int:   *value = *(int*)p; break;
+    case reg_uint:  *value = *(unsigned int*)p; break;
+    case reg_int8:  *value = *(int8_t*)p; break;
+    case reg_uint8: *value = *(uint8_t*)p; break;
+    case reg_bool:  *value = *(bool*)p; break;
+    default: return false;
+  }
+  return true;
+}
+
+bool RegisterMap::write(FOCMotor* motor, const RegisterEntry& entry, float value){
+  if (!(entry.access & REGISTER_W)) return false;
+  void* p = entry.pointer(motor);
+  if (!p) return false;
+  // optional parameters can be reset to NOT_SET
+  bool unset = (entry.access & REGISTER_OPTIONAL) && !_isset(value);
+  if (!unset && (value != value || value < entry.min || value > entry.max)) return false;
+  switch (entry.type) {
+    case reg_float: *(float*)p = value; break;
+    case reg_int:   *(int*)p = (int)value; break;
+    case reg_uint:  *(unsigned int*)p = (unsigned int)value; break;
+    case reg_int8:  *(int8_t*)p = (int8_t)value; break;
+    case reg_uint8: *(uint8_t*)p = (uint8_t)value; break;
+    case reg_bool:  *(bool*)p = (bool)value; break;
+    default: return false;
+  }
+  if (entry.on_write) entry.on_write(motor);
+  return true;
+}
+
+bool RegisterMap::read(FOCMotor* motor, uint8_t id, float* value){
+  RegisterEntry e;
+  if (!entry(find(id), &e)) return false;
+  return read(motor, e, value);
+}
+
+bool RegisterMap::write(FOCMotor* motor, uint8_t id, float value){
+  RegisterEntry e;
+  if (!entry(find(id), &e)) return false;
+  return write(motor, e, value);
+}
+
+int RegisterMap::read(FOCMotor* motor, const uint8_t* ids, float* values, int n){
+  int cnt = 0;
+  for (int i = 0; i < n; i++) {
+    if (read(motor, ids[i], &values[i])) cnt++;
+    else values[i] = NOT_SET;
+  }
+  return cnt;
+}
+
+int RegisterMap::write(FOCMotor* motor, const uint8_t* ids, const float* values, int n){
+  int cnt = 0;
+  for (int i = 0; i < n; i++)
+    if (write(motor, ids[i], values[i])) cnt++;
+  return cnt;
+}
+
+int RegisterMap::configSize(){
+  int cnt = 0;
+  RegisterEntry e;
+  for (int i = 0; i < _REGISTER_COUNT; i++) {
+    entry(i, &e);
+    if (e.access & REGISTER_CONFIG) cnt++;
+  }
+  return cnt;
+}
+
+int RegisterMap::dump(FOCMotor* motor, float* values){
+  int cnt = 0;
+  RegisterEntry e;
+  for (int i = 0; i < _REGISTER_COUNT; i++) {
+    entry(i, &e);
+    if (!(e.access & REGISTER_CONFIG)) continue;
+    // keep the position of the registers not available for this motor
+    if (!read(motor, e, &values[cnt])) values[cnt] = NOT_SET;
+    cnt++;
+  }
+  return cnt;
+}
+
+int RegisterMap::restore(FOCMotor* motor, const float* values){
+  int cnt = 0, n = 0;
+  RegisterEntry e;
+  for (int i = 0; i < _REGISTER_COUNT; i++) {
+    entry(i, &e);
+    if (!(e.access & REGISTER_CONFIG)) continue;
+    if ((_isset(values[n]) || (e.access & REGISTER_OPTIONAL)) && write(motor, e, values[n])) cnt++;
+    n++;
+  }
+  return cnt;
+}
@@ -0,0 +1,216 @@
+#ifndef REGISTER_MAP_H
+#define REGISTER_MAP_H
+
+#include "Arduino.h"
+#include "../common/base_classes/FOCMotor.h"
+#include "commands.h"
+
+/**
+ * Register value types
+ */
+enum RegisterType : uint8_t {
+  reg_float = 0x00, //!< float
+  reg_int   = 0x01, //!< int (architecture size)
+  reg_uint  = 0x02, //!< unsigned int (architecture size)
+  reg_int8  = 0x03, //!< int8_t and int8_t based enums
+  reg_uint8 = 0x04, //!< uint8_t and uint8_t based enums
+  reg_bool  = 0x05, //!< bool
+};
+
+// register access flags
+#define REGISTER_R        0x01 //!< readable
+#define REGISTER_W        0x02 //!< writable
+#define REGISTER_RW       0x03 //!< readable and writable
+#define REGISTER_CONFIG   0x04 //!< part of the configuration dump/restore
+#define REGISTER_OPTIONAL 0x08 //!< value can be NOT_SET - displayed as 0
+
+#define REGISTER_NO_LIMIT 3.4e38f //!< range limit of the unbounded registers
+
+/**
+ * Register list - X(id, name, cmd, sub_cmd, type, access, min, max, pointer, on_write, label)
+ *  - id       - numeric register id, stable - used by the binary protocol and the configuration dumps
+ *  - cmd      - command letter (see commands.h)
+ *  - sub_cmd  - sub-command letter, 0 if the command has no sub-commands
+ *  - pointer  - expression of the field address for the motor `m`, nullptr if not available (ex. no sensor linked)
+ *  - on_write - function called after the register has been written (or nullptr)
+ *  - label    - user friendly label displayed by the string protocol
+ *
+ * To add a register add a line to this list - the string and binary protocols will pick it up.
+ */
+#define SIMPLEFOC_REGISTERS(X) \
+  /* motor state */ \
+  X(0x00, REGISTER_TARGET,         CMD_MONITOR, '0', reg_float, REGISTER_RW, -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, &m->target, nullptr, "target") \
+  X(0x01, REGISTER_VOLTAGE_Q,      CMD_MONITOR, '1', reg_float, REGISTER_R,  -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, &m->voltage.q, nullptr, "Vq") \
+  X(0x02, REGISTER_VOLTAGE_D,      CMD_MONITOR, '2', reg_float, REGISTER_R,  -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, &m->voltage.d, nullptr, "Vd") \
+  X(0x03, REGISTER_CURRENT_Q,      CMD_MONITOR, '3', reg_float, REGISTER_R,  -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, &m->current.q, nullptr, "Cq") \
+  X(0x04, REGISTER_CURRENT_D,      CMD_MONITOR, '4', reg_float, REGISTER_R,  -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, &m->current.d, nullptr, "Cd") \
+  X(0x05, REGISTER_VELOCITY,       CMD_MONITOR, '5', reg_float, REGISTER_R,  -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, &m->shaft_velocity, nullptr, "vel") \
+  X(0x06, REGISTER_ANGLE,          CMD_MONITOR, '6', reg_float, REGISTER_R,  -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, &m->shaft_angle, nullptr, "angle") \
+  X(0x07, REGISTER_ENABLE,         CMD_STATUS,   0,  reg_int8,  REGISTER_RW, 0, 1, &m->enabled, _regOnEnable, "Status") \
+  /* motion and torque control */ \
+  X(0x10, REGISTER_CONTROLLER,     CMD_MOTION_TYPE, 0, reg_uint8, REGISTER_RW | REGISTER_CONFIG, 0, 4, &m->controller, nullptr, "Motion") \
+  X(0x11, REGISTER_TORQUE_CONTROLLER, CMD_TORQUE_TYPE, 0, reg_uint8, REGISTER_RW | REGISTER_CONFIG, 0, 2, &m->torque_controller, _regOnTorqueController, "Torque") \
+  X(0x12, REGISTER_MOTION_DOWNSAMPLE, CMD_MOTION_TYPE, SCMD_DOWNSAMPLE, reg_uint, REGISTER_RW | REGISTER_CONFIG, 0, 65535, &m->motion_downsample, nullptr, "Motion: downsample") \
+  X(0x13, REGISTER_MODULATION,     CMD_PWMMOD, SCMD_PWMMOD_TYPE, reg_uint8, REGISTER_RW | REGISTER_CONFIG, 0, 3, &m->foc_modulation, nullptr, "PWM Mod | type") \
+  X(0x14, REGISTER_MODULATION_CENTERED, CMD_PWMMOD, SCMD_PWMMOD_CENTER, reg_int8, REGISTER_RW | REGISTER_CONFIG, 0, 1, &m->modulation_centered, nullptr, "PWM Mod | center") \
+  /* controllers and filters */ \
+  X(0x20, REGISTER_CURQ_P,         CMD_C_Q_PID, SCMD_PID_P,    reg_float, REGISTER_RW | REGISTER_CONFIG, -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, &m->PID_current_q.P, nullptr, "PID curr q| P") \
+  X(0x21, REGISTER_CURQ_I,         CMD_C_Q_PID, SCMD_PID_I,    reg_float, REGISTER_RW | REGISTER_CONFIG, -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, &m->PID_current_q.I, nullptr, "PID curr q| I") \
+  X(0x22, REGISTER_CURQ_D,         CMD_C_Q_PID, SCMD_PID_D,    reg_float, REGISTER_RW | REGISTER_CONFIG, -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, &m->PID_current_q.D, nullptr, "PID curr q| D") \
+  X(0x23, REGISTER_CURQ_RAMP,      CMD_C_Q_PID, SCMD_PID_RAMP, reg_float, REGISTER_RW | REGISTER_CONFIG, 0, REGISTER_NO_LIMIT, &m->PID_current_q.output_ramp, nullptr, "PID curr q| ramp") \
+  X(0x24, REGISTER_CURQ_LIMIT,     CMD_C_Q_PID, SCMD_PID_LIM,  reg_float, REGISTER_RW | REGISTER_CONFIG, 0, REGISTER_NO_LIMIT, &m->PID_current_q.limit, nullptr, "PID curr q| limit") \
+  X(0x25, REGISTER_CURQ_TF,        CMD_C_Q_PID, SCMD_LPF_TF,   reg_float, REGISTER_RW | REGISTER_CONFIG, 0, REGISTER_NO_LIMIT, &m->LPF_current_q.Tf, nullptr, "PID curr q| Tf") \
+  X(0x28, REGISTER_CURD_P,         CMD_C_D_PID, SCMD_PID_P,    reg_float, REGISTER_RW | REGISTER_CONFIG, -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, &m->PID_current_d.P, nullptr, "PID curr d| P") \
+  X(0x29, REGISTER_CURD_I,         CMD_C_D_PID, SCMD_PID_I,    reg_float, REGISTER_RW | REGISTER_CONFIG, -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, &m->PID_current_d.I, nullptr, "PID curr d| I") \
+  X(0x2A, REGISTER_CURD_D,         CMD_C_D_PID, SCMD_PID_D,    reg_float, REGISTER_RW | REGISTER_CONFIG, -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, &m->PID_current_d.D, nullptr, "PID curr d| D") \
+  X(0x2B, REGISTER_CURD_RAMP,      CMD_C_D_PID, SCMD_PID_RAMP, reg_float, REGISTER_RW | REGISTER_CONFIG, 0, REGISTER_NO_LIMIT, &m->PID_current_d.output_ramp, nullptr, "PID curr d| ramp") \
+  X(0x2C, REGISTER_CURD_LIMIT,     CMD_C_D_PID, SCMD_PID_LIM,  reg_float, REGISTER_RW | REGISTER_CONFIG, 0, REGISTER_NO_LIMIT, &m->PID_current_d.limit, nullptr, "PID curr d| limit") \
+  X(0x2D, REGISTER_CURD_TF,        CMD_C_D_PID, SCMD_LPF_TF,   reg_float, REGISTER_RW | REGISTER_CONFIG, 0, REGISTER_NO_LIMIT, &m->LPF_current_d.Tf, nullptr, "PID curr d| Tf") \
+  X(0x30, REGISTER_VEL_P,          CMD_V_PID,   SCMD_PID_P,    reg_float, REGISTER_RW | REGISTER_CONFIG, -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, &m->PID_velocity.P, nullptr, "PID vel| P") \
+  X(0x31, REGISTER_VEL_I,          CMD_V_PID,   SCMD_PID_I,    reg_float, REGISTER_RW | REGISTER_CONFIG, -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, &m->PID_velocity.I, nullptr, "PID vel| I") \
+  X(0x32, REGISTER_VEL_D,          CMD_V_PID,   SCMD_PID_D,    reg_float, REGISTER_RW | REGISTER_CONFIG, -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, &m->PID_velocity.D, nullptr, "PID vel| D") \
+  X(0x33, REGISTER_VEL_RAMP,       CMD_V_PID,   SCMD_PID_RAMP, reg_float, REGISTER_RW | REGISTER_CONFIG, 0, REGISTER_NO_LIMIT, &m->PID_velocity.output_ramp, nullptr, "PID vel| ramp") \
+  X(0x34, REGISTER_VEL_LIMIT,      CMD_V_PID,   SCMD_PID_LIM,  reg_float, REGISTER_RW | REGISTER_CONFIG, 0, REGISTER_NO_LIMIT, &m->PID_velocity.limit, nullptr, "PID vel| limit") \
+  X(0x35, REGISTER_VEL_TF,         CMD_V_PID,   SCMD_LPF_TF,   reg_float, REGISTER_RW | REGISTER_CONFIG, 0, REGISTER_NO_LIMIT, &m->LPF_velocity.Tf, nullptr, "PID vel| Tf") \
+  X(0x38, REGISTER_ANG_P,          CMD_A_PID,   SCMD_PID_P,    reg_float, REGISTER_RW | REGISTER_CONFIG, -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, &m->P_angle.P, nullptr, "PID angle| P") \
+  X(0x39, REGISTER_ANG_I,          CMD_A_PID,   SCMD_PID_I,    reg_float, REGISTER_RW | REGISTER_CONFIG, -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, &m->P_angle.I, nullptr, "PID angle| I") \
+  X(0x3A, REGISTER_ANG_D,          CMD_A_PID,   SCMD_PID_D,    reg_float, REGISTER_RW | REGISTER_CONFIG, -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, &m->P_angle.D, nullptr, "PID angle| D") \
+  X(0x3B, REGISTER_ANG_RAMP,       CMD_A_PID,   SCMD_PID_RAMP, reg_float, REGISTER_RW | REGISTER_CONFIG, 0, REGISTER_NO_LIMIT, &m->P_angle.output_ramp, nullptr, "PID angle| ramp") \
+  X(0x3C, REGISTER_ANG_LIMIT,      CMD_A_PID,   SCMD_PID_LIM,  reg_float, REGISTER_RW | REGISTER_CONFIG, 0, REGISTER_NO_LIMIT, &m->P_angle.limit, nullptr, "PID angle| limit") \
+  X(0x3D, REGISTER_ANG_TF,         CMD_A_PID,   SCMD_LPF_TF,   reg_float, REGISTER_RW | REGISTER_CONFIG, 0, REGISTER_NO_LIMIT, &m->LPF_angle.Tf, nullptr, "PID angle| Tf") \
+  /* limits */ \
+  X(0x40, REGISTER_VOLTAGE_LIMIT,  CMD_LIMITS, SCMD_LIM_VOLT, reg_float, REGISTER_RW | REGISTER_CONFIG, 0, REGISTER_NO_LIMIT, &m->voltage_limit, _regOnVoltageLimit, "Limits| volt") \
+  X(0x41, REGISTER_CURRENT_LIMIT,  CMD_LIMITS, SCMD_LIM_CURR, reg_float, REGISTER_RW | REGISTER_CONFIG, 0, REGISTER_NO_LIMIT, &m->current_limit, _regOnCurrentLimit, "Limits| curr") \
+  X(0x42, REGISTER_VELOCITY_LIMIT, CMD_LIMITS, SCMD_LIM_VEL,  reg_float, REGISTER_RW | REGISTER_CONFIG, 0, REGISTER_NO_LIMIT, &m->velocity_limit, _regOnVelocityLimit, "Limits| vel") \
+  /* motor parameters */ \
+  X(0x48, REGISTER_PHASE_RESISTANCE, CMD_RESIST,     0, reg_float, REGISTER_RW | REGISTER_CONFIG | REGISTER_OPTIONAL, 0, REGISTER_NO_LIMIT, &m->phase_resistance, _regOnPhaseResistance, "R phase") \
+  X(0x49, REGISTER_PHASE_INDUCTANCE, CMD_INDUCTANCE, 0, reg_float, REGISTER_RW | REGISTER_CONFIG | REGISTER_OPTIONAL, 0, REGISTER_NO_LIMIT, &m->phase_inductance, nullptr, "L phase") \
+  X(0x4A, REGISTER_KV_RATING,        CMD_KV_RATING,  0, reg_float, REGISTER_RW | REGISTER_CONFIG | REGISTER_OPTIONAL, 0, REGISTER_NO_LIMIT, &m->KV_rating, nullptr, "Motor KV") \
+  X(0x4B, REGISTER_POLE_PAIRS,       CMD_POLE_PAIRS, 0, reg_int,   REGISTER_RW | REGISTER_CONFIG, 1, 1000, &m->pole_pairs, nullptr, "Pole pairs") \
+  /* sensor */ \
+  X(0x50, REGISTER_SENSOR_OFFSET,    CMD_SENSOR, SCMD_SENS_MECH_OFFSET, reg_float, REGISTER_RW | REGISTER_CONFIG, -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, &m->sensor_offset, nullptr, "Sensor | offset") \
+  X(0x51, REGISTER_ZERO_ELECTRIC_ANGLE, CMD_SENSOR, SCMD_SENS_ELEC_OFFSET, reg_float, REGISTER_RW | REGISTER_CONFIG | REGISTER_OPTIONAL, -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, &m->zero_electric_angle, nullptr, "Sensor | el. offset") \
+  X(0x52, REGISTER_SENSOR_DIRECTION, CMD_SENSOR, SCMD_SENS_DIRECTION, reg_int8, REGISTER_RW | REGISTER_CONFIG, -1, 1, &m->sensor_direction, nullptr, "Sensor | direction") \
+  X(0x53, REGISTER_VOLTAGE_SENSOR_ALIGN, CMD_SENSOR, SCMD_SENS_ALIGN_VOLT, reg_float, REGISTER_RW | REGISTER_CONFIG, 0, REGISTER_NO_LIMIT, &m->voltage_sensor_align, nullptr, "Sensor | align volt") \
+  X(0x54, REGISTER_VELOCITY_INDEX_SEARCH, CMD_SENSOR, SCMD_SENS_INDEX_VEL, reg_float, REGISTER_RW | REGISTER_CONFIG, -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, &m->velocity_index_search, nullptr, "Sensor | index vel") \
+  X(0x55, REGISTER_SENSOR_MIN_ELAPSED, CMD_SENSOR, SCMD_SENS_MIN_TIME, reg_float, REGISTER_RW | REGISTER_CONFIG, 0, REGISTER_NO_LIMIT, m->sensor ? &m->sensor->min_elapsed_time : nullptr, nullptr, "Sensor | min time") \
+  /* field weakening */ \
+  X(0x58, REGISTER_FW_MARGIN,   CMD_FIELD_WEAKENING, SCMD_FW_MARGIN,   reg_float, REGISTER_RW | REGISTER_CONFIG, 0, 1, m->field_weakening ? &m->field_weakening->voltage_margin : nullptr, nullptr, "FW | margin") \
+  X(0x59, REGISTER_FW_KI,       CMD_FIELD_WEAKENING, SCMD_FW_KI,       reg_float, REGISTER_RW | REGISTER_CONFIG, 0, REGISTER_NO_LIMIT, m->field_weakening ? &m->field_weakening->Ki : nullptr, nullptr, "FW | Ki") \
+  X(0x5A, REGISTER_FW_LIMIT,    CMD_FIELD_WEAKENING, SCMD_FW_LIMIT,    reg_float, REGISTER_RW | REGISTER_CONFIG | REGISTER_OPTIONAL, 0, REGISTER_NO_LIMIT, m->field_weakening ? &m->field_weakening->current_d_limit : nullptr, nullptr, "FW | id limit") \
+  X(0x5B, REGISTER_FW_SALIENCY, CMD_FIELD_WEAKENING, SCMD_FW_SALIENCY, reg_float, REGISTER_RW | REGISTER_CONFIG, 1, REGISTER_NO_LIMIT, m->field_weakening ? &m->field_weakening->saliency : nullptr, _regOnFieldWeakening, "FW | saliency") \
+  X(0x5C, REGISTER_FW_CURRENT_D, CMD_FIELD_WEAKENING, SCMD_FW_CURRENT_D, reg_float, REGISTER_R, -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, m->field_weakening ? &m->field_weakening->current_d_fb : nullptr, nullptr, "FW | id fb") \
+  /* current sense */ \
+  X(0x60, REGISTER_CS_GAIN_A,     CMD_CURRENT_SENSE, SCMD_CS_GAIN_A,   reg_float, REGISTER_RW | REGISTER_CONFIG, -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, m->current_sense ? &m->current_sense->gain_a : nullptr, nullptr, "CS | gain a") \
+  X(0x61, REGISTER_CS_GAIN_B,     CMD_CURRENT_SENSE, SCMD_CS_GAIN_B,   reg_float, REGISTER_RW | REGISTER_CONFIG, -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, m->current_sense ? &m->current_sense->gain_b : nullptr, nullptr, "CS | gain b") \
+  X(0x62, REGISTER_CS_GAIN_C,     CMD_CURRENT_SENSE, SCMD_CS_GAIN_C,   reg_float, REGISTER_RW | REGISTER_CONFIG, -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, m->current_sense ? &m->current_sense->gain_c : nullptr, nullptr, "CS | gain c") \
+  X(0x63, REGISTER_CS_OFFSET_A,   CMD_CURRENT_SENSE, SCMD_CS_OFFSET_A, reg_float, REGISTER_RW | REGISTER_CONFIG, -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, m->current_sense ? &m->current_sense->offset_ia : nullptr, nullptr, "CS | offset a") \
+  X(0x64, REGISTER_CS_OFFSET_B,   CMD_CURRENT_SENSE, SCMD_CS_OFFSET_B, reg_float, REGISTER_RW | REGISTER_CONFIG, -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, m->current_sense ? &m->current_sense->offset_ib : nullptr, nullptr, "CS | offset b") \
+  X(0x65, REGISTER_CS_OFFSET_C,   CMD_CURRENT_SENSE, SCMD_CS_OFFSET_C, reg_float, REGISTER_RW | REGISTER_CONFIG, -REGISTER_NO_LIMIT, REGISTER_NO_LIMIT, m->current_sense ? &m->current_sense->offset_ic : nullptr, nullptr, "CS | offset c") \
+  X(0x66, REGISTER_CS_SKIP_ALIGN, CMD_CURRENT_SENSE, SCMD_CS_SKIP_ALIGN, reg_bool, REGISTER_RW | REGISTER_CONFIG, 0, 1, m->current_sense ? &m->current_sense->skip_align : nullptr, nullptr, "CS | skip align") \
+  /* monitoring */ \
+  X(0x70, REGISTER_MONITOR_DOWNSAMPLE, CMD_MONITOR, SCMD_DOWNSAMPLE, reg_uint,  REGISTER_RW | REGISTER_CONFIG, 0, 65535, &m->monitor_downsample, nullptr, "Monitor | downsample") \
+  X(0x71, REGISTER_MONITOR_DECIMALS,   CMD_MONITOR, CMD_DECIMAL,     reg_uint,  REGISTER_RW | REGISTER_CONFIG, 0, 10, &m->monitor_decimals, nullptr, "Monitor | decimal") \
+  X(0x72, REGISTER_MONITOR_VARIABLES,  CMD_MONITOR, SCMD_SET,        reg_uint8, REGISTER_RW | REGISTER_CONFIG, 0, 127, &m->monitor_variables, nullptr, "Monitor | variables")
+
+/**
+ * Register ids
+ */
+#define _REGISTER_ENUM(id, name, ...) name = id,
+enum SimpleFOCRegister : uint8_t {
+  SIMPLEFOC_REGISTERS(_REGISTER_ENUM)
+};
+#undef _REGISTER_ENUM
+
+typedef void* (*RegisterPointer)(FOCMotor* m); //!< register field address of the motor
+typedef void (*RegisterHook)(FOCMotor* m); //!< function called after the register is written
+
+/**
+ * Register description
+ */
+struct RegisterEntry {
+  uint8_t id; //!< register id
+  char cmd; //!< command letter
+  char sub_cmd; //!< sub-command letter or 0
+  uint8_t type; //!< RegisterType
+  uint8_t access; //!< access flags
+  float min; //!< minimal value accepted by a write
+  float max; //!< maximal value accepted by a write
+  RegisterPointer pointer; //!< field address getter
+  RegisterHook on_write; //!< write hook or nullptr
+  const char* label; //!< user friendly label (in flash on AVR)
+};
+
+/**
+ * Register map of the FOCMotor, PIDController, LowPassFilter, Sensor and CurrentSense tunables
+ *
+ * The map is a compile-time table (stored in flash on AVR) shared by the string and the binary
+ * Commander protocols. It provides the generic, range checked read and write of one register,
+ * bulk access to multiple registers and the dump/restore of the full motor configuration.
+ */
+class RegisterMap {
+  public:
+    /** number of registers in the map */
+    static int count();
+    /**
+     * Copy the register description
+     * @param index - table index [0, count())
+     * @param entry - copied description
+     */
+    static bool entry(int index, RegisterEntry* entry);
+    /**
+     * Find the register by the command letters
+     * @returns table index or -1 if not found
+     */
+    static int find(char cmd, char sub_cmd);
+    /**
+     * Find the register by its id
+     * @returns table index or -1 if not found
+     */
+    static int find(uint8_t id);
+
+    /**
+     * Read the register value converted to float
+     * @returns false if the register is not readable or not available for this motor
+     */
+    static bool read(FOCMotor* motor, const RegisterEntry& entry, float* value);
+    /**
+     * Write the register value converted from float - range checked
+     * @returns false if the register is not writable, not available for this motor or the value is out of range
+     */
+    static bool write(FOCMotor* motor, const RegisterEntry& entry, float value);
+    /** Read the register by id */
+    static bool read(FOCMotor* motor, uint8_t id, float* value);
+    /** Write the register by id */
+    static bool write(FOCMotor* motor, uint8_t id, float value);
+
+    /**
+     * Bulk read of multiple registers
+     * @param ids    - register ids
+     * @param values - read values (unavailable registers are set to NOT_SET)
+     * @param n      - number of registers
+     * @returns number of successfully read registers
+     */
+    static int read(FOCMotor* motor, const uint8_t* ids, float* values, int n);
+    /**
+     * Bulk write of multiple registers
+     * @returns number of successfully written registers
+     */
+    static int write(FOCMotor* motor, const uint8_t* ids, const float* values, int n);
+
+    /**
+     * Dump the motor configuration (all REGISTER_CONFIG registers in the table order)
+     * @param values - configuration buffer, at least configSize() long
+     * @returns number of values written
+     */
+    static int dump(FOCMotor* motor, float* values);
+    /**
+     * Restore the motor configuration dumped with dump()
+     * @returns number of restored registers
+     */
+    static int restore(FOCMotor* motor, const float* values);
+    /** number of configuration registers */
+    static int configSize();
+};
+
+#endif
@@ -1,125 +1,205 @@
 
+
 #include "SimpleFOCDebug.h"
+#include "../common/time_utils.h"
 
 #ifndef SIMPLEFOC_DISABLE_DEBUG
 
+// record type flags
+#define _DBG_MSG_RAM     0x01
+#define _DBG_MSG_FLASH   0x02
+#define _DBG_VAL_FLOAT   0x04
+#define _DBG_VAL_INT     0x08
+#define _DBG_VAL_CHAR    0x0C
+#define _DBG_VAL_MASK    0x0C
+#define _DBG_NEWLINE     0x10
+
+#define _DBG_MASK (SIMPLEFOC_DEBUG_BUFFER_SIZE - 1)
+
+// critical section of the deferred buffer - _write() is called from the ISRs, with the interrupts
+// already disabled and (on the dual core MCUs) from both cores, so the previous interrupt state is restored
+#if defined(ESP_H) && defined(ARDUINO_ARCH_ESP32)
+static portMUX_TYPE _dbg_lock = portMUX_INITIALIZER_UNLOCKED;
+#define _DBG_LOCK_STATE
+#define _DBG_LOCK()   portENTER_CRITICAL_SAFE(&_dbg_lock)
+#define _DBG_UNLOCK() portEXIT_CRITICAL_SAFE(&_dbg_lock)
+#elif defined(TARGET_RP2040)
+#include "hardware/sync.h"
+static spin_lock_t* _dbg_lock = spin_lock_init(spin_lock_claim_unused(true));
+#define _DBG_LOCK_STATE uint32_t _dbg_state
+#define _DBG_LOCK()   _dbg_state = spin_lock_blocking(_dbg_lock)
+#define _DBG_UNLOCK() spin_unlock(_dbg_lock, _dbg_state)
+#elif defined(__AVR__)
+#define _DBG_LOCK_STATE uint8_t _dbg_state
+#define _DBG_LOCK()   _dbg_state = SREG; cli()
+#define _DBG_UNLOCK() SREG = _dbg_state
+#elif defined(__arm__)
+#define _DBG_LOCK_STATE uint32_t _dbg_state
+#define _DBG_LOCK()   __asm__ volatile ("mrs %0, primask\n cpsid i" : "=r" (_dbg_state) :: "memory")
+#define _DBG_UNLOCK() __asm__ volatile ("msr primask, %0" :: "r" (_dbg_state) : "memory")
+#else
+// generic - re-enables the interrupts on exit
+#define _DBG_LOCK_STATE
+#define _DBG_LOCK()   noInterrupts()
+#define _DBG_UNLOCK() interrupts()
+#endif
+
 
 Print* SimpleFOCDebug::_debugPrint = NULL;
+bool SimpleFOCDebug::_deferred = false;
+SimpleFOCDebugRecord_s SimpleFOCDebug::_buffer[SIMPLEFOC_DEBUG_BUFFER_SIZE];
+volatile uint8_t SimpleFOCDebug::_head = 0;
+volatile uint8_t SimpleFOCDebug::_tail = 0;
+bool SimpleFOCDebug::_line_start = true;
+volatile unsigned long SimpleFOCDebug::dropped = 0;
+bool SimpleFOCDebug::timestamps = false;
 
 
-void SimpleFOCDebug::enable(Print* debugPrint) {
+void SimpleFOCDebug::enable(Print* debugPrint, bool deferred) {
     _debugPrint = debugPrint;
+    _deferred = deferred;
 }
 
 
-void SimpleFOCDebug::println(int val) {
-    if (_debugPrint != NULL) {
-        _debugPrint->println(val);
+void SimpleFOCDebug::_write(uint8_t type, const void* msg, float f, int i, char c) {
+    if (_debugPrint == NULL) return;
+    SimpleFOCDebugRecord_s record;
+    record.msg = msg;
+    record.type = type;
+    switch (type & _DBG_VAL_MASK) {
+        case _DBG_VAL_FLOAT: record.value.f = f; break;
+        case _DBG_VAL_INT: record.value.i = i; break;
+        case _DBG_VAL_CHAR: record.value.c = c; break;
+    }
+    if (!_deferred) {
+        _output(record);
+        return;
+    }
+    record.timestamp = _micros();
+    // the messages can come from the ISRs - reserve the slot and copy the record atomically
+    _DBG_LOCK_STATE;
+    _DBG_LOCK();
+    uint8_t next = (_head + 1) & _DBG_MASK;
+    if (next == _tail) {
+        dropped++;
+    } else {
+        _buffer[_head] = record;
+        _head = next;
     }
+    _DBG_UNLOCK();
 }
 
-void SimpleFOCDebug::println(float val) {
-    if (_debugPrint != NULL) {
-        _debugPrint->println(val);
+
+void SimpleFOCDebug::_output(const SimpleFOCDebugRecord_s& record) {
+    if (_deferred && timestamps && _line_start) {
+        _debugPrint->print('[');
+        _debugPrint->print(record.timestamp);
+        _debugPrint->print(F("] "));
     }
+    if (record.type & _DBG_MSG_FLASH) _debugPrint->print((const __FlashStringHelper*)record.msg);
+    else if (record.type & _DBG_MSG_RAM) _debugPrint->print((const char*)record.msg);
+    switch (record.type & _DBG_VAL_MASK) {
+        case _DBG_VAL_FLOAT: _debugPrint->print(record.value.f); break;
+        case _DBG_VAL_INT: _debugPrint->print(record.value.i); break;
+        case _DBG_VAL_CHAR: _debugPrint->print(record.value.c); break;
+    }
+    if (record.type & _DBG_NEWLINE) _debugPrint->println();
+    _line_start = record.type & _DBG_NEWLINE;
+}
+
+
+int SimpleFOCDebug::drain(int max_records) {
+    int count = 0;
+    // consumer side - only the drain modifies the tail
+    while (_debugPrint != NULL && _tail != _head && count < max_records) {
+        _output(_buffer[_tail]);
+        _tail = (_tail + 1) & _DBG_MASK;
+        count++;
+    }
+    return count;
+}
+
+
+void SimpleFOCDebug::println(int val) {
+    _write(_DBG_VAL_INT | _DBG_NEWLINE, NULL, 0, val);
+}
+
+void SimpleFOCDebug::println(float val) {
+    _write(_DBG_VAL_FLOAT | _DBG_NEWLINE, NULL, val);
 }
 
 
 
 void SimpleFOCDebug::println(const char* str) {
-    if (_debugPrint != NULL) {
-        _debugPrint->println(str);
-    }
+    _write(_DBG_MSG_RAM | _DBG_NEWLINE, str);
 }
 
 void SimpleFOCDebug::println(const __FlashStringHelper* str) {
-    if (_debugPrint != NULL) {
-        _debugPrint->println(str);
-    }
+    _write(_DBG_MSG_FLASH | _DBG_NEWLINE, str);
 }
 
 
 void SimpleFOCDebug::println(const char* str, float val) {
-    if (_debugPrint != NULL) {
-        _debugPrint->print(str);
-        _debugPrint->println(val);
-    }
+    _write(_DBG_MSG_RAM | _DBG_VAL_FLOAT | _DBG_NEWLINE, str, val);
 }
 
 void SimpleFOCDebug::println(const __FlashStringHelper* str, float val) {
-    if (_debugPrint != NULL) {
-        _debugPrint->print(str);
-        _debugPrint->println(val);
-    }
+    _write(_DBG_MSG_FLASH | _DBG_VAL_FLOAT | _DBG_NEWLINE, str, val);
 }
 
 void SimpleFOCDebug::println(const char* str, int val) {
-    if (_debugPrint != NULL) {
-        _debugPrint->print(str);
-        _debugPrint->println(val);
-    }
+    _write(_DBG_MSG_RAM | _DBG_VAL_INT | _DBG_NEWLINE, str, 0, val);
 }
 void SimpleFOCDebug::println(const char* str, char val) {
-    if (_debugPrint != NULL) {
-        _debugPrint->print(str);
-        _debugPrint->println(val);
-    }
+    _write(_DBG_MSG_RAM | _DBG_VAL_CHAR | _DBG_NEWLINE, str, 0, 0, val);
 }
 
 void SimpleFOCDebug::println(const __FlashStringHelper* str, int val) {
-    if (_debugPrint != NULL) {
-        _debugPrint->print(str);
-        _debugPrint->println(val);
-    }
+    _write(_DBG_MSG_FLASH | _DBG_VAL_INT | _DBG_NEWLINE, str, 0, val);
 }
 
 
 void SimpleFOCDebug::print(const char* str) {
-    if (_debugPrint != NULL) {
-        _debugPrint->print(str);
-    }
+    _write(_DBG_MSG_RAM, str);
 }
 
 
 void SimpleFOCDebug::print(const __FlashStringHelper* str) {
-    if (_debugPrint != NULL) {
-        _debugPrint->print(str);
-    }
+    _write(_DBG_MSG_FLASH, str);
 }
 
 void SimpleFOCDebug::print(const StringSumHelper str) {
     if (_debugPrint != NULL) {
+        // run-time built string cannot be deferred - keep the order of the messages
+        drain();
         _debugPrint->print(str.c_str());
+        _line_start = false;
     }
 }
 
 
 void SimpleFOCDebug::println(const StringSumHelper str) {
     if (_debugPrint != NULL) {
+        drain();
         _debugPrint->println(str.c_str());
+        _line_start = true;
     }
 }
 
 
 
 void SimpleFOCDebug::print(int val) {
-    if (_debugPrint != NULL) {
-        _debugPrint->print(val);
-    }
+    _write(_DBG_VAL_INT, NULL, 0, val);
 }
 
 
 void SimpleFOCDebug::print(float val) {
-    if (_debugPrint != NULL) {
-        _debugPrint->print(val);
-    }
+    _write(_DBG_VAL_FLOAT, NULL, val);
 }
 
 
 void SimpleFOCDebug::println() {
-    if (_debugPrint != NULL) {
-        _debugPrint->println();
-    }
+    _write(_DBG_NEWLINE, NULL);
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -30,15 +30,72 @@
  * Add -DSIMPLEFOC_DISABLE_DEBUG to your compiler flags to disable debug in
  * this way.
  * 
+ * Messages have severity levels, the ones above SIMPLEFOC_DEBUG_LEVEL are
+ * removed from the compiled code:
+ *   SIMPLEFOC_ERROR("MOT: Init FOC failed.");   // SIMPLEFOC_LEVEL_ERROR
+ *   SIMPLEFOC_WARN("MOT: No sensor.");          // SIMPLEFOC_LEVEL_WARN
+ *   SIMPLEFOC_DEBUG("MOT: Align sensor.");      // SIMPLEFOC_LEVEL_DEBUG
+ * Add -DSIMPLEFOC_DEBUG_LEVEL=1 to your compiler flags to keep only the errors.
+ * 
+ * Deferred output: enable(&Serial, true) stores each message as a compact
+ * record (message pointer, value, timestamp) in a ring buffer instead of
+ * printing it, which is safe from any context, including ISRs, and never blocks.
+ * The records are formatted and printed later by calling drain(), for example
+ * in the idle part of the loop(). If the buffer is full the message is dropped
+ * and counted in dropped. In deferred mode the const char* messages must be
+ * string literals (they are printed later); run-time built strings (String)
+ * are printed immediately, after draining the buffer.
+ * 
  **/
 
 // #define SIMPLEFOC_DISABLE_DEBUG
 
+// severity levels
+#define SIMPLEFOC_LEVEL_ERROR 1
+#define SIMPLEFOC_LEVEL_WARN  2
+#define SIMPLEFOC_LEVEL_DEBUG 3
+
+#ifndef SIMPLEFOC_DEBUG_LEVEL
+#define SIMPLEFOC_DEBUG_LEVEL SIMPLEFOC_LEVEL_DEBUG
+#endif
+
+// number of records of the deferred output - must be a power of 2
+#ifndef SIMPLEFOC_DEBUG_BUFFER_SIZE
+#define SIMPLEFOC_DEBUG_BUFFER_SIZE 16
+#endif
+// uint8_t indexes - at most 256 records
+static_assert(SIMPLEFOC_DEBUG_BUFFER_SIZE >= 2 && (SIMPLEFOC_DEBUG_BUFFER_SIZE & (SIMPLEFOC_DEBUG_BUFFER_SIZE - 1)) == 0 && SIMPLEFOC_DEBUG_BUFFER_SIZE <= 256,
+              "SIMPLEFOC_DEBUG_BUFFER_SIZE must be a power of 2 between 2 and 256");
+
 #ifndef SIMPLEFOC_DISABLE_DEBUG 
 
+/**
+ * Deferred debug output record
+ */
+struct SimpleFOCDebugRecord_s {
+    unsigned long timestamp; //!< time of the message [us]
+    const void* msg; //!< message - string literal or flash string
+    union {
+        float f;
+        int i;
+        char c;
+    } value; //!< value printed after the message
+    uint8_t type; //!< message, value and newline flags
+};
+
 class SimpleFOCDebug {
 public:
-    static void enable(Print* debugPrint = &Serial);
+    /**
+     * @param debugPrint - output
+     * @param deferred - store the messages in the ring buffer, printed by drain()
+     */
+    static void enable(Print* debugPrint = &Serial, bool deferred = false);
+    /**
+     * Print the buffered messages (deferred output)
+     * @param max_records - maximal number of messages printed in this call
+     * @returns number of printed messages
+     */
+    static int drain(int max_records = SIMPLEFOC_DEBUG_BUFFER_SIZE);
 
     static void println(const __FlashStringHelper* msg);
     static void println(const StringSumHelper msg);
@@ -58,19 +115,51 @@ public:
     static void print(int val);
     static void print(float val);
 
+    static volatile unsigned long dropped; //!< number of messages dropped because the buffer was full
+    static bool timestamps; //!< prefix the lines with the message timestamp [us] (deferred output)
+
 protected:
     static Print* _debugPrint;
+    static bool _deferred;
+    static SimpleFOCDebugRecord_s _buffer[SIMPLEFOC_DEBUG_BUFFER_SIZE];
+    static volatile uint8_t _head;
+    static volatile uint8_t _tail;
+    static bool _line_start;
+
+    // buffer the message or print it directly
+    static void _write(uint8_t type, const void* msg, float f = 0, int i = 0, char c = 0);
+    static void _output(const SimpleFOCDebugRecord_s& record);
 };
 
 
+#if SIMPLEFOC_DEBUG_LEVEL >= SIMPLEFOC_LEVEL_DEBUG
 #define SIMPLEFOC_DEBUG(msg, ...) \
     SimpleFOCDebug::println(F(msg), ##__VA_ARGS__)
+#else
+#define SIMPLEFOC_DEBUG(msg, ...)
+#endif
+
+#if SIMPLEFOC_DEBUG_LEVEL >= SIMPLEFOC_LEVEL_WARN
+#define SIMPLEFOC_WARN(msg, ...) \
+    SimpleFOCDebug::println(F(msg), ##__VA_ARGS__)
+#else
+#define SIMPLEFOC_WARN(msg, ...)
+#endif
+
+#if SIMPLEFOC_DEBUG_LEVEL >= SIMPLEFOC_LEVEL_ERROR
+#define SIMPLEFOC_ERROR(msg, ...) \
+    SimpleFOCDebug::println(F(msg), ##__VA_ARGS__)
+#else
+#define SIMPLEFOC_ERROR(msg, ...)
+#endif
 
 #else //ifndef SIMPLEFOC_DISABLE_DEBUG
 
 
 
 #define SIMPLEFOC_DEBUG(msg, ...)
+#define SIMPLEFOC_WARN(msg, ...)
+#define SIMPLEFOC_ERROR(msg, ...)
 
 
 
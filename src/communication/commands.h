@@ -18,6 +18,10 @@
  #define CMD_INDUCTANCE    'I' //!< motor phase inductance
  #define CMD_KV_RATING 'K' //!< motor kv rating
  #define CMD_PWMMOD   'W' //!< pwm modulation
+ #define CMD_POLE_PAIRS 'P' //!< motor pole pairs
+ #define CMD_CURRENT_SENSE 'G' //!< current sense gains & offsets
+ #define CMD_CONFIG    'X' //!< motor configuration dump
+ #define CMD_FIELD_WEAKENING 'F' //!< field weakening & MTPA
 
  // commander configuration
  #define CMD_SCAN    '?' //!< command scaning the network - only for commander
@@ -39,6 +43,30 @@
  //sensor
  #define SCMD_SENS_MECH_OFFSET 'M' //!< Sensor offset
  #define SCMD_SENS_ELEC_OFFSET 'E' //!< Sensor electrical zero offset
+ #define SCMD_SENS_DIRECTION   'D' //!< Sensor direction
+ #define SCMD_SENS_ALIGN_VOLT  'A' //!< Sensor alignment voltage
+ #define SCMD_SENS_INDEX_VEL   'I' //!< Index search velocity
+ #define SCMD_SENS_MIN_TIME    'T' //!< Sensor velocity minimal elapsed time
+ // current sense
+ #define SCMD_CS_GAIN_A     'A' //!< Phase A gain
+ #define SCMD_CS_GAIN_B     'B' //!< Phase B gain
+ #define SCMD_CS_GAIN_C     'C' //!< Phase C gain
+ #define SCMD_CS_OFFSET_A   'X' //!< Phase A offset
+ #define SCMD_CS_OFFSET_B   'Y' //!< Phase B offset
+ #define SCMD_CS_OFFSET_C   'Z' //!< Phase C offset
+ #define SCMD_CS_SKIP_ALIGN 'S' //!< Skip the current sense alignment
+ // field weakening
+ #define SCMD_FW_MARGIN     'M' //!< Voltage margin
+ #define SCMD_FW_KI         'I' //!< Feedback integral gain
+ #define SCMD_FW_LIMIT      'L' //!< Maximal negative d current
+ #define SCMD_FW_SALIENCY   'S' //!< Saliency ratio Lq/Ld
+ #define SCMD_FW_CURRENT_D  'D' //!< Feedback d current (read only)
+ // frequency response
+ #define SCMD_FR_TARGET     'T' //!< Injection point (0 - current, 1 - velocity, 2 - voltage)
+ #define SCMD_FR_AMPLITUDE  'A' //!< Perturbation amplitude
+ #define SCMD_FR_START      'S' //!< Start the sweep (f_start f_end points)
+ #define SCMD_FR_STOP       'X' //!< Stop the sweep
+ #define SCMD_FR_GET        'G' //!< Get the new measured points (frequency;gain;phase)
  // monitoring
  #define SCMD_DOWNSAMPLE 'D' //!< Monitoring downsample value
  #define SCMD_CLEAR      'C' //!< Clear all monitored variables
@@ -48,5 +76,14 @@
  #define SCMD_PWMMOD_TYPE   'T'  //!<< Pwm modulation type
  #define SCMD_PWMMOD_CENTER 'C'  //!<< Pwm modulation center flag
 
+ // binary protocol
+ #define BIN_OP_READ    0x10 //!< read register - followed by the register address (2 bytes)
+ #define BIN_OP_WRITE   0x20 //!< write register - followed by the register address (2 bytes) and the float value (4 bytes)
+ #define BIN_OP_READ_ID  0x30 //!< read register - followed by the register id (1 byte, see RegisterMap.h)
+ #define BIN_OP_WRITE_ID 0x40 //!< write register - followed by the register id (1 byte) and the float value (4 bytes)
+ #define BIN_OP_MASK    0xF0 //!< opcode bits of the operation byte - the low 4 bits are the motor index
+ #define BIN_STATUS_OK  0x00 //!< operation executed
+ #define BIN_STATUS_ERR 0x01 //!< unknown motor, register or opcode
+
 
 #endif
\ No newline at end of file
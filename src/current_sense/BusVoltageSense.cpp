@@ -0,0 +1,99 @@
+#include "BusVoltageSense.h"
+#include "../communication/SimpleFOCDebug.h"
+
+// BusVoltageSense 构造函数
+//  - pin     - 母线电压 ADC 引脚
+//  - gain    - 分压比
+//  - offset  - 电压偏移
+BusVoltageSense::BusVoltageSense(int _pin, float _gain, float _offset) {
+    pin = _pin;
+    gain = _gain;
+    offset = _offset;
+}
+
+// 链接驱动器
+void BusVoltageSense::linkDriver(FOCDriver* _driver) {
+    driver = _driver;
+}
+
+// 初始化函数
+int BusVoltageSense::init() {
+    // 与 inline 电流检测相同的 ADC 读取
+    // 单个 ADC 引擎的硬件（例如 RP2040）在电流检测初始化之后无法添加引脚 - 此时配置失败
+    params = _configureADCInline(driver ? driver->params : nullptr, pin, NOT_SET, NOT_SET);
+    if (params == SIMPLEFOC_CURRENT_SENSE_INIT_FAILED) {
+        SIMPLEFOC_ERROR("BUS: ADC 初始化失败 - 在电流检测 init() 之前调用？");
+        params = nullptr;
+        return 0;
+    }
+    // 检查引脚是否被转换 - 未转换的引脚读取为 NaN
+    float v = readVoltage();
+    if (!(v == v)) {
+        SIMPLEFOC_ERROR("BUS: ADC 读取无效 - 在电流检测 init() 之前调用？");
+        params = nullptr;
+        return 0;
+    }
+    // 驱动器配置的电压限制 - 母线电压较高时恢复
+    if (driver) driver_voltage_limit = driver->voltage_limit;
+    // 滤波器稳定
+    for (int i = 0; i < 100; i++) {
+        voltage = LPF_voltage(readVoltage());
+        _delay(1);
+    }
+    SIMPLEFOC_DEBUG("BUS: 电压: ", voltage);
+    read_timestamp = _micros();
+    updateState();
+    return 1;
+}
+
+// 读取未滤波的母线电压
+float BusVoltageSense::readVoltage() {
+    return _readADCVoltageInline(pin, params) * gain + offset;
+}
+
+// 读取母线电压并更新驱动器
+float BusVoltageSense::update() {
+    if (params == nullptr) return voltage;
+    // 下采样（可选）
+    if (downsample_cnt++ < downsample) return voltage;
+    downsample_cnt = 0;
+    // 最小读取间隔 - 阻塞的 ADC 读取不在每次 loopFOC() 中执行
+    unsigned long now_us = _micros();
+    if ((now_us - read_timestamp) * 1e-6f < min_interval) return voltage;
+    read_timestamp = now_us;
+
+    // 无效的读取（NaN）不进入滤波器
+    float v = readVoltage();
+    if (!(v == v)) return voltage;
+    voltage = LPF_voltage(v);
+    updateState();
+
+    // 测量错误时不更新驱动器 - 不会把占空比放大到无穷
+    if (driver && voltage >= min_voltage) {
+        // 电压限制在运行时被修改（例如通过 Commander）- 作为新的配置值
+        if (driver->voltage_limit != voltage_limit_written) driver_voltage_limit = driver->voltage_limit;
+        // 驱动器只在电源电压改变时重新计算占空比比例
+        driver->voltage_power_supply = voltage;
+        driver->voltage_limit = (_isset(driver_voltage_limit) && driver_voltage_limit < voltage) ? driver_voltage_limit : voltage;
+        voltage_limit_written = driver->voltage_limit;
+    }
+    return voltage;
+}
+
+// 欠压/过压状态 - 带滞回
+void BusVoltageSense::updateState() {
+    BusVoltageState new_state = state;
+    if (_isset(overvoltage) && voltage > overvoltage)
+        new_state = BUS_OVERVOLTAGE;
+    else if (_isset(undervoltage) && voltage < undervoltage)
+        new_state = BUS_UNDERVOLTAGE;
+    else if ((!_isset(overvoltage) || voltage < overvoltage - hysteresis)
+          && (!_isset(undervoltage) || voltage > undervoltage + hysteresis))
+        new_state = BUS_VOLTAGE_OK;
+
+    if (new_state == state) return;
+    state = new_state;
+    if (state == BUS_UNDERVOLTAGE) SIMPLEFOC_WARN("BUS: 欠压: ", voltage);
+    else if (state == BUS_OVERVOLTAGE) SIMPLEFOC_WARN("BUS: 过压: ", voltage);
+    if (onStateChange) onStateChange(state, voltage);
+}
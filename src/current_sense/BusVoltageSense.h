@@ -0,0 +1,91 @@
+#ifndef BUS_VOLTAGE_SENSE_H
+#define BUS_VOLTAGE_SENSE_H
+
+#include "Arduino.h"
+#include "../common/foc_utils.h"
+#include "../common/time_utils.h"
+#include "../common/lowpass_filter.h"
+#include "../common/base_classes/FOCDriver.h"
+#include "hardware_api.h"
+
+// 母线电压状态
+enum BusVoltageState : uint8_t {
+  BUS_VOLTAGE_OK = 0,   //!< 电压在范围内
+  BUS_UNDERVOLTAGE = 1, //!< 欠压
+  BUS_OVERVOLTAGE = 2,  //!< 过压
+};
+
+// 母线电压状态改变回调
+typedef void (*BusVoltageCallback)(BusVoltageState state, float voltage);
+
+/**
+ * 直流母线电压测量和补偿
+ *
+ *  - 通过分压器读取母线电压 ADC 引脚，滤波后写入驱动器的 voltage_power_supply，
+ *    使施加到电机的电压（以及电流环增益）不随母线电压变化
+ *  - 驱动器的 voltage_limit 被限制在测量的母线电压以内
+ *  - 欠压/过压检测带滞回，状态改变时调用 onStateChange 回调
+ *  - 与电机链接时在 loopFOC() 中与相电流一起采样，也可以手动调用 update()
+ *  - 大多数硬件上读取是阻塞的 analogRead() - 默认每 min_interval 最多读取一次，不会降低 loopFOC() 的频率
+ *  - 只有一个 ADC 引擎的硬件（例如 RP2040）在第一次初始化时确定转换的引脚，
+ *    必须在电流检测的 init() 之前调用 bus.init()，否则 init() 返回失败
+ *
+ * 示例:
+ *    BusVoltageSense bus(A2, 11.0f); // 10k/1k 分压器
+ *    driver.init();
+ *    bus.linkDriver(&driver);
+ *    bus.undervoltage = 9.0f;
+ *    bus.init();
+ *    motor.linkBusVoltage(&bus);
+ */
+class BusVoltageSense
+{
+  public:
+    /**
+     * @param pin - 母线电压 ADC 引脚
+     * @param gain - 分压比 母线电压/引脚电压，例如 (R1+R2)/R2
+     * @param offset - 电压偏移 [V]
+     */
+    BusVoltageSense(int pin, float gain, float offset = 0);
+
+    /** 配置 ADC 并读取初始电压 - 在 driver.init() 之后调用 */
+    int init();
+    /** 链接驱动器 - 每次 update() 更新它的 voltage_power_supply 和 voltage_limit */
+    void linkDriver(FOCDriver* driver);
+    /**
+     * 读取母线电压，滤波，更新驱动器和状态
+     * @returns 滤波后的母线电压 [V]
+     */
+    float update();
+
+    float voltage = 0; //!< 滤波后的母线电压 [V]
+    float gain; //!< 分压比
+    float offset; //!< 电压偏移 [V]
+    float min_voltage = 1.0f; //!< 写入驱动器的最低电压 [V] - 更低的测量不更新驱动器，避免占空比过大
+    float undervoltage = NOT_SET; //!< 欠压阈值 [V]
+    float overvoltage = NOT_SET; //!< 过压阈值 [V]
+    float hysteresis = 0.5f; //!< 恢复到正常状态的滞回 [V]
+    unsigned int downsample = 0; //!< 每 downsample+1 次 update() 读取一次 ADC
+    float min_interval = 1e-3f; //!< 两次 ADC 读取的最小间隔 [s] - 0 每次 update() 都读取
+
+    BusVoltageState state = BUS_VOLTAGE_OK; //!< 当前状态
+    BusVoltageCallback onStateChange = nullptr; //!< 状态改变回调（可选）
+
+    LowPassFilter LPF_voltage{0.005f}; //!< 母线电压低通滤波器
+
+  protected:
+    int pin; //!< ADC 引脚
+    void* params = nullptr; //!< ADC 硬件特定参数
+    FOCDriver* driver = nullptr; //!< 链接的驱动器
+    float driver_voltage_limit = NOT_SET; //!< 驱动器配置的电压限制 [V]
+    float voltage_limit_written = NOT_SET; //!< 上一次写入驱动器的电压限制 [V] - 不同时说明配置被修改
+    unsigned int downsample_cnt = 0; //!< 下采样计数器
+    unsigned long read_timestamp = 0; //!< 上一次 ADC 读取的时间 [us]
+
+    /** 读取未滤波的母线电压 [V] */
+    float readVoltage();
+    /** 更新欠压/过压状态 */
+    void updateState();
+};
+
+#endif
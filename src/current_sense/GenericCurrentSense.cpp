@@ -62,3 +62,9 @@ int GenericCurrentSense::driverAlign(float voltage, bool modulation_centered){
     if (!initialized) return 0;
     return exit_flag;
 }
+
+// 非阻塞对齐 - 同样不需要对齐，结果立即可用
+int GenericCurrentSense::alignStart(float voltage, bool modulation_centered){
+    align_result = driverAlign(voltage, modulation_centered);
+    return align_result;
+}
@@ -20,6 +20,7 @@ class GenericCurrentSense: public CurrentSense {
     int init() override;  // 初始化
     PhaseCurrent_s getPhaseCurrents() override;  // 获取相电流
     int driverAlign(float align_voltage, bool modulation_centered) override;  // 驱动对齐
+    int alignStart(float align_voltage, bool modulation_centered) override;  // 非阻塞驱动对齐
 
     PhaseCurrent_s (*readCallback)() = nullptr; //!< 指向传感器读取的函数指针
     void (*initCallback)() = nullptr; //!< 指向传感器初始化的函数指针
@@ -38,8 +38,22 @@ int InlineCurrentSense::init() {
     // 如果没有连接的驱动器，在这种情况下是可以的
     // 至少对于初始化（init()）是可以的
     void* drv_params = driver ? driver->params : nullptr;
+    synced = false;
+    // PWM 同步采样 - 使用低侧检测的定时器触发 ADC
+    if (pwm_sync && driver != nullptr) {
+        params = _configureADCLowSide(drv_params, pinA, pinB, pinC);
+        if (params != SIMPLEFOC_CURRENT_SENSE_INIT_FAILED) {
+            // 同步驱动器
+            if (_driverSyncLowSide(drv_params, params) == SIMPLEFOC_CURRENT_SENSE_INIT_FAILED) return 0;
+            synced = true;
+        } else {
+            SIMPLEFOC_WARN("CUR: 不支持同步采样，使用异步采样");
+        }
+    } else if (pwm_sync) {
+        SIMPLEFOC_WARN("CUR: 同步采样需要链接驱动器");
+    }
     // 配置 ADC 变量
-    params = _configureADCInline(drv_params, pinA, pinB, pinC);
+    if (!synced) params = _configureADCInline(drv_params, pinA, pinB, pinC);
     // 如果初始化失败，返回失败
     if (params == SIMPLEFOC_CURRENT_SENSE_INIT_FAILED) return 0; 
     // 设置中心 PWM（0 电压矢量）
@@ -66,9 +80,11 @@ void InlineCurrentSense::calibrateOffsets() {
     offset_ic = 0;
     // 读取 ADC 电压 1000 次（任意数字）
     for (int i = 0; i < calibration_rounds; i++) {
-        if (_isset(pinA)) offset_ia += _readADCVoltageInline(pinA, params);
-        if (_isset(pinB)) offset_ib += _readADCVoltageInline(pinB, params);
-        if (_isset(pinC)) offset_ic += _readADCVoltageInline(pinC, params);
+        float v[3];
+        readADCVoltages(v);
+        offset_ia += v[0];
+        offset_ib += v[1];
+        offset_ic += v[2];
         _delay(1);
     }
     // 计算平均偏移
@@ -80,8 +96,25 @@ void InlineCurrentSense::calibrateOffsets() {
 // 读取所有三个相位电流（如果可能，读取2或3个）
 PhaseCurrent_s InlineCurrentSense::getPhaseCurrents() {
     PhaseCurrent_s current;
-    current.a = (!_isset(pinA)) ? 0 : (_readADCVoltageInline(pinA, params) - offset_ia) * gain_a; // 安培
-    current.b = (!_isset(pinB)) ? 0 : (_readADCVoltageInline(pinB, params) - offset_ib) * gain_b; // 安培
-    current.c = (!_isset(pinC)) ? 0 : (_readADCVoltageInline(pinC, params) - offset_ic) * gain_c; // 安培
+    float v[3];
+    readADCVoltages(v);
+    current.a = (!_isset(pinA)) ? 0 : (v[0] - offset_ia) * gain_a; // 安培
+    current.b = (!_isset(pinB)) ? 0 : (v[1] - offset_ib) * gain_b; // 安培
+    current.c = (!_isset(pinC)) ? 0 : (v[2] - offset_ic) * gain_c; // 安培
     return current;
 }
+
+// 对齐交换相引脚后重新解析各相的 ADC 位置 - 仅同步采样使用
+void InlineCurrentSense::updateADCSlots() {
+    if (synced) _updateADCSlotsLowSide(pinA, pinB, pinC, params);
+}
+
+// 读取所有相的 ADC 电压 - 同步采样返回 PWM 中心的最新采样
+void InlineCurrentSense::readADCVoltages(float* voltages) {
+    if (synced) {
+        _startADC3PinConversionLowSide();
+        _readADCVoltagesLowSide(pinA, pinB, pinC, params, voltages);
+        return;
+    }
+    _readADCVoltagesInline(pinA, pinB, pinC, params, voltages);
+}
@@ -36,7 +36,19 @@ class InlineCurrentSense: public CurrentSense {
     int init() override;
     PhaseCurrent_s getPhaseCurrents() override;
 
+    /**
+     * PWM 同步采样 - 在 init() 之前设置
+     * ADC 由 PWM 定时器在 PWM 中心（零电压矢量）触发，getPhaseCurrents() 读取最新的同步采样，
+     * PWM 纹波不会混叠到电流中。使用与低侧电流检测相同的硬件函数，需要链接驱动器，
+     * 不支持低侧检测的芯片回退到异步采样
+     */
+    bool pwm_sync = false;
+
+  protected:
+    void updateADCSlots() override;
+
   private:
+    bool synced = false; //!< 是否使用 PWM 同步采样
   
     // 增益变量
     float shunt_resistor; //!< 旁路电阻值
@@ -47,6 +59,8 @@ class InlineCurrentSense: public CurrentSense {
      *  查找 ADC 零偏移的函数
      */
     void calibrateOffsets();
+    /** 读取所有相的 ADC 电压 - 同步或异步采样，未设置的引脚为 0 */
+    void readADCVoltages(float* voltages);
 };
 
 #endif
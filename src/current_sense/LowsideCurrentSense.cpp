@@ -73,9 +73,11 @@ void LowsideCurrentSense::calibrateOffsets(){
     // 读取 ADC 电压 1000 次（任意数字）
     for (int i = 0; i < calibration_rounds; i++) {
         _startADC3PinConversionLowSide();
-        if (_isset(pinA)) offset_ia += (_readADCVoltageLowSide(pinA, params));
-        if (_isset(pinB)) offset_ib += (_readADCVoltageLowSide(pinB, params));
-        if (_isset(pinC)) offset_ic += (_readADCVoltageLowSide(pinC, params));
+        float v[3];
+        _readADCVoltagesLowSide(pinA, pinB, pinC, params, v);
+        offset_ia += v[0];
+        offset_ib += v[1];
+        offset_ic += v[2];
         _delay(1);
     }
     // 计算平均偏差
@@ -88,8 +90,16 @@ void LowsideCurrentSense::calibrateOffsets(){
 PhaseCurrent_s LowsideCurrentSense::getPhaseCurrents(){
     PhaseCurrent_s current;
     _startADC3PinConversionLowSide();
-    current.a = (!_isset(pinA)) ? 0 : (_readADCVoltageLowSide(pinA, params) - offset_ia) * gain_a; // 安培
-    current.b = (!_isset(pinB)) ? 0 : (_readADCVoltageLowSide(pinB, params) - offset_ib) * gain_b; // 安培
-    current.c = (!_isset(pinC)) ? 0 : (_readADCVoltageLowSide(pinC, params) - offset_ic) * gain_c; // 安培
+    // 所有相的电压来自同一次采样
+    float v[3];
+    _readADCVoltagesLowSide(pinA, pinB, pinC, params, v);
+    current.a = (!_isset(pinA)) ? 0 : (v[0] - offset_ia) * gain_a; // 安培
+    current.b = (!_isset(pinB)) ? 0 : (v[1] - offset_ib) * gain_b; // 安培
+    current.c = (!_isset(pinC)) ? 0 : (v[2] - offset_ic) * gain_c; // 安培
     return current;
 }
+
+// 对齐交换相引脚后重新解析各相的 ADC 位置
+void LowsideCurrentSense::updateADCSlots(){
+    _updateADCSlotsLowSide(pinA, pinB, pinC, params);
+}
@@ -37,6 +37,9 @@ class LowsideCurrentSense: public CurrentSense {
     int init() override;
     PhaseCurrent_s getPhaseCurrents() override;
 
+  protected:
+    void updateADCSlots() override;
+
   private:
 
     // 增益变量
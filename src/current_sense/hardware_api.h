@@ -35,6 +35,17 @@ float _readADCVoltageInline(const int pinA, const void* cs_params);
  */
 void* _configureADCInline(const void *driver_params, const int pinA, const int pinB, const int pinC = NOT_SET);
 
+/**
+ *  一次读取所有相的 ADC 电压 - 支持的硬件返回同一次转换的结果
+ *
+ * @param pinA - A 相引脚
+ * @param pinB - B 相引脚
+ * @param pinC - C 相引脚
+ * @param cs_params - 电流传感参数结构 - 硬件特定
+ * @param voltages - A, B, C 相的电压 [V] - 未设置的引脚为 0
+ */
+void _readADCVoltagesInline(const int pinA, const int pinB, const int pinC, const void* cs_params, float* voltages);
+
 /**
  *  读取 ADC 值并返回读取的电压
  *
@@ -55,6 +66,38 @@ void _startADC3PinConversionLowSide();
  */
 float _readADCVoltageLowSide(const int pinA, const void* cs_params);
 
+/**
+ *  一次读取所有相的 ADC 电压 - 来自同一次采样
+ *  各相的 ADC 位置由 _updateADCSlotsLowSide() 预先解析，读取时不查找引脚
+ *
+ * @param pinA - A 相引脚
+ * @param pinB - B 相引脚
+ * @param pinC - C 相引脚
+ * @param cs_params - 电流传感参数结构 - 硬件特定
+ * @param voltages - A, B, C 相的电压 [V] - 未设置的引脚为 0
+ */
+void _readADCVoltagesLowSide(const int pinA, const int pinB, const int pinC, const void* cs_params, float* voltages);
+
+/**
+ *  解析 A, B, C 相在 ADC 转换结果中的位置并保存到电流传感参数中
+ *  在 _configureADCLowSide 中以及电流传感对齐交换相引脚后调用
+ *
+ * @param pinA - A 相引脚
+ * @param pinB - B 相引脚
+ * @param pinC - C 相引脚
+ * @param cs_params - 电流传感参数结构 - 硬件特定
+ */
+void _updateADCSlotsLowSide(const int pinA, const int pinB, const int pinC, void* cs_params);
+
+/**
+ *  引脚在配置的 ADC 引脚中的位置（转换顺序） - 供 _updateADCSlotsLowSide() 使用
+ *
+ * @param pin - 要查找的引脚
+ * @param pins - 配置的 3 个引脚
+ * @return 位置 0-2，未设置或未找到时为 -1
+ */
+int _adcPinIndex(const int pin, const int* pins);
+
 /**
  *  将驱动程序与 ADC 同步以进行低侧检测
  * @param driver_params - 驱动参数结构 - 硬件特定
@@ -42,14 +42,28 @@
 */
 
 
+// copy the adc_buffer written by the interrupt - all the phases from the same sampling
+static void _copyADCBuffer(ESP32CurrentSenseParams* p){
+  uint32_t seq;
+  do{
+    seq = p->sequence;
+    for(int i=0; i < p->no_adc_channels; i++) p->adc_read[i] = p->adc_buffer[i];
+    // retry if the interrupt was writing or wrote in the meantime
+  }while((seq & 1) || seq != p->sequence);
+  p->read_sequence = seq;
+}
+
 // function reading an ADC value and returning the read voltage
 float _readADCVoltageLowSide(const int pin, const void* cs_params){
   ESP32CurrentSenseParams* p = (ESP32CurrentSenseParams*)cs_params;
+  // the phases are read one by one - copy the whole buffer when the first one is read
+  // so that all the phases come from the same sampling
+  if(pin == p->pins[0]) _copyADCBuffer(p);
   int no_channel = 0;
   for(int i=0; i < 3; i++){
     if(!_isset(p->pins[i])) continue;
     if(pin == p->pins[i]) // found in the buffer
-      return p->adc_buffer[no_channel] * p->adc_voltage_conv;
+      return p->adc_read[no_channel] * p->adc_voltage_conv;
     else no_channel++;
   }
   SIMPLEFOC_DEBUG("ERROR: ADC pin not found in the buffer!");
@@ -58,6 +72,27 @@ float _readADCVoltageLowSide(const int pin, const void* cs_params){
 }
 
 
+// function reading all the phase voltages at once
+// the buffer index of each phase is resolved by _updateADCSlotsLowSide - no pin search
+void _readADCVoltagesLowSide(const int pinA, const int pinB, const int pinC, const void* cs_params, float* voltages){
+  _UNUSED(pinA);
+  _UNUSED(pinB);
+  _UNUSED(pinC);
+  ESP32CurrentSenseParams* p = (ESP32CurrentSenseParams*)cs_params;
+  _copyADCBuffer(p);
+  for(int i=0; i < 3; i++)
+    voltages[i] = p->slots[i] < 0 ? 0 : p->adc_read[p->slots[i]] * p->adc_voltage_conv;
+}
+
+// resolve the buffer index of the phases - at init and after the alignment swaps the pins
+void _updateADCSlotsLowSide(const int pinA, const int pinB, const int pinC, void* cs_params){
+  ESP32CurrentSenseParams* p = (ESP32CurrentSenseParams*)cs_params;
+  p->slots[0] = _adcPinIndex(pinA, p->pins);
+  p->slots[1] = _adcPinIndex(pinB, p->pins);
+  p->slots[2] = _adcPinIndex(pinC, p->pins);
+}
+
+
 // function configuring low-side current sensing 
 void* _configureADCLowSide(const void* driver_params, const int pinA,const int pinB,const int pinC){
   // check if driver timer is already running 
@@ -94,6 +129,13 @@ void* _configureADCLowSide(const void* driver_params, const int pinA,const int p
   t->user_data = params;
   params->adc_voltage_conv = (_ADC_VOLTAGE)/(_ADC_RESOLUTION);
   params->no_adc_channels = no_adc_channels;
+  // the conversions start at the centre of the valley and have to end before the high-sides switch on
+  // - a quarter of the PWM period leaves the valley long enough up to 50% duty cycle
+  if(params->sample_all && no_adc_channels * SIMPLEFOC_ESP32_CS_ADC_READ_US * 4 * p->pwm_frequency > 1000000L){
+    SIMPLEFOC_ESP32_CS_DEBUG("WARN: Sampling all the channels does not fit in the low-side valley, sampling one channel per PWM period!");
+    params->sample_all = false;
+  }
+  _updateADCSlotsLowSide(pinA, pinB, pinC, params);
   return params;
 }
 
@@ -126,12 +168,27 @@ void* _driverSyncLowSide(void* driver_params, void* cs_params){
       gpio_set_level(GPIO_NUM,1); //cca 250ns for on+off
 #endif
 
-      // sample the phase currents one at a time
       // ESP's adc read takes around 10us which is very long 
-      // increment buffer index
-      p->buffer_index = (p->buffer_index + 1) % p->no_adc_channels;
-      // so we are sampling one phase per call
-      p->adc_buffer[p->buffer_index] = adcRead(p->pins[p->buffer_index]); 
+      if(p->sample_all){
+        // so all the phases are sampled only every sample_divider PWM periods
+        if(++p->period_count >= p->sample_divider){
+          p->period_count = 0;
+          // odd sequence - the buffer is being written
+          p->sequence++;
+          // sample all the phase currents back to back in the same PWM valley
+          for(int i=0; i < p->no_adc_channels; i++)
+            p->adc_buffer[i] = adcRead(p->pins[i]);
+          // even sequence - new coherent sample published
+          p->sequence++;
+        }
+      }else{
+        // or we are sampling one phase per call
+        p->sequence++;
+        // increment buffer index
+        p->buffer_index = (p->buffer_index + 1) % p->no_adc_channels;
+        p->adc_buffer[p->buffer_index] = adcRead(p->pins[p->buffer_index]); 
+        p->sequence++;
+      }
 
 #ifdef SIMPLEFOC_ESP32_INTERRUPT_DEBUG // debugging toggle pin to measure the time of the interrupt with oscilloscope
       gpio_set_level(GPIO_NUM,0); //cca 250ns for on+off
@@ -10,13 +10,43 @@
 #include "esp32_adc_driver.h"
 
 
+/**
+ * Low-side sampling options - compile time only (define them in the build flags)
+ *
+ * SIMPLEFOC_ESP32_CS_SAMPLE_ALL (default 0)
+ *  - 0 - convert one channel per PWM period, in the low-side valley (samples up to two periods apart)
+ *  - 1 - convert all the channels back to back every SIMPLEFOC_ESP32_CS_SAMPLE_DIVIDER PWM periods (coherent phase currents)
+ *        each adcRead() takes about SIMPLEFOC_ESP32_CS_ADC_READ_US, so the later channels are converted later in the period,
+ *        only use it with PWM frequencies where all the conversions fit in the low-side valley
+ *        _configureADCLowSide falls back to 0 if they do not fit in a quarter of the PWM period
+ * SIMPLEFOC_ESP32_CS_SAMPLE_DIVIDER (default 3) - PWM periods between two samplings of all the channels,
+ *        the default keeps the average ADC load of the one channel per period mode
+ * SIMPLEFOC_ESP32_CS_ADC_READ_US (default 10) - duration of one adcRead() [us]
+ */
+#ifndef SIMPLEFOC_ESP32_CS_SAMPLE_ALL
+#define SIMPLEFOC_ESP32_CS_SAMPLE_ALL 0
+#endif
+#ifndef SIMPLEFOC_ESP32_CS_SAMPLE_DIVIDER
+#define SIMPLEFOC_ESP32_CS_SAMPLE_DIVIDER 3
+#endif
+#ifndef SIMPLEFOC_ESP32_CS_ADC_READ_US
+#define SIMPLEFOC_ESP32_CS_ADC_READ_US 10
+#endif
+
 // esp32 current sense parameters
 typedef struct ESP32CurrentSenseParams {
   int pins[3];
   float adc_voltage_conv;
-  int adc_buffer[3] = {};
+  volatile int adc_buffer[3] = {};
   int buffer_index = 0;
   int no_adc_channels = 0;
+  bool sample_all = SIMPLEFOC_ESP32_CS_SAMPLE_ALL; //!< convert all the channels in one PWM period
+  int sample_divider = SIMPLEFOC_ESP32_CS_SAMPLE_DIVIDER; //!< PWM periods between two samplings
+  int period_count = 0; //!< PWM periods since the last sampling
+  volatile uint32_t sequence = 0; //!< odd while the interrupt writes the adc_buffer, incremented by 2 per sampling
+  int adc_read[3] = {}; //!< coherent copy of the adc_buffer used by _readADCVoltageLowSide
+  uint32_t read_sequence = 0; //!< sequence of the adc_read copy
+  int slots[3] = {-1, -1, -1}; //!< adc_buffer index of the phase A, B and C (-1 if not set) - _updateADCSlotsLowSide
 } ESP32CurrentSenseParams;
 
 // macros for debugging wuing the simplefoc debug system
@@ -7,6 +7,14 @@ __attribute__((weak))  float _readADCVoltageInline(const int pinA, const void* c
   return raw_adc * ((GenericCurrentSenseParams*)cs_params)->adc_voltage_conv;
 }
 
+// function reading all the phase voltages at once
+// generic implementation - reads the pins one by one
+__attribute__((weak))  void _readADCVoltagesInline(const int pinA, const int pinB, const int pinC, const void* cs_params, float* voltages){
+  voltages[0] = _isset(pinA) ? _readADCVoltageInline(pinA, cs_params) : 0;
+  voltages[1] = _isset(pinB) ? _readADCVoltageInline(pinB, cs_params) : 0;
+  voltages[2] = _isset(pinC) ? _readADCVoltageInline(pinC, cs_params) : 0;
+}
+
 // function reading an ADC value and returning the read voltage
 __attribute__((weak))  void* _configureADCInline(const void* driver_params, const int pinA,const int pinB,const int pinC){
   _UNUSED(driver_params);
@@ -29,6 +37,31 @@ __attribute__((weak))  float _readADCVoltageLowSide(const int pinA, const void*
   return 0.0;
 }
 
+// function reading all the phase voltages at once
+// generic implementation - reads the pins one by one
+__attribute__((weak))  void _readADCVoltagesLowSide(const int pinA, const int pinB, const int pinC, const void* cs_params, float* voltages){
+  voltages[0] = _isset(pinA) ? _readADCVoltageLowSide(pinA, cs_params) : 0;
+  voltages[1] = _isset(pinB) ? _readADCVoltageLowSide(pinB, cs_params) : 0;
+  voltages[2] = _isset(pinC) ? _readADCVoltageLowSide(pinC, cs_params) : 0;
+}
+
+// resolve the adc slots of the phases
+// generic implementation - the generic low-side read does not use slots
+__attribute__((weak))  void _updateADCSlotsLowSide(const int pinA, const int pinB, const int pinC, void* cs_params){
+  _UNUSED(pinA);
+  _UNUSED(pinB);
+  _UNUSED(pinC);
+  _UNUSED(cs_params);
+}
+
+// position of the pin in the configured adc pins
+int _adcPinIndex(const int pin, const int* pins){
+  if(!_isset(pin)) return -1;
+  for(int i=0; i < 3; i++)
+    if(pins[i] == pin) return i;
+  return -1;
+}
+
 // Configure low side for generic mcu
 // cannot do much but 
 __attribute__((weak))  void* _configureADCLowSide(const void* driver_params, const int pinA,const int pinB,const int pinC){
@@ -16,36 +16,60 @@
 /* Singleton instance of the ADC engine */
 RP2040ADCEngine engine;
 
-alignas(32) const uint32_t trigger_value = ADC_CS_START_ONCE_BITS; // start once
+alignas(32) const uint32_t trigger_value = ADC_CS_START_MANY_BITS; // start back to back conversions
 
 /* Hardware API implementation */
 
 float _readADCVoltageInline(const int pinA, const void* cs_params) {
-    // not super-happy with this. Here we have to return 1 phase current at a time, when actually we want to
-    // return readings from the same ADC conversion run. The ADC on RP2040 is anyway in round robin mode :-(
-    // like this we either have to block interrupts, or of course have the chance of reading across
-    // new ADC conversions, which probably won't improve the accuracy.
     _UNUSED(cs_params);
 
-    if (pinA>=26 && pinA<=29 && engine.channelsEnabled[pinA-26]) {
-        return engine.lastResults.raw[pinA-26]*engine.adc_conv;
-    }
+    if (pinA>=26 && pinA<=29 && engine.channelsEnabled[pinA-26])
+        return engine.getLastResults().raw[pinA-26]*engine.adc_conv;
 
     // otherwise return NaN
     return NAN;
 };
 
 
+// all the phases from the same ADC conversion run - one copy of the results per call
+void _readADCVoltagesInline(const int pinA, const int pinB, const int pinC, const void* cs_params, float* voltages) {
+    _UNUSED(cs_params);
+
+    ADCResults r = engine.getLastResults();
+    const int pins[3] = {pinA, pinB, pinC};
+    for (int i=0; i<3; i++) {
+        if (!_isset(pins[i]))
+            voltages[i] = 0;
+        else if (pins[i]>=26 && pins[i]<=29 && engine.channelsEnabled[pins[i]-26])
+            voltages[i] = r.raw[pins[i]-26]*engine.adc_conv;
+        else
+            voltages[i] = NAN;
+    }
+};
+
+
 void* _configureADCInline(const void *driver_params, const int pinA, const int pinB, const int pinC) {
+#ifdef SIMPLEFOC_RP2040_ADC_PWM_TRIGGER
+    // convert on the PWM wrap of the linked driver - centre of the high side on time (phase correct PWM)
+    if (driver_params != nullptr)
+        engine.setPWMTrigger(((RP2040DriverParams*)driver_params)->slice[0]);
+#else
     _UNUSED(driver_params);
+#endif
 
+    // the conversion of a running engine can not change - only the pins already converted can be shared
+    bool ok = true;
     if( _isset(pinA) )
-        engine.addPin(pinA);
+        ok &= engine.addPin(pinA);
     if( _isset(pinB) )
-        engine.addPin(pinB);
+        ok &= engine.addPin(pinB);
     if( _isset(pinC) )
-        engine.addPin(pinC);
-    engine.init(); // TODO this has to happen later if we want to support more than one motor...
+        ok &= engine.addPin(pinC);
+    if (!ok)
+        return SIMPLEFOC_CURRENT_SENSE_INIT_FAILED;
+    if (engine.initialized)
+        return &engine;
+    engine.init();
     engine.start();
     return &engine;
 };
@@ -95,23 +119,41 @@ void* _configureADCInline(const void *driver_params, const int pinA, const int p
 volatile int rp2040_intcount = 0;
 
 void _adcConversionFinishedHandler() {
-    // conversion of all channels finished. copy results.
-    volatile uint8_t* from = engine.samples;
-    if (engine.channelsEnabled[0])
-        engine.lastResults.raw[0] = (*from++);
-    if (engine.channelsEnabled[1])
-        engine.lastResults.raw[1] = (*from++);
-    if (engine.channelsEnabled[2])
-        engine.lastResults.raw[2] = (*from++);
-    if (engine.channelsEnabled[3])
-        engine.lastResults.raw[3] = (*from++);
-    //dma_channel_acknowledge_irq0(engine.readDMAChannel);
-    dma_hw->ints0 = 1u << engine.readDMAChannel;
-    //dma_start_channel_mask( (1u << engine.readDMAChannel) );
-    dma_channel_set_write_addr(engine.readDMAChannel, engine.samples, true);
-    // if (engine.triggerPWMSlice>=0)
-    //     dma_channel_set_trans_count(engine.triggerDMAChannel, 1, true);
-    rp2040_intcount++;
+    for (int k=0; k<2; k++) {
+        uint channel = engine.readDMAChannel[k];
+        if (!(dma_hw->ints0 & (1u << channel)))
+            continue;
+        //dma_channel_acknowledge_irq0(channel);
+        dma_hw->ints0 = 1u << channel;
+        // free running - the reload channel already re-armed the finished buffer
+        if (engine.triggerPWMSlice>=0) {
+            // re-arm the finished buffer, it is started again after the other one
+            dma_channel_set_write_addr(channel, engine.samples[k], false);
+            // stop the conversions until the next PWM wrap, and throw away the ones converted in the meantime
+            adc_run(false);
+            while (!(adc_hw->cs & ADC_CS_READY_BITS))
+                tight_loop_contents();
+            adc_fifo_drain();
+            // restart the round robin at the first channel
+            adc_select_input(engine.firstChannel);
+            dma_channel_start(engine.readDMAChannel[1-k]);
+            dma_channel_set_trans_count(engine.triggerDMAChannel, 1, true);
+        }
+        // conversion of all channels finished. sum the results to the unused result buffer.
+        volatile ADCResults* next = &engine.results[(engine.sequence + 1) & 1];
+        // the channel list of init() - the one the DMA transfer count and the round robin were set up with
+        uint16_t sum[4] = {0, 0, 0, 0};
+        volatile uint16_t* from = engine.samples[k];
+        for (int n=0; n<engine.oversampling; n++) {
+            for (int j=0; j<engine.channelCount; j++)
+                sum[engine.channels[j]] += (*from++);
+        }
+        for (int i=0; i<4; i++)
+            next->raw[i] = sum[i];
+        // publish the results
+        engine.sequence++;
+        rp2040_intcount++;
+    }
 };
 
 
@@ -129,18 +171,26 @@ RP2040ADCEngine::RP2040ADCEngine() {
 
 
 
-void RP2040ADCEngine::addPin(int pin) {
-    if (pin>=26 && pin<=29)
-        channelsEnabled[pin-26] = true;
-    else
+bool RP2040ADCEngine::addPin(int pin) {
+    if (pin<26 || pin>29) {
         SIMPLEFOC_DEBUG("RP2040-CUR: ERR: Not an ADC pin: ", pin);
+        return false;
+    }
+    if (channelsEnabled[pin-26])
+        return true;
+    if (initialized) {
+        SIMPLEFOC_DEBUG("RP2040-CUR: ERR: Engine running, can not add pin: ", pin);
+        return false;
+    }
+    channelsEnabled[pin-26] = true;
+    return true;
 };
 
 
 
-// void RP2040ADCEngine::setPWMTrigger(uint slice){
-//     triggerPWMSlice = slice;
-// };
+void RP2040ADCEngine::setPWMTrigger(uint slice){
+    triggerPWMSlice = slice;
+};
 
 
 
@@ -151,23 +201,32 @@ bool RP2040ADCEngine::init() {
     
     adc_init();
     int enableMask = 0x00;
-    int channelCount = 0;
-    for (int i = 3; i>=0; i--) {
+    channelCount = 0;
+    // the round robin converts the enabled channels in ascending order
+    for (int i = 0; i<4; i++) {
         if (channelsEnabled[i]){
             adc_gpio_init(i+26);
             enableMask |= (0x01<<i);
-            channelCount++;
+            channels[channelCount++] = i;
         }
     }
+    firstChannel = channelCount ? channels[0] : 0;
+    if (oversampling<1)
+        oversampling = 1;
+    if (oversampling>SIMPLEFOC_RP2040_ADC_MAX_OVERSAMPLING)
+        oversampling = SIMPLEFOC_RP2040_ADC_MAX_OVERSAMPLING;
+    // the results are sums of the conversions
+    adc_conv = SIMPLEFOC_RP2040_ADC_VDDA / SIMPLEFOC_RP2040_ADC_RESOLUTION / oversampling;
     adc_set_round_robin(enableMask);
     adc_fifo_setup(
      true,              // Write each completed conversion to the sample FIFO
      true,              // Enable DMA data request (DREQ)
-     channelCount,      // DREQ (and IRQ) asserted when all samples present
-     false,             // We won't see the ERR bit because of 8 bit reads; disable.
-     true               // Shift each sample to 8 bits when pushing to FIFO
+     1,                 // DREQ (and IRQ) asserted when at least one sample present
+     false,             // No ERR bit in the samples
+     false              // Full 12 bit samples
     );
-    if (samples_per_second<1 || samples_per_second>=500000) {
+    if (triggerPWMSlice>=0 || samples_per_second<1 || samples_per_second>=500000) {
+        // PWM triggered conversions run back to back
         samples_per_second = 0;
         adc_set_clkdiv(0);
     }
@@ -175,43 +234,68 @@ bool RP2040ADCEngine::init() {
         adc_set_clkdiv(48000000/samples_per_second);
     SIMPLEFOC_DEBUG("RP2040-CUR: ADC init");
 
-    readDMAChannel = dma_claim_unused_channel(true);
-    dma_channel_config cc1 = dma_channel_get_default_config(readDMAChannel);
-    channel_config_set_transfer_data_size(&cc1, DMA_SIZE_8);
-    channel_config_set_read_increment(&cc1, false);
-    channel_config_set_write_increment(&cc1, true);
-    channel_config_set_dreq(&cc1, DREQ_ADC);
-    channel_config_set_irq_quiet(&cc1, false);
-    dma_channel_configure(readDMAChannel,
-        &cc1,
-        samples,        // dest
-        &adc_hw->fifo,  // source
-        channelCount,   // count
-        false           // defer start
-    );
-    dma_channel_set_irq0_enabled(readDMAChannel, true);
+    readDMAChannel[0] = dma_claim_unused_channel(true);
+    readDMAChannel[1] = dma_claim_unused_channel(true);
+    for (int k=0; k<2; k++) {
+        dma_channel_config cc1 = dma_channel_get_default_config(readDMAChannel[k]);
+        channel_config_set_transfer_data_size(&cc1, DMA_SIZE_16);
+        channel_config_set_read_increment(&cc1, false);
+        channel_config_set_write_increment(&cc1, true);
+        channel_config_set_dreq(&cc1, DREQ_ADC);
+        channel_config_set_irq_quiet(&cc1, false);
+        // free running - the reload channel re-arms this buffer and starts the other one as soon as this one is full
+        if (triggerPWMSlice<0) {
+            reloadDMAChannel[k] = dma_claim_unused_channel(true);
+            channel_config_set_chain_to(&cc1, reloadDMAChannel[k]);
+        }
+        dma_channel_configure(readDMAChannel[k],
+            &cc1,
+            samples[k],                     // dest
+            &adc_hw->fifo,                  // source
+            channelCount*oversampling,      // count
+            false                           // defer start
+        );
+        dma_channel_set_irq0_enabled(readDMAChannel[k], true);
+    }
+    if (triggerPWMSlice<0) {
+        for (int k=0; k<2; k++) {
+            reloadAddress[k] = samples[k];
+            dma_channel_config cc2 = dma_channel_get_default_config(reloadDMAChannel[k]);
+            channel_config_set_transfer_data_size(&cc2, DMA_SIZE_32);
+            channel_config_set_read_increment(&cc2, false);
+            channel_config_set_write_increment(&cc2, false);
+            channel_config_set_irq_quiet(&cc2, true);
+            channel_config_set_chain_to(&cc2, readDMAChannel[1-k]);
+            dma_channel_configure(reloadDMAChannel[k],
+                &cc2,
+                &dma_hw->ch[readDMAChannel[k]].write_addr,   // dest - does not trigger the read channel
+                &reloadAddress[k],                            // source
+                1,                                            // count
+                false                                         // defer start
+            );
+        }
+    }
     irq_add_shared_handler(DMA_IRQ_0, _adcConversionFinishedHandler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
 
     SIMPLEFOC_DEBUG("RP2040-CUR: DMA init");
 
-    // if (triggerPWMSlice>=0) { // if we have a trigger
-    //     triggerDMAChannel = dma_claim_unused_channel(true);
-    //     dma_channel_config cc3 = dma_channel_get_default_config(triggerDMAChannel);
-    //     channel_config_set_transfer_data_size(&cc3, DMA_SIZE_32);
-    //     channel_config_set_read_increment(&cc3, false);
-    //     channel_config_set_write_increment(&cc3, false);
-    //     channel_config_set_irq_quiet(&cc3, true);
-    //     channel_config_set_dreq(&cc3, DREQ_PWM_WRAP0+triggerPWMSlice); //pwm_get_dreq(triggerPWMSlice));
-    //     pwm_set_irq_enabled(triggerPWMSlice, true);
-    //     dma_channel_configure(triggerDMAChannel,
-    //         &cc3,
-    //         hw_set_alias_untyped(&adc_hw->cs),    // dest
-    //         &trigger_value, // source
-    //         1,              // count
-    //         true           // defer start
-    //     );
-    //     SIMPLEFOC_DEBUG("RP2040-CUR: PWM trigger init slice ", triggerPWMSlice);
-    // }
+    if (triggerPWMSlice>=0) { // if we have a trigger
+        triggerDMAChannel = dma_claim_unused_channel(true);
+        dma_channel_config cc3 = dma_channel_get_default_config(triggerDMAChannel);
+        channel_config_set_transfer_data_size(&cc3, DMA_SIZE_32);
+        channel_config_set_read_increment(&cc3, false);
+        channel_config_set_write_increment(&cc3, false);
+        channel_config_set_irq_quiet(&cc3, true);
+        channel_config_set_dreq(&cc3, pwm_get_dreq(triggerPWMSlice));
+        dma_channel_configure(triggerDMAChannel,
+            &cc3,
+            hw_set_alias_untyped(&adc_hw->cs),    // dest
+            &trigger_value, // source
+            1,              // count
+            false           // defer start
+        );
+        SIMPLEFOC_DEBUG("RP2040-CUR: PWM trigger init slice ", triggerPWMSlice);
+    }
 
     initialized = true;
     return initialized;
@@ -223,19 +307,15 @@ bool RP2040ADCEngine::init() {
 void RP2040ADCEngine::start() {
     SIMPLEFOC_DEBUG("RP2040-CUR: ADC engine starting");
     irq_set_enabled(DMA_IRQ_0, true);
-    dma_start_channel_mask( (1u << readDMAChannel) );
-    for (int i=0;i<4;i++) {
-        if (channelsEnabled[i]) {
-            adc_select_input(i); // set input to first enabled channel
-            break;
-        }
-    }
-    // if (triggerPWMSlice>=0) {
-    //     dma_start_channel_mask( (1u << triggerDMAChannel) );
-    //     //hw_set_bits(&adc_hw->cs, trigger_value);
-    // }
-    // else
-    adc_run(true);
+    // start from the beginning of the buffers - stop() can abort them half written
+    dma_channel_set_write_addr(readDMAChannel[0], samples[0], false);
+    dma_channel_set_write_addr(readDMAChannel[1], samples[1], false);
+    dma_start_channel_mask( (1u << readDMAChannel[0]) );
+    adc_select_input(firstChannel); // set input to first enabled channel
+    if (triggerPWMSlice>=0)
+        dma_start_channel_mask( (1u << triggerDMAChannel) );
+    else
+        adc_run(true);
     SIMPLEFOC_DEBUG("RP2040-CUR: ADC engine started");
 };
 
@@ -245,9 +325,14 @@ void RP2040ADCEngine::start() {
 void RP2040ADCEngine::stop() {
     adc_run(false);
     irq_set_enabled(DMA_IRQ_0, false);
-    dma_channel_abort(readDMAChannel);
-    // if (triggerPWMSlice>=0)
-    //     dma_channel_abort(triggerDMAChannel);
+    if (triggerPWMSlice>=0)
+        dma_channel_abort(triggerDMAChannel);
+    else {
+        dma_channel_abort(reloadDMAChannel[0]);
+        dma_channel_abort(reloadDMAChannel[1]);
+    }
+    dma_channel_abort(readDMAChannel[0]);
+    dma_channel_abort(readDMAChannel[1]);
     adc_fifo_drain();
     SIMPLEFOC_DEBUG("RP2040-CUR: ADC engine stopped");
 };
@@ -256,7 +341,12 @@ void RP2040ADCEngine::stop() {
 
 ADCResults RP2040ADCEngine::getLastResults() {
     ADCResults r;
-    r.value = lastResults.value;
+    uint32_t seq;
+    do {
+        seq = sequence;
+        r.value = results[seq & 1].value;
+        // the interrupt writes to the other buffer, retry only if it published in the meantime
+    } while (seq != sequence);
     return r;
 };
 
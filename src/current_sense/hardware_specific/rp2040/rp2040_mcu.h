@@ -5,7 +5,7 @@
 /*
  * RP2040 ADC features are very weak :-(
  *  - only 4 inputs
- *  - only 9 bit effective resolution
+ *  - 12 bit, but only 9 bit effective resolution
  *  - read only 1 input at a time
  *  - 2 microseconds conversion time!
  *  - no triggers from PWM / events, only DMA
@@ -25,6 +25,13 @@
  * The default sampling rate is 20kHz, which is suitable for 2 channels assuming you a 5kHz main loop speed (a new measurement is used per
  * main loop iteration).
  * 
+ * Optionally each result can be the sum of several round-robin conversions (oversampling), and the conversions can be
+ * started by the PWM wrap (setPWMTrigger(), or define SIMPLEFOC_RP2040_ADC_PWM_TRIGGER to use the slice of the linked
+ * driver) instead of the fixed sampling rate. Set the options of the engine before the current sense init().
+ * 
+ * The conversion is configured once, by the first init() - add all the pins (ex. a bus voltage pin) before it. Pins added
+ * later are refused with an error, the DMA transfers and the round robin of the running engine can not change.
+ * 
  * Low-side sensing is currently not supported.
  * 
  * The SimpleFOC PWM driver for RP2040 syncs all the slices, so the PWM trigger is applied to the first used slice. For current
@@ -35,31 +42,40 @@
  * of inline sensing.
  * 
  * Solution to trigger ADC conversion from PWM via DMA:
- * use the PWM wrap as a DREQ to a DMA channel, and have the DMA channel write to the ADC's CS register to trigger an ADC sample.
- * Unfortunately, I could not get this to work, so no low side sensing for the moment.
+ * use the PWM wrap as a DREQ to a DMA channel, and have the DMA channel set the START_MANY bit of the ADC's CS register.
+ * The ADC then converts back to back until the conversion finished interrupt stops it, drains the extra conversions from the
+ * FIFO and re-arms the trigger for the next PWM wrap.
  * 
  * Solution for ADC conversion:
- * ADC converts all channels in round-robin mode, and writes to FIFO. FIFO is emptied by a DMA which triggers after N conversions,
- * where N is the number of ADC channels used. So this DMA copies all the values from one round-robin conversion.
+ * ADC converts all channels in round-robin mode, and writes the full 12 bit samples to FIFO. FIFO is emptied by two DMA
+ * channels with 16 bit transfers, each writing its own buffer of N*oversampling conversions, where N is the number of
+ * ADC channels used. In free running mode the channels are chained, so there is no gap between the buffers. Each read
+ * channel chains to a reload DMA channel, which resets its write address and chains to the other read channel, so the
+ * re-arming never depends on the interrupt latency. The interrupt of the finished channel sums the conversions and
+ * publishes them to a double buffered result, so getLastResults() does not need to block the interrupts.
  * 
  * 
  */
 
 
-#define SIMPLEFOC_RP2040_ADC_RESOLUTION 256
+#define SIMPLEFOC_RP2040_ADC_RESOLUTION 4096
 #ifndef SIMPLEFOC_RP2040_ADC_VDDA 
 #define SIMPLEFOC_RP2040_ADC_VDDA 3.3f
 #endif
+// maximal number of round-robin conversions summed in one result
+#ifndef SIMPLEFOC_RP2040_ADC_MAX_OVERSAMPLING
+#define SIMPLEFOC_RP2040_ADC_MAX_OVERSAMPLING 8
+#endif
 
 
 union ADCResults {
-    uint32_t value;
-    uint8_t raw[4];
+    uint64_t value;
+    uint16_t raw[4];
     struct {
-        uint8_t ch0;
-        uint8_t ch1;
-        uint8_t ch2;
-        uint8_t ch3;
+        uint16_t ch0;
+        uint16_t ch1;
+        uint16_t ch2;
+        uint16_t ch3;
     };
 };
 
@@ -68,8 +84,8 @@ class RP2040ADCEngine {
 
 public:
     RP2040ADCEngine();
-    void addPin(int pin);
-    //void setPWMTrigger(uint slice);
+    bool addPin(int pin); // add the pin to the conversion - only before init(), the running conversion can not change
+    void setPWMTrigger(uint slice); // start the conversions on the PWM wrap of the slice - call before init()
 
     bool init();
     void start();
@@ -78,16 +94,24 @@ public:
     ADCResults getLastResults(); // TODO find a better API and representation for this
 
     int samples_per_second = 20000; // 20kHz default (assuming 2 shunts and 5kHz loop speed), set to 0 to convert in tight loop
-    float adc_conv = (SIMPLEFOC_RP2040_ADC_VDDA / SIMPLEFOC_RP2040_ADC_RESOLUTION); // conversion from raw ADC to float
+    int oversampling = 1; // number of round-robin conversions summed in one result (1 - SIMPLEFOC_RP2040_ADC_MAX_OVERSAMPLING)
+    float adc_conv = (SIMPLEFOC_RP2040_ADC_VDDA / SIMPLEFOC_RP2040_ADC_RESOLUTION); // conversion from raw ADC to float, divided by oversampling in init()
 
-    //int triggerPWMSlice = -1;
+    int triggerPWMSlice = -1;
     bool initialized;
-    uint readDMAChannel;
-    //uint copyDMAChannel;
-    //uint triggerDMAChannel;
+    uint readDMAChannel[2];
+    uint triggerDMAChannel;
+    uint reloadDMAChannel[2]; // free running - resets the write address of the read channel and starts the other one
+    volatile uint16_t* reloadAddress[2]; // write addresses copied by the reload channels
+    int channelCount = 0; // number of converted channels - captured in init()
+    int firstChannel = 0;
+    uint8_t channels[4]; // converted channels in the round robin order - captured in init()
 
     bool channelsEnabled[4];
-    volatile uint8_t samples[4];
-    volatile ADCResults lastResults;
-    //alignas(32) volatile uint8_t nextResults[4];
-};
\ No newline at end of file
+    volatile uint16_t samples[2][4*SIMPLEFOC_RP2040_ADC_MAX_OVERSAMPLING];
+    volatile ADCResults results[2]; // written alternately by the interrupt
+    volatile uint32_t sequence = 0; // number of published results - results[sequence & 1] is the latest
+};
+
+/* Singleton instance of the ADC engine */
+extern RP2040ADCEngine engine;
@@ -6,6 +6,7 @@
 
 static bool freeRunning = false;
 static int _pinA, _pinB, _pinC;
+static int phase_slot[3] = {-1, -1, -1}; // scan result of the phase A, B and C (-1 if not set) - _updateADCSlotsLowSide
 static uint16_t a = 0xFFFF, b = 0xFFFF, c = 0xFFFF; // updated by adcStopWithDMA when configured in freerunning mode
 static SAMDCurrentSenseADCDMA instance;
 
@@ -23,6 +24,7 @@ void* _configureADCLowSide(const void* driver_params, const int pinA,const int p
   GenericCurrentSenseParams* params = new GenericCurrentSenseParams {
     .pins = { pinA, pinB, pinC }
   };
+  _updateADCSlotsLowSide(pinA, pinB, pinC, params);
 
   return params;
 }
@@ -51,6 +53,35 @@ float _readADCVoltageLowSide(const int pinA, const void* cs_params)
   return NAN;
 }
 
+/**
+ *  function reading all the phase voltages at once
+ *  the scan results are ordered as the configured pins, the result of each phase is resolved
+ *  by _updateADCSlotsLowSide - no pin search
+ */
+void _readADCVoltagesLowSide(const int pinA, const int pinB, const int pinC, const void* cs_params, float* voltages)
+{
+  _UNUSED(pinA);
+  _UNUSED(pinB);
+  _UNUSED(pinC);
+  _UNUSED(cs_params);
+  instance.readResults(a, b, c);
+
+  const uint16_t results[3] = {a, b, c};
+  for(int i = 0; i < 3; i++)
+    voltages[i] = phase_slot[i] < 0 ? 0 : instance.toVolts(results[phase_slot[i]]);
+}
+
+/**
+ *  function resolving the scan result of the phases - at init and after the alignment swaps the pins
+ */
+void _updateADCSlotsLowSide(const int pinA, const int pinB, const int pinC, void* cs_params)
+{
+  const int* pins = ((GenericCurrentSenseParams*)cs_params)->pins;
+  phase_slot[0] = _adcPinIndex(pinA, pins);
+  phase_slot[1] = _adcPinIndex(pinB, pins);
+  phase_slot[2] = _adcPinIndex(pinC, pins);
+}
+
 /**
  *  function syncing the Driver with the ADC  for the LowSide Sensing
  */
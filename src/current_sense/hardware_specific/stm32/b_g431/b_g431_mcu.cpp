@@ -25,29 +25,57 @@ static DMA_HandleTypeDef hdma_adc2;
 volatile uint16_t adcBuffer1[ADC_BUF_LEN_1] = {0}; // Buffer for store the results of the ADC conversion
 volatile uint16_t adcBuffer2[ADC_BUF_LEN_2] = {0}; // Buffer for store the results of the ADC conversion
 
-// function reading an ADC value and returning the read voltage
-// As DMA is being used just return the DMA result
-float _readADCVoltageLowSide(const int pin, const void* cs_params){
-  uint32_t raw_adc = 0;
+// DMA buffer of the phase A, B and C - resolved by _updateADCSlotsLowSide
+static volatile uint16_t* phase_buffer[3] = {nullptr, nullptr, nullptr};
+
+// DMA buffer element of the pin
+static volatile uint16_t* _adcBufferOfPin(const int pin){
   if(pin == PA2)  // = ADC1_IN3 = phase U (OP1_OUT) on B-G431B-ESC1
-    raw_adc = adcBuffer1[1];
+    return &adcBuffer1[1];
   else if(pin == PA6) // = ADC2_IN3 = phase V (OP2_OUT) on B-G431B-ESC1
-    raw_adc = adcBuffer2[0];
+    return &adcBuffer2[0];
 #ifdef PB1
   else if(pin == PB1) // = ADC1_IN12 = phase W (OP3_OUT) on B-G431B-ESC1
-    raw_adc = adcBuffer1[0];
+    return &adcBuffer1[0];
 #endif
 
   else if (pin == A_POTENTIOMETER)
-    raw_adc = adcBuffer1[2];
+    return &adcBuffer1[2];
   else if (pin == A_TEMPERATURE)
-    raw_adc = adcBuffer1[3];
+    return &adcBuffer1[3];
   else if (pin == A_VBUS)
-    raw_adc = adcBuffer1[4];
+    return &adcBuffer1[4];
+  return nullptr;
+}
 
+// function reading an ADC value and returning the read voltage
+// As DMA is being used just return the DMA result
+float _readADCVoltageLowSide(const int pin, const void* cs_params){
+  volatile uint16_t* buffer = _adcBufferOfPin(pin);
+  uint32_t raw_adc = buffer ? *buffer : 0;
   return raw_adc * ((Stm32CurrentSenseParams*)cs_params)->adc_voltage_conv;
 }
 
+// function reading all the phase voltages at once
+// As DMA is being used just return the DMA results
+// the buffer element of each phase is resolved by _updateADCSlotsLowSide - no pin search
+void _readADCVoltagesLowSide(const int pinA, const int pinB, const int pinC, const void* cs_params, float* voltages){
+  _UNUSED(pinA);
+  _UNUSED(pinB);
+  _UNUSED(pinC);
+  float adc_voltage_conv = ((Stm32CurrentSenseParams*)cs_params)->adc_voltage_conv;
+  for(int i=0; i < 3; i++)
+    voltages[i] = phase_buffer[i] ? *phase_buffer[i] * adc_voltage_conv : 0;
+}
+
+// resolve the DMA buffers of the phases - at init and after the alignment swaps the pins
+void _updateADCSlotsLowSide(const int pinA, const int pinB, const int pinC, void* cs_params){
+  _UNUSED(cs_params);
+  phase_buffer[0] = _isset(pinA) ? _adcBufferOfPin(pinA) : nullptr;
+  phase_buffer[1] = _isset(pinB) ? _adcBufferOfPin(pinB) : nullptr;
+  phase_buffer[2] = _isset(pinC) ? _adcBufferOfPin(pinC) : nullptr;
+}
+
 void _configureOPAMP(OPAMP_HandleTypeDef *hopamp, OPAMP_TypeDef *OPAMPx_Def){
   // could this be replaced with LL_OPAMP calls??
   hopamp->Instance = OPAMPx_Def;
@@ -128,12 +156,13 @@ void* _configureADCLowSide(const void* driver_params, const int pinA,const int p
   HAL_OPAMP_Start(&hopamp1);
   HAL_OPAMP_Start(&hopamp2);
   HAL_OPAMP_Start(&hopamp3); 
-  
+
   Stm32CurrentSenseParams* params = new Stm32CurrentSenseParams {
     .pins = { pinA, pinB, pinC },
     .adc_voltage_conv = (_ADC_VOLTAGE) / (_ADC_RESOLUTION),
     .timer_handle = (HardwareTimer *)(HardwareTimer_Handle[get_timer_index(TIM1)]->__this)
   };
+  _updateADCSlotsLowSide(pinA, pinB, pinC, params);
 
   return params;
 }
@@ -30,4 +30,12 @@ __attribute__((weak))  float _readADCVoltageInline(const int pinA, const void* c
   return raw_adc * ((Stm32CurrentSenseParams*)cs_params)->adc_voltage_conv;
 }
 
+// resolve the injected rank of the phases - at init and after the alignment swaps the pins
+void _updateADCSlotsLowSide(const int pinA, const int pinB, const int pinC, void* cs_params){
+  Stm32CurrentSenseParams* params = (Stm32CurrentSenseParams*)cs_params;
+  params->slots[0] = _adcPinIndex(pinA, params->pins);
+  params->slots[1] = _adcPinIndex(pinB, params->pins);
+  params->slots[2] = _adcPinIndex(pinC, params->pins);
+}
+
 #endif
\ No newline at end of file
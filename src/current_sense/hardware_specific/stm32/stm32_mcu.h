@@ -15,6 +15,7 @@ typedef struct Stm32CurrentSenseParams {
   float adc_voltage_conv;
   ADC_HandleTypeDef* adc_handle = NP;
   HardwareTimer* timer_handle = NP;
+  int slots[3] = {-1, -1, -1}; // injected rank of the phase A, B and C (-1 if not set) - _updateADCSlotsLowSide
 } Stm32CurrentSenseParams;
 
 #endif
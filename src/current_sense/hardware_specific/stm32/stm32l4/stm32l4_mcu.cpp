@@ -36,6 +36,7 @@ void* _configureADCLowSide(const void* driver_params, const int pinA, const int
     .adc_voltage_conv = (_ADC_VOLTAGE_L4) / (_ADC_RESOLUTION_L4)
   };
   _adc_gpio_init(cs_params, pinA,pinB,pinC);
+  _updateADCSlotsLowSide(pinA, pinB, pinC, cs_params);
   if(_adc_init(cs_params, (STM32DriverParams*)driver_params) != 0) return SIMPLEFOC_CURRENT_SENSE_INIT_FAILED;
   return cs_params;
 }
@@ -143,6 +144,23 @@ float _readADCVoltageLowSide(const int pin, const void* cs_params){
   return 0;
 }
 
+// function reading all the phase voltages at once
+// the rank of each phase is resolved by _updateADCSlotsLowSide - no pin search
+void _readADCVoltagesLowSide(const int pinA, const int pinB, const int pinC, const void* cs_params, float* voltages){
+  _UNUSED(pinA);
+  _UNUSED(pinB);
+  _UNUSED(pinC);
+  Stm32CurrentSenseParams* params = (Stm32CurrentSenseParams*)cs_params;
+  static const uint32_t ranks[3] = {ADC_INJECTED_RANK_1, ADC_INJECTED_RANK_2, ADC_INJECTED_RANK_3};
+  uint32_t* val = adc_val[_adcToIndex(params->adc_handle)];
+  for(int i=0; i < 3; i++){
+    int slot = params->slots[i];
+    if(slot < 0){ voltages[i] = 0; continue; }
+    uint32_t raw = use_adc_interrupt ? val[slot] : HAL_ADCEx_InjectedGetValue(params->adc_handle, ranks[slot]);
+    voltages[i] = raw * params->adc_voltage_conv;
+  }
+}
+
 extern "C" {
   void HAL_ADCEx_InjectedConvCpltCallback(ADC_HandleTypeDef *AdcHandle){
     // calculate the instance
@@ -156,6 +156,30 @@ float _readADCVoltageLowSide(const int pinA, const void* cs_params){
     return 0.0;
 }
 
+// ADC_ETC result index of the phase A, B and C (-1 if not set) - resolved by _updateADCSlotsLowSide
+static int phase_slot[3] = {-1, -1, -1};
+
+// function reading all the phase voltages at once
+// the ADC_ETC result index of each phase is resolved by _updateADCSlotsLowSide - no pin search
+void _readADCVoltagesLowSide(const int pinA, const int pinB, const int pinC, const void* cs_params, float* voltages){
+    _UNUSED(pinA);
+    _UNUSED(pinB);
+    _UNUSED(pinC);
+    GenericCurrentSenseParams* params = (GenericCurrentSenseParams*) cs_params;
+    // copy the results together - the interrupt updates them
+    uint32_t val[3] = {val0, val1, val2};
+    for (int i = 0; i < 3; i++)
+        voltages[i] = phase_slot[i] < 0 ? 0.0f : val[phase_slot[i]] * params->adc_voltage_conv;
+}
+
+// resolve the ADC_ETC result index of the phases - at init and after the alignment swaps the pins
+void _updateADCSlotsLowSide(const int pinA, const int pinB, const int pinC, void* cs_params){
+    const int* pins = ((GenericCurrentSenseParams*) cs_params)->pins;
+    phase_slot[0] = _adcPinIndex(pinA, pins);
+    phase_slot[1] = _adcPinIndex(pinB, pins);
+    phase_slot[2] = _adcPinIndex(pinC, pins);
+}
+
 // Configure low side for generic mcu
 // cannot do much but 
 void* _configureADCLowSide(const void* driver_params, const int pinA,const int pinB,const int pinC){
@@ -193,6 +217,7 @@ void* _configureADCLowSide(const void* driver_params, const int pinA,const int p
     .pins = {pins[0], pins[1], pins[2] },
     .adc_voltage_conv = (_ADC_VOLTAGE)/(_ADC_RESOLUTION)
   };
+  _updateADCSlotsLowSide(pinA, pinB, pinC, params);
   return params;
 }
 
@@ -57,9 +57,25 @@ int BLDCDriver3PWM::init() {
   // 硬件特定函数 - 取决于驱动器和微控制器
   params = _configure3PWM(pwm_frequency, pwmA, pwmB, pwmC);
   initialized = (params != SIMPLEFOC_DRIVER_INIT_FAILED);
+  // 硬件支持时直接写入整数比较值
+  if (initialized) pwm_range = _getPwmRange3PWM(params);
   return params != SIMPLEFOC_DRIVER_INIT_FAILED;
 }
 
+// 运行时更改PWM频率
+long BLDCDriver3PWM::setPwmFrequency(long frequency) {
+  if (!initialized) return 0;
+  long f = _setPwmFrequency(frequency, params);
+  if (!f) return 0;
+  pwm_frequency = f;
+  // 比较值范围随频率改变 - 重新读取并使缓存的比例失效
+  if (pwm_range) {
+    pwm_range = _getPwmRange3PWM(params);
+    scale_power_supply = NOT_SET;
+  }
+  return f;
+}
+
 // 设置相位状态
 void BLDCDriver3PWM::setPhaseState(PhaseState sa, PhaseState sb, PhaseState sc) {
   // 如果需要，先禁用
@@ -77,14 +93,31 @@ void BLDCDriver3PWM::setPwm(float Ua, float Ub, float Uc) {
   Ua = _constrain(Ua, 0.0f, voltage_limit);
   Ub = _constrain(Ub, 0.0f, voltage_limit);
   Uc = _constrain(Uc, 0.0f, voltage_limit);
-  
+
+  // 缓存的比例 - 只有电源电压改变时才重新计算（避免每次循环三次除法）
+  if (voltage_power_supply != scale_power_supply) {
+    scale_power_supply = voltage_power_supply;
+    inv_power_supply = 1.0f / voltage_power_supply;
+    pwm_scale = pwm_range * inv_power_supply;
+  }
+
   // 计算占空比
   // 限制在[0,1]范围内
-  dc_a = _constrain(Ua / voltage_power_supply, 0.0f, 1.0f);
-  dc_b = _constrain(Ub / voltage_power_supply, 0.0f, 1.0f);
-  dc_c = _constrain(Uc / voltage_power_supply, 0.0f, 1.0f);
+  dc_a = _constrain(Ua * inv_power_supply, 0.0f, 1.0f);
+  dc_b = _constrain(Ub * inv_power_supply, 0.0f, 1.0f);
+  dc_c = _constrain(Uc * inv_power_supply, 0.0f, 1.0f);
 
   // 硬件特定写入
   // 硬件特定函数 - 取决于驱动器和微控制器
-  _writeDutyCycle3PWM(dc_a, dc_b, dc_c, params);
+  if (pwm_range) {
+    // 整数比较值 - 电压直接乘以缓存的比例，三相在 PWM 重载时同时更新
+    uint32_t cmp_a = Ua * pwm_scale;
+    uint32_t cmp_b = Ub * pwm_scale;
+    uint32_t cmp_c = Uc * pwm_scale;
+    _writeCompare3PWM(cmp_a < pwm_range ? cmp_a : pwm_range,
+                      cmp_b < pwm_range ? cmp_b : pwm_range,
+                      cmp_c < pwm_range ? cmp_c : pwm_range, params);
+  } else {
+    _writeDutyCycle3PWM(dc_a, dc_b, dc_c, params);
+  }
 }
@@ -30,6 +30,8 @@ class BLDCDriver3PWM: public BLDCDriver
     void disable() override;
     /** 电机启用函数 */
     void enable() override;
+    /** 运行时更改PWM频率 */
+    long setPwmFrequency(long pwm_frequency) override;
 
     // 硬件变量
     int pwmA; //!< A相PWM引脚编号
@@ -59,6 +61,10 @@ class BLDCDriver3PWM: public BLDCDriver
     virtual void setPhaseState(PhaseState sa, PhaseState sb, PhaseState sc) override;
   
   private:
+    uint32_t pwm_range = 0; //!< 整数比较值范围 - 0 则使用浮点占空比
+    float pwm_scale = 0; //!< 缓存的比例 pwm_range / voltage_power_supply [1/V]
+    float inv_power_supply = 0; //!< 缓存的 1 / voltage_power_supply [1/V]
+    float scale_power_supply = NOT_SET; //!< 计算缓存比例时的电源电压 [V]
 };
 
 #endif
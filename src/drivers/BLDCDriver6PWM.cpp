@@ -44,6 +44,14 @@ void BLDCDriver6PWM::disable()
 
 }
 
+// change the PWM frequency at runtime
+long BLDCDriver6PWM::setPwmFrequency(long frequency) {
+  if (!initialized) return 0;
+  long f = _setPwmFrequency(frequency, params);
+  if (f) pwm_frequency = f;
+  return f;
+}
+
 // init hardware pins
 int BLDCDriver6PWM::init() {
 
@@ -31,6 +31,8 @@ class BLDCDriver6PWM: public BLDCDriver
   	void disable() override;
     /** Motor enable function */
     void enable() override;
+    /** Change the PWM frequency at runtime */
+    long setPwmFrequency(long pwm_frequency) override;
 
     // hardware variables
   	int pwmA_h,pwmA_l; //!< phase A pwm pin number
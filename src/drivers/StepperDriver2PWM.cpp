@@ -61,6 +61,14 @@ void StepperDriver2PWM::disable()
 
 }
 
+// change the PWM frequency at runtime
+long StepperDriver2PWM::setPwmFrequency(long frequency) {
+  if (!initialized) return 0;
+  long f = _setPwmFrequency(frequency, params);
+  if (f) pwm_frequency = f;
+  return f;
+}
+
 // init hardware pins
 int StepperDriver2PWM::init() {
   // PWM pins
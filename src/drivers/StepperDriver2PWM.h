@@ -41,6 +41,8 @@ class StepperDriver2PWM: public StepperDriver
   	void disable() override;
     /** Motor enable function */
     void enable() override;
+    /** Change the PWM frequency at runtime */
+    long setPwmFrequency(long pwm_frequency) override;
 
     // hardware variables
     int pwm1; //!< phase 1 pwm pin number
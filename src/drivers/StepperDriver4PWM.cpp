@@ -38,6 +38,14 @@ void StepperDriver4PWM::disable()
 
 }
 
+// change the PWM frequency at runtime
+long StepperDriver4PWM::setPwmFrequency(long frequency) {
+  if (!initialized) return 0;
+  long f = _setPwmFrequency(frequency, params);
+  if (f) pwm_frequency = f;
+  return f;
+}
+
 // init hardware pins
 int StepperDriver4PWM::init() {
 
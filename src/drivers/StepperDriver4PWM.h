@@ -30,6 +30,8 @@ class StepperDriver4PWM: public StepperDriver
   	void disable() override;
     /** Motor enable function */
     void enable() override;
+    /** Change the PWM frequency at runtime */
+    long setPwmFrequency(long pwm_frequency) override;
 
     // hardware variables
   	int pwm1A; //!< phase 1A pwm pin number
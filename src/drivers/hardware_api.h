@@ -141,6 +141,40 @@ void _writeDutyCycle2PWM(float dc_a,  float dc_b, void* params);
  */ 
 void _writeDutyCycle3PWM(float dc_a,  float dc_b, float dc_c, void* params);
 
+/** 
+ * 整数比较值的范围 - 占空比 1 对应的定时器比较值
+ * - BLDC 驱动 - 3PWM 设置
+ * - 硬件特定
+ * 
+ * @param params - 驱动参数
+ * @return 比较值范围，0 表示不支持 _writeCompare3PWM()（使用 _writeDutyCycle3PWM()）
+ */ 
+uint32_t _getPwmRange3PWM(void* params);
+
+/** 
+ * 直接设置定时器比较值 - _writeDutyCycle3PWM() 的整数版本
+ * - BLDC 驱动 - 3PWM 设置
+ * - 硬件特定
+ * - 如果硬件支持，三相的比较值在下一次 PWM 重载时同时生效（预装载/影子寄存器）
+ * 
+ * @param cmp_a - 比较值相 A [0, _getPwmRange3PWM()]
+ * @param cmp_b - 比较值相 B [0, _getPwmRange3PWM()]
+ * @param cmp_c - 比较值相 C [0, _getPwmRange3PWM()]
+ * @param params - 驱动参数
+ */ 
+void _writeCompare3PWM(uint32_t cmp_a, uint32_t cmp_b, uint32_t cmp_c, void* params);
+
+/** 
+ * 运行时更改 PWM 频率 - 所有驱动设置
+ * - 硬件特定
+ * - 占空比保持不变，_getPwmRange3PWM() 的比较值范围可能改变
+ * 
+ * @param pwm_frequency - 新的频率（赫兹）
+ * @param params - 驱动参数
+ * @return 设置的频率（赫兹），0 表示不支持
+ */ 
+long _setPwmFrequency(long pwm_frequency, void* params);
+
 /** 
  * 设置 PWM 引脚的占空比（例如，analogWrite()）
  * - 步进电机驱动 - 4PWM 设置
@@ -96,6 +96,24 @@ __attribute__((weak)) void _writeDutyCycle3PWM(float dc_a,  float dc_b, float dc
   analogWrite(((GenericDriverParams*)params)->pins[2], 255.0f*dc_c);
 }
 
+// 整数比较值的范围
+// - 无刷直流电机 - 3PWM 设置
+// - 硬件特定 - 0 表示不支持，驱动使用 _writeDutyCycle3PWM()
+__attribute__((weak)) uint32_t _getPwmRange3PWM(void* params){
+  _UNUSED(params);
+  return 0;
+}
+
+// 设置比较值到硬件的函数
+// - 无刷直流电机 - 3PWM 设置
+// - 硬件特定 - 只有 _getPwmRange3PWM() 不为 0 时才会被调用
+__attribute__((weak)) void _writeCompare3PWM(uint32_t cmp_a, uint32_t cmp_b, uint32_t cmp_c, void* params){
+  _UNUSED(cmp_a);
+  _UNUSED(cmp_b);
+  _UNUSED(cmp_c);
+  _UNUSED(params);
+}
+
 // 设置 PWM 占空比到硬件的函数
 // - 步进电机 - 4PWM 设置
 // - 硬件特定
@@ -118,3 +136,12 @@ __attribute__((weak)) void _writeDutyCycle6PWM(float dc_a,  float dc_b, float dc
   _UNUSED(phase_state);
   _UNUSED(params);
 }
+
+// 运行时更改 PWM 频率的函数
+// - 所有驱动设置
+// - 硬件特定 - 通用情况下不支持，返回 0
+__attribute__((weak)) long _setPwmFrequency(long pwm_frequency, void* params){
+  _UNUSED(pwm_frequency);
+  _UNUSED(params);
+  return 0;
+}
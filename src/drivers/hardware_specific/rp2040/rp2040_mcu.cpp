@@ -202,6 +202,22 @@ void _writeDutyCycle3PWM(float dc_a,  float dc_b, float dc_c, void* params) {
 
 
 
+// compare level of duty cycle 1 - all slices use the same wrap value
+uint32_t _getPwmRange3PWM(void* params) {
+	return wrapvalues[((RP2040DriverParams*)params)->slice[0]] + 1;
+}
+
+
+
+// the CC registers are double buffered - the new levels are latched at the end of the PWM period
+void _writeCompare3PWM(uint32_t cmp_a, uint32_t cmp_b, uint32_t cmp_c, void* params) {
+	pwm_set_chan_level(((RP2040DriverParams*)params)->slice[0], ((RP2040DriverParams*)params)->chan[0], cmp_a);
+	pwm_set_chan_level(((RP2040DriverParams*)params)->slice[1], ((RP2040DriverParams*)params)->chan[1], cmp_b);
+	pwm_set_chan_level(((RP2040DriverParams*)params)->slice[2], ((RP2040DriverParams*)params)->chan[2], cmp_c);
+}
+
+
+
 void _writeDutyCycle4PWM(float dc_1a,  float dc_1b, float dc_2a, float dc_2b, void* params) {
 	writeDutyCycle(dc_1a, ((RP2040DriverParams*)params)->slice[0], ((RP2040DriverParams*)params)->chan[0]);
 	writeDutyCycle(dc_1b, ((RP2040DriverParams*)params)->slice[1], ((RP2040DriverParams*)params)->chan[1]);
@@ -1,6 +1,7 @@
 
 #include "../../hardware_api.h"
 #include "stm32_mcu.h"
+#include "stm32_searchtimers.h"
 
 #if defined(_STM32_DEF_)
 
@@ -9,17 +10,6 @@
 #pragma message("SimpleFOC: 正在为 STM32 编译")
 #pragma message("")
 
-#ifdef SIMPLEFOC_STM32_DEBUG
-void printTimerCombination(int numPins, PinMap* timers[], int score);
-int getTimerNumber(int timerIndex);
-#endif
-
-#ifndef SIMPLEFOC_STM32_MAX_PINTIMERSUSED
-#define SIMPLEFOC_STM32_MAX_PINTIMERSUSED 12
-#endif
-int numTimerPinsUsed;
-PinMap* timerPinsUsed[SIMPLEFOC_STM32_MAX_PINTIMERSUSED];
-
 bool _getPwmState(void* params) {
   // 假设定时器已同步，并且至少有一个定时器
   HardwareTimer* pHT = ((STM32DriverParams*)params)->timers[0];
@@ -329,7 +319,9 @@ int _getInternalSourceTrigger(HardwareTimer* master, HardwareTimer* slave) {
 }
 #endif
 
-void syncTimerFrequency(long pwm_frequency, HardwareTimer *timers[], uint8_t num_timers) {
+// 不同时钟的定时器设置相同的频率
+// - refresh - 产生更新事件立即装载（初始化时），运行时为 false，预装载的值在下一次更新事件生效
+void syncTimerFrequency(long pwm_frequency, HardwareTimer *timers[], uint8_t num_timers, bool refresh = true) {
   uint32_t max_frequency = 0;
   uint32_t min_frequency = UINT32_MAX;
   for (size_t i = 0; i < num_timers; i++) {
@@ -350,7 +342,7 @@ void syncTimerFrequency(long pwm_frequency, HardwareTimer *timers[], uint8_t num
     #endif
     timers[i]->setPrescaleFactor(prescale_factor);
     timers[i]->setOverflow(overflow_value, TICK_FORMAT);
-    timers[i]->refresh();
+    if (refresh) timers[i]->refresh();
   }
 }
 
@@ -540,175 +532,6 @@ STM32DriverParams* _initHardware6PWMInterface(long PWM_freq, float dead_zone, Pi
   return params;
 }
 
-/*
-  定时器组合评分函数
-  分配一个分数，并检查组合是否有效
-  返回<0表示组合无效，>=0表示组合有效。分数越低（但为正）越好
-  对于6PWM，硬件6PWM优先于软件6PWM
-  硬件6PWM的前提是每个低通道是其高通道的反相对应物
-  除非使用硬件6PWM，否则不允许反相通道（理论上可以，但不想复杂化）
-*/
-int scoreCombination(int numPins, PinMap* pinTimers[]) {
-  // 检查是否已使用 - TODO 将此移动到外部循环...
-  for (int i=0; i<numTimerPinsUsed; i++) {
-    if (pinTimers[i]->peripheral == timerPinsUsed[i]->peripheral
-        && STM_PIN_CHANNEL(pinTimers[i]->function) == STM_PIN_CHANNEL(timerPinsUsed[i]->function))
-      return -2; // 组合不良 - 定时器通道已被使用
-  }
-  
-  // TODO LPTIM和HRTIM目前应被忽略
-  
-  // 检查反相通道
-  if (numPins < 6) {
-    for (int i=0; i<numPins; i++) {
-      if (STM_PIN_INVERTED(pinTimers[i]->function))
-        return -3; // 组合不良 - 在非硬件6PWM中使用了反相通道
-    }
-  }
-  // 检查重复通道
-  for (int i=0; i<numPins-1; i++) {
-    for (int j=i+1; j<numPins; j++) {
-      if (pinTimers[i]->peripheral == pinTimers[j]->peripheral
-          && STM_PIN_CHANNEL(pinTimers[i]->function) == STM_PIN_CHANNEL(pinTimers[j]->function)
-          && STM_PIN_INVERTED(pinTimers[i]->function) == STM_PIN_INVERTED(pinTimers[j]->function))
-        return -4; // 组合不良 - 重复通道
-    }
-  }
-  int score = 0;
-  for (int i=0; i<numPins; i++) {
-    // 计算不同的定时器
-    bool found = false;
-    for (int j=i+1; j<numPins; j++) {
-      if (pinTimers[i]->peripheral == pinTimers[j]->peripheral)
-        found = true;
-    }
-    if (!found) score++;
-  }
-  if (numPins==6) {
-    // 检查反相通道 - 最佳情况: 1个定时器，3个通道，3个匹配的反相通道
-    //                                     >1个定时器，3个通道，3个匹配的反相通道
-    //                                     1个定时器，6个通道（无反相通道）
-    //                                     >1个定时器，6个通道（无反相通道）
-    // 检查反相高侧通道 - TODO 这是我们应该允许的配置吗？如果所有3个高侧通道都是反相的而低侧非反相的呢？
-    if (STM_PIN_INVERTED(pinTimers[0]->function) || STM_PIN_INVERTED(pinTimers[2]->function) || STM_PIN_INVERTED(pinTimers[4]->function))
-      return -5; // 组合不良 - 在高侧通道上使用了反相通道
-    if (pinTimers[0]->peripheral == pinTimers[1]->peripheral
-        && pinTimers[2]->peripheral == pinTimers[3]->peripheral
-        && pinTimers[4]->peripheral == pinTimers[5]->peripheral
-        && STM_PIN_CHANNEL(pinTimers[0]->function) == STM_PIN_CHANNEL(pinTimers[1]->function)
-        && STM_PIN_CHANNEL(pinTimers[2]->function) == STM_PIN_CHANNEL(pinTimers[3]->function)
-        && STM_PIN_CHANNEL(pinTimers[4]->function) == STM_PIN_CHANNEL(pinTimers[5]->function)
-        && STM_PIN_INVERTED(pinTimers[1]->function) && STM_PIN_INVERTED(pinTimers[3]->function) && STM_PIN_INVERTED(pinTimers[5]->function)) {
-          // 硬件6PWM，分数<10
-
-          // TODO F37xxx不支持死区时间插入，它没有TIM1/TIM8
-          // F301, F302 --> 6个通道，但只有1-3有死区时间插入
-          // TIM2/TIM3/TIM4/TIM5不支持死区时间插入
-          // TIM15/TIM16/TIM17仅在通道1上支持死区时间插入
-
-          // TODO 检查这些定义
-          #if defined(STM32F4xx_HAL_TIM_H) || defined(STM32F3xx_HAL_TIM_H) || defined(STM32F2xx_HAL_TIM_H) || defined(STM32F1xx_HAL_TIM_H) || defined(STM32F100_HAL_TIM_H) || defined(STM32FG0x1_HAL_TIM_H)  || defined(STM32G0x0_HAL_TIM_H) 
-          if (STM_PIN_CHANNEL(pinTimers[0]->function)>3 || STM_PIN_CHANNEL(pinTimers[2]->function)>3 || STM_PIN_CHANNEL(pinTimers[4]->function)>3 )
-            return -8; // 通道4不支持死区时间插入
-          #endif
-          #ifdef STM32G4xx_HAL_TIM_H
-          if (STM_PIN_CHANNEL(pinTimers[0]->function)>4 || STM_PIN_CHANNEL(pinTimers[2]->function)>4 || STM_PIN_CHANNEL(pinTimers[4]->function)>4 )
-            return -8; // 通道5和6不支持死区时间插入
-          #endif
-        }
-    else {
-      // 检查反相低侧通道
-      if (STM_PIN_INVERTED(pinTimers[1]->function) || STM_PIN_INVERTED(pinTimers[3]->function) || STM_PIN_INVERTED(pinTimers[5]->function))
-        return -6; // 组合不良 - 在软件6PWM中低侧通道使用了反相通道
-      if (pinTimers[0]->peripheral != pinTimers[1]->peripheral
-        || pinTimers[2]->peripheral != pinTimers[3]->peripheral
-        || pinTimers[4]->peripheral != pinTimers[5]->peripheral)
-        return -7; // 组合不良 - 软件6PWM中高/低侧通道的定时器不匹配
-      score += 10; // 软件6PWM，分数>10
-    }
-  }
-  return score;
-}
-
-// 查找第一个PinMap条目的索引
-int findIndexOfFirstPinMapEntry(int pin) {
-  PinName pinName = digitalPinToPinName(pin);
-  int i = 0;
-  while (PinMap_TIM[i].pin!=NC) {
-    if (pinName == PinMap_TIM[i].pin)
-      return i;
-    i++;
-  }
-  return -1;
-}
-
-// 查找最后一个PinMap条目的索引
-int findIndexOfLastPinMapEntry(int pin) {
-  PinName pinName = digitalPinToPinName(pin);
-  int i = 0;
-  while (PinMap_TIM[i].pin!=NC) {
-    if (   pinName == (PinMap_TIM[i].pin & ~ALTX_MASK) 
-        && pinName != (PinMap_TIM[i+1].pin & ~ALTX_MASK))
-      return i;
-    i++;
-  }
-  return -1;
-}
-
-#define NOT_FOUND 1000
-
-// 查找最佳定时器组合
-int findBestTimerCombination(int numPins, int index, int pins[], PinMap* pinTimers[]) {
-  PinMap* searchArray[numPins];
-  for (int j=0;j<numPins;j++)
-        searchArray[j] = pinTimers[j];
-  int bestScore = NOT_FOUND;
-  int startIndex = findIndexOfFirstPinMapEntry(pins[index]);
-  int endIndex = findIndexOfLastPinMapEntry(pins[index]);
-  if (startIndex == -1 || endIndex == -1) {
-    SIMPLEFOC_DEBUG("STM32-DRV: ERR: 引脚上没有定时器 ", pins[index]);
-    return -1; // 引脚未连接到任何定时器
-  }
-  for (int i=startIndex;i<=endIndex;i++) {
-    searchArray[index] = (PinMap*)&PinMap_TIM[i];
-    int score = NOT_FOUND;
-    if (index<numPins-1)
-      score = findBestTimerCombination(numPins, index+1, pins, searchArray);
-    else {
-      score = scoreCombination(numPins, searchArray);
-      #ifdef SIMPLEFOC_STM32_DEBUG
-      printTimerCombination(numPins, searchArray, score);
-      #endif
-    }
-    if (score==-1)
-      return -1; // 引脚未连接到任何定时器，直接传播
-    if (score>=0 && score<bestScore) {
-      bestScore = score;
-      for (int j=index;j<numPins;j++)
-        pinTimers[j] = searchArray[j];
-    }
-  }
-  return bestScore;
-}
-
-// 查找最佳定时器组合
-int findBestTimerCombination(int numPins, int pins[], PinMap* pinTimers[]) {
-  int bestScore = findBestTimerCombination(numPins, 0, pins, pinTimers);
-  if (bestScore == NOT_FOUND) {
-    #ifdef SIMPLEFOC_STM32_DEBUG
-    SimpleFOCDebug::println("STM32-DRV: 在这些引脚上未找到可行组合");
-    #endif
-    return -10; // 未找到可行组合
-  }
-  else if (bestScore >= 0) {
-    #ifdef SIMPLEFOC_STM32_DEBUG
-    SimpleFOCDebug::print("STM32-DRV: 最佳: ");
-    printTimerCombination(numPins, pinTimers, bestScore);
-    #endif
-  }
-  return bestScore;
-}
-
 // 配置1个PWM
 void* _configure1PWM(long pwm_frequency, const int pinA) {
   if (numTimerPinsUsed+1 > SIMPLEFOC_STM32_MAX_PINTIMERSUSED) {
@@ -827,6 +650,10 @@ void* _configure3PWM(long pwm_frequency, const int pinA, const int pinB, const i
   timerPinsUsed[numTimerPinsUsed++] = pinTimers[1];
   timerPinsUsed[numTimerPinsUsed++] = pinTimers[2];
 
+  // 比较值预装载 - 新的比较值在下一次更新事件时生效
+  for (int i = 0; i < 3; i++)
+    LL_TIM_OC_EnablePreload(timers[i]->getHandle()->Instance, getLLChannel(pinTimers[i]));
+
   _alignTimersNew();
 
   return params;
@@ -903,6 +730,90 @@ void _writeDutyCycle3PWM(float dc_a, float dc_b, float dc_c, void* params) {
   _setPwm(((STM32DriverParams*)params)->timers[2], ((STM32DriverParams*)params)->channels[2], _PWM_RANGE * dc_c, _PWM_RESOLUTION);
 }
 
+// 直接写入比较寄存器
+static inline void _setCompare(TIM_TypeDef* TIMx, uint32_t channel, uint32_t value) {
+  switch (channel) {
+    case 1: LL_TIM_OC_SetCompareCH1(TIMx, value); break;
+    case 2: LL_TIM_OC_SetCompareCH2(TIMx, value); break;
+    case 3: LL_TIM_OC_SetCompareCH3(TIMx, value); break;
+    case 4: LL_TIM_OC_SetCompareCH4(TIMx, value); break;
+  }
+}
+
+// 整数比较值的范围
+// - 无刷直流电机 - 3PWM设置
+// - 中心对齐模式下比较值等于自动重载值时占空比为1，syncTimerFrequency() 保证所有定时器的重载值相同
+uint32_t _getPwmRange3PWM(void* params) {
+  return LL_TIM_GetAutoReload(((STM32DriverParams*)params)->timers[0]->getHandle()->Instance);
+}
+
+// 定时器的 TRGO 是否为更新事件（ADC 注入采样的触发源）
+// - 禁止更新事件 (UDIS) 同时会屏蔽 TRGO，该周期的电流采样触发将丢失
+static inline bool _isUpdateTrigger(TIM_TypeDef* TIMx) {
+  return (TIMx->CR2 & TIM_CR2_MMS) == LL_TIM_TRGO_UPDATE;
+}
+
+// 设置比较值到硬件
+// - 无刷直流电机 - 3PWM设置
+// - 比较寄存器是预装载的，三相在同一次更新事件时生效
+void _writeCompare3PWM(uint32_t cmp_a, uint32_t cmp_b, uint32_t cmp_c, void* params) {
+  STM32DriverParams* p = (STM32DriverParams*)params;
+  TIM_TypeDef* TIMa = p->timers[0]->getHandle()->Instance;
+  TIM_TypeDef* TIMb = p->timers[1]->getHandle()->Instance;
+  TIM_TypeDef* TIMc = p->timers[2]->getHandle()->Instance;
+  // 多个定时器 - 写入期间禁止更新事件，避免更新事件落在两次写入之间
+  // 作为 ADC 触发源 (TRGO = 更新事件) 的定时器不禁止，否则会丢失该周期的低侧电流采样
+  // - 该定时器上的相位仍可能比其他相晚一个周期生效
+  bool multi = (TIMa != TIMb || TIMa != TIMc);
+  bool udis_a = multi && !_isUpdateTrigger(TIMa);
+  bool udis_b = multi && !_isUpdateTrigger(TIMb);
+  bool udis_c = multi && !_isUpdateTrigger(TIMc);
+  if (udis_a) LL_TIM_DisableUpdateEvent(TIMa);
+  if (udis_b) LL_TIM_DisableUpdateEvent(TIMb);
+  if (udis_c) LL_TIM_DisableUpdateEvent(TIMc);
+  _setCompare(TIMa, p->channels[0], cmp_a);
+  _setCompare(TIMb, p->channels[1], cmp_b);
+  _setCompare(TIMc, p->channels[2], cmp_c);
+  if (udis_a) LL_TIM_EnableUpdateEvent(TIMa);
+  if (udis_b) LL_TIM_EnableUpdateEvent(TIMb);
+  if (udis_c) LL_TIM_EnableUpdateEvent(TIMc);
+}
+
+// 运行时更改PWM频率
+// - 所有驱动设置
+// - 所有定时器设置相同的频率，syncTimerFrequency() 处理不同时钟的定时器
+// - 自动重载和预分频寄存器是预装载的，不产生更新事件 (UG)，计数器不重启
+// - 写入期间禁止更新事件，新的周期在同一次更新事件时对所有定时器生效，保持 _alignTimersNew() 的相位对齐
+// - 如果更新事件落在写入期间，作为 ADC 触发源的定时器会丢失该周期的低侧电流采样触发
+// - _setPwm() 按新的重载值缩放占空比，整数比较值范围由 _getPwmRange3PWM() 重新读取
+long _setPwmFrequency(long pwm_frequency, void* params) {
+  STM32DriverParams* p = (STM32DriverParams*)params;
+  if (!pwm_frequency || !_isset(pwm_frequency)) return 0;
+  pwm_frequency = _constrain(pwm_frequency, 0, _PWM_FREQUENCY_MAX); // 限制为最大50kHz
+  // 中心对齐模式 - 计数频率是PWM频率的两倍
+  pwm_frequency *= 2;
+  // 使用的定时器（去除重复）
+  HardwareTimer* timers[6];
+  uint8_t num_timers = 0;
+  for (int i = 0; i < 6 && p->timers[i] != NULL; i++) {
+    bool found = false;
+    for (int j = 0; j < num_timers; j++)
+      if (timers[j] == p->timers[i]) found = true;
+    if (!found) timers[num_timers++] = p->timers[i];
+  }
+  for (int i = 0; i < num_timers; i++) {
+    LL_TIM_EnableARRPreload(timers[i]->getHandle()->Instance);
+    LL_TIM_DisableUpdateEvent(timers[i]->getHandle()->Instance);
+  }
+  for (int i = 0; i < num_timers; i++)
+    timers[i]->setOverflow(pwm_frequency, HERTZ_FORMAT);
+  syncTimerFrequency(pwm_frequency, timers, num_timers, false);
+  for (int i = 0; i < num_timers; i++)
+    LL_TIM_EnableUpdateEvent(timers[i]->getHandle()->Instance);
+  p->pwm_frequency = pwm_frequency;
+  return pwm_frequency / 2;
+}
+
 // 设置PWM占空比到硬件
 // - 步进电机 - 4PWM设置
 // - 硬件特定
@@ -1110,23 +1021,6 @@ int getTimerNumber(int timerIndex) {
   return -1;
 }
 
-void printTimerCombination(int numPins, PinMap* timers[], int score) {
-  for (int i=0; i<numPins; i++) {
-    if (timers[i] == NP)
-      SimpleFOCDebug::print("NP");
-    else {
-      SimpleFOCDebug::print("TIM");
-      SimpleFOCDebug::print(getTimerNumber(get_timer_index((TIM_TypeDef*)timers[i]->peripheral)));
-      SimpleFOCDebug::print("-CH");
-      SimpleFOCDebug::print(STM_PIN_CHANNEL(timers[i]->function));
-      if (STM_PIN_INVERTED(timers[i]->function))
-        SimpleFOCDebug::print("N");
-    }
-    SimpleFOCDebug::print(" ");
-  }
- SimpleFOCDebug::println("score: ", score);
-}
-
 
 #endif
 
@@ -0,0 +1,342 @@
+#include "stm32_searchtimers.h"
+
+#if defined(_STM32_DEF_)
+
+#define SIMPLEFOC_STM32_DEBUG
+
+int numTimerPinsUsed;
+PinMap* timerPinsUsed[SIMPLEFOC_STM32_MAX_PINTIMERSUSED];
+
+// 预先计算的定时器组合表
+const STM32TimerCombination* timerCombinations = NULL;
+int numTimerCombinations = 0;
+
+void _stm32SetTimerCombinations(const STM32TimerCombination* table, int count) {
+  timerCombinations = table;
+  numTimerCombinations = count;
+}
+
+// 检查定时器通道是否已被其他驱动使用
+bool _isTimerChannelUsed(PinMap* timer) {
+  for (int i=0; i<numTimerPinsUsed; i++) {
+    if (timer->peripheral == timerPinsUsed[i]->peripheral
+        && STM_PIN_CHANNEL(timer->function) == STM_PIN_CHANNEL(timerPinsUsed[i]->function))
+      return true;
+  }
+  return false;
+}
+
+/*
+  定时器组合评分函数
+  分配一个分数，并检查组合是否有效
+  返回<0表示组合无效，>=0表示组合有效。分数越低（但为正）越好
+  对于6PWM，硬件6PWM优先于软件6PWM
+  硬件6PWM的前提是每个低通道是其高通道的反相对应物
+  除非使用硬件6PWM，否则不允许反相通道（理论上可以，但不想复杂化）
+*/
+int scoreCombination(int numPins, PinMap* pinTimers[]) {
+  // 检查是否已使用
+  for (int i=0; i<numPins; i++) {
+    if (_isTimerChannelUsed(pinTimers[i]))
+      return -2; // 组合不良 - 定时器通道已被使用
+  }
+  
+  // TODO LPTIM和HRTIM目前应被忽略
+  
+  // 检查反相通道
+  if (numPins < 6) {
+    for (int i=0; i<numPins; i++) {
+      if (STM_PIN_INVERTED(pinTimers[i]->function))
+        return -3; // 组合不良 - 在非硬件6PWM中使用了反相通道
+    }
+  }
+  // 检查重复通道
+  for (int i=0; i<numPins-1; i++) {
+    for (int j=i+1; j<numPins; j++) {
+      if (pinTimers[i]->peripheral == pinTimers[j]->peripheral
+          && STM_PIN_CHANNEL(pinTimers[i]->function) == STM_PIN_CHANNEL(pinTimers[j]->function)
+          && STM_PIN_INVERTED(pinTimers[i]->function) == STM_PIN_INVERTED(pinTimers[j]->function))
+        return -4; // 组合不良 - 重复通道
+    }
+  }
+  int score = 0;
+  for (int i=0; i<numPins; i++) {
+    // 计算不同的定时器
+    bool found = false;
+    for (int j=i+1; j<numPins; j++) {
+      if (pinTimers[i]->peripheral == pinTimers[j]->peripheral)
+        found = true;
+    }
+    if (!found) score++;
+  }
+  if (numPins==6) {
+    // 检查反相通道 - 最佳情况: 1个定时器，3个通道，3个匹配的反相通道
+    //                                     >1个定时器，3个通道，3个匹配的反相通道
+    //                                     1个定时器，6个通道（无反相通道）
+    //                                     >1个定时器，6个通道（无反相通道）
+    // 检查反相高侧通道 - TODO 这是我们应该允许的配置吗？如果所有3个高侧通道都是反相的而低侧非反相的呢？
+    if (STM_PIN_INVERTED(pinTimers[0]->function) || STM_PIN_INVERTED(pinTimers[2]->function) || STM_PIN_INVERTED(pinTimers[4]->function))
+      return -5; // 组合不良 - 在高侧通道上使用了反相通道
+    if (pinTimers[0]->peripheral == pinTimers[1]->peripheral
+        && pinTimers[2]->peripheral == pinTimers[3]->peripheral
+        && pinTimers[4]->peripheral == pinTimers[5]->peripheral
+        && STM_PIN_CHANNEL(pinTimers[0]->function) == STM_PIN_CHANNEL(pinTimers[1]->function)
+        && STM_PIN_CHANNEL(pinTimers[2]->function) == STM_PIN_CHANNEL(pinTimers[3]->function)
+        && STM_PIN_CHANNEL(pinTimers[4]->function) == STM_PIN_CHANNEL(pinTimers[5]->function)
+        && STM_PIN_INVERTED(pinTimers[1]->function) && STM_PIN_INVERTED(pinTimers[3]->function) && STM_PIN_INVERTED(pinTimers[5]->function)) {
+          // 硬件6PWM，分数<10
+
+          // TODO F37xxx不支持死区时间插入，它没有TIM1/TIM8
+          // F301, F302 --> 6个通道，但只有1-3有死区时间插入
+          // TIM2/TIM3/TIM4/TIM5不支持死区时间插入
+          // TIM15/TIM16/TIM17仅在通道1上支持死区时间插入
+
+          // TODO 检查这些定义
+          #if defined(STM32F4xx_HAL_TIM_H) || defined(STM32F3xx_HAL_TIM_H) || defined(STM32F2xx_HAL_TIM_H) || defined(STM32F1xx_HAL_TIM_H) || defined(STM32F100_HAL_TIM_H) || defined(STM32FG0x1_HAL_TIM_H)  || defined(STM32G0x0_HAL_TIM_H) 
+          if (STM_PIN_CHANNEL(pinTimers[0]->function)>3 || STM_PIN_CHANNEL(pinTimers[2]->function)>3 || STM_PIN_CHANNEL(pinTimers[4]->function)>3 )
+            return -8; // 通道4不支持死区时间插入
+          #endif
+          #ifdef STM32G4xx_HAL_TIM_H
+          if (STM_PIN_CHANNEL(pinTimers[0]->function)>4 || STM_PIN_CHANNEL(pinTimers[2]->function)>4 || STM_PIN_CHANNEL(pinTimers[4]->function)>4 )
+            return -8; // 通道5和6不支持死区时间插入
+          #endif
+        }
+    else {
+      // 检查反相低侧通道
+      if (STM_PIN_INVERTED(pinTimers[1]->function) || STM_PIN_INVERTED(pinTimers[3]->function) || STM_PIN_INVERTED(pinTimers[5]->function))
+        return -6; // 组合不良 - 在软件6PWM中低侧通道使用了反相通道
+      if (pinTimers[0]->peripheral != pinTimers[1]->peripheral
+        || pinTimers[2]->peripheral != pinTimers[3]->peripheral
+        || pinTimers[4]->peripheral != pinTimers[5]->peripheral)
+        return -7; // 组合不良 - 软件6PWM中高/低侧通道的定时器不匹配
+      score += 10; // 软件6PWM，分数>10
+    }
+  }
+  return score;
+}
+
+/*
+  部分组合的剪枝检查 - 只检查新加入的引脚 index 和它之前的引脚
+  返回false表示所有以此开头的组合在 scoreCombination() 中都无效
+  对于6PWM，硬件和软件6PWM都要求高低侧在同一个定时器上，低侧要么全部反相（硬件）要么全部不反相（软件）
+*/
+bool _isValidPartialCombination(int numPins, int index, PinMap* pinTimers[]) {
+  PinMap* timer = pinTimers[index];
+  bool inverted = STM_PIN_INVERTED(timer->function);
+  if (_isTimerChannelUsed(timer))
+    return false;
+  if (numPins < 6 && inverted)
+    return false;
+  for (int j=0; j<index; j++) {
+    if (pinTimers[j]->peripheral == timer->peripheral
+        && STM_PIN_CHANNEL(pinTimers[j]->function) == STM_PIN_CHANNEL(timer->function)
+        && STM_PIN_INVERTED(pinTimers[j]->function) == inverted)
+      return false;
+  }
+  if (numPins == 6) {
+    // 高侧
+    if (index % 2 == 0)
+      return !inverted;
+    // 低侧
+    PinMap* high = pinTimers[index-1];
+    if (high->peripheral != timer->peripheral)
+      return false;
+    if (inverted && STM_PIN_CHANNEL(high->function) != STM_PIN_CHANNEL(timer->function))
+      return false;
+    if (index > 1 && inverted != STM_PIN_INVERTED(pinTimers[1]->function))
+      return false;
+  }
+  return true;
+}
+
+// 部分组合分数的下界 - 不同定时器的数量，加上确定为软件6PWM时的10
+int _partialScoreBound(int numPins, int index, PinMap* pinTimers[]) {
+  int bound = 0;
+  for (int i=0; i<=index; i++) {
+    bool found = false;
+    for (int j=i+1; j<=index; j++) {
+      if (pinTimers[i]->peripheral == pinTimers[j]->peripheral)
+        found = true;
+    }
+    if (!found) bound++;
+  }
+  if (numPins == 6 && index >= 1 && !STM_PIN_INVERTED(pinTimers[1]->function))
+    bound += 10;
+  return bound;
+}
+
+// 查找第一个PinMap条目的索引
+int findIndexOfFirstPinMapEntry(int pin) {
+  PinName pinName = digitalPinToPinName(pin);
+  int i = 0;
+  while (PinMap_TIM[i].pin!=NC) {
+    if (pinName == PinMap_TIM[i].pin)
+      return i;
+    i++;
+  }
+  return -1;
+}
+
+// 查找最后一个PinMap条目的索引
+int findIndexOfLastPinMapEntry(int pin) {
+  PinName pinName = digitalPinToPinName(pin);
+  int i = 0;
+  while (PinMap_TIM[i].pin!=NC) {
+    if (   pinName == (PinMap_TIM[i].pin & ~ALTX_MASK) 
+        && pinName != (PinMap_TIM[i+1].pin & ~ALTX_MASK))
+      return i;
+    i++;
+  }
+  return -1;
+}
+
+#define NOT_FOUND 1000
+// 最低可能的分数 - 1个定时器
+#define BEST_POSSIBLE_SCORE 1
+
+/*
+  分支定界搜索
+  按引脚顺序逐个选择 PinMap 条目，无效的部分组合和下界不小于当前最佳分数的分支被剪掉
+  只剪掉 scoreCombination() 会拒绝或分数不可能更低的分支，因此返回枚举顺序中第一个分数最低的组合
+*/
+void _searchTimerCombination(int numPins, int index, int startIndex[], int endIndex[], PinMap* searchArray[], PinMap* pinTimers[], int* bestScore) {
+  for (int i=startIndex[index]; i<=endIndex[index]; i++) {
+    // 已经找到最低可能的分数 - 后面的组合不会更好
+    if (*bestScore <= BEST_POSSIBLE_SCORE)
+      return;
+    searchArray[index] = (PinMap*)&PinMap_TIM[i];
+    if (!_isValidPartialCombination(numPins, index, searchArray))
+      continue;
+    if (_partialScoreBound(numPins, index, searchArray) >= *bestScore)
+      continue;
+    if (index < numPins-1) {
+      _searchTimerCombination(numPins, index+1, startIndex, endIndex, searchArray, pinTimers, bestScore);
+      continue;
+    }
+    int score = scoreCombination(numPins, searchArray);
+    #ifdef SIMPLEFOC_STM32_DEBUG_SEARCH
+    printTimerCombination(numPins, searchArray, score);
+    #endif
+    if (score>=0 && score<*bestScore) {
+      *bestScore = score;
+      for (int j=0;j<numPins;j++)
+        pinTimers[j] = searchArray[j];
+    }
+  }
+}
+
+// PinMap_TIM 表的条目数（不含结尾的 NC 条目）
+int _pinMapTIMLength() {
+  int n = 0;
+  while (PinMap_TIM[n].pin!=NC)
+    n++;
+  return n;
+}
+
+// 在预先计算的表中查找组合
+int findTimerCombinationInTable(int numPins, int pins[], PinMap* pinTimers[]) {
+  if (numTimerCombinations <= 0)
+    return -1;
+  int pinMapLength = _pinMapTIMLength();
+  for (int k=0; k<numTimerCombinations; k++) {
+    const STM32TimerCombination* entry = &timerCombinations[k];
+    if (entry->num_pins != numPins)
+      continue;
+    bool match = true;
+    for (int i=0; i<numPins && match; i++)
+      match = (entry->pins[i] == pins[i]);
+    if (!match)
+      continue;
+    // 检查索引是否在 PinMap_TIM 表内并且仍然指向这些引脚 - 表可能来自其他的开发板或核心版本
+    PinMap* timers[6];
+    for (int i=0; i<numPins; i++) {
+      PinName pinName = digitalPinToPinName(pins[i]);
+      int index = entry->pinmap_index[i];
+      if (index < 0 || index >= pinMapLength || (PinMap_TIM[index].pin & ~ALTX_MASK) != pinName)
+        return -1;
+      timers[i] = (PinMap*)&PinMap_TIM[index];
+    }
+    int score = scoreCombination(numPins, timers);
+    if (score >= 0) {
+      for (int i=0; i<numPins; i++)
+        pinTimers[i] = timers[i];
+    }
+    return score;
+  }
+  return -1;
+}
+
+// 查找最佳定时器组合
+int findBestTimerCombination(int numPins, int pins[], PinMap* pinTimers[]) {
+  // 预先计算的组合
+  int bestScore = findTimerCombinationInTable(numPins, pins, pinTimers);
+  if (bestScore >= 0) {
+    #ifdef SIMPLEFOC_STM32_DEBUG
+    SimpleFOCDebug::print("STM32-DRV: 表中: ");
+    printTimerCombination(numPins, pinTimers, bestScore);
+    #endif
+    return bestScore;
+  }
+  if (numTimerCombinations > 0)
+    SIMPLEFOC_DEBUG("STM32-DRV: WARN: 表中没有有效的组合，搜索");
+
+  // 每个引脚的PinMap条目范围只查找一次
+  int startIndex[6], endIndex[6];
+  for (int i=0; i<numPins; i++) {
+    startIndex[i] = findIndexOfFirstPinMapEntry(pins[i]);
+    endIndex[i] = findIndexOfLastPinMapEntry(pins[i]);
+    if (startIndex[i] == -1 || endIndex[i] == -1) {
+      SIMPLEFOC_DEBUG("STM32-DRV: ERR: 引脚上没有定时器 ", pins[i]);
+      return -1; // 引脚未连接到任何定时器
+    }
+  }
+  PinMap* searchArray[6];
+  bestScore = NOT_FOUND;
+  _searchTimerCombination(numPins, 0, startIndex, endIndex, searchArray, pinTimers, &bestScore);
+
+  if (bestScore == NOT_FOUND) {
+    #ifdef SIMPLEFOC_STM32_DEBUG
+    SimpleFOCDebug::println("STM32-DRV: 在这些引脚上未找到可行组合");
+    #endif
+    return -10; // 未找到可行组合
+  }
+  #ifdef SIMPLEFOC_STM32_DEBUG
+  SimpleFOCDebug::print("STM32-DRV: 最佳: ");
+  printTimerCombination(numPins, pinTimers, bestScore);
+  // 表条目 - 可以复制到 _stm32SetTimerCombinations() 的表中
+  SimpleFOCDebug::print("STM32-DRV: 表: { ");
+  SimpleFOCDebug::print(numPins);
+  SimpleFOCDebug::print(", { ");
+  for (int i=0; i<numPins; i++) {
+    SimpleFOCDebug::print(pins[i]);
+    SimpleFOCDebug::print(i<numPins-1 ? ", " : " }, { ");
+  }
+  for (int i=0; i<numPins; i++) {
+    SimpleFOCDebug::print((int)(pinTimers[i] - (PinMap*)PinMap_TIM));
+    SimpleFOCDebug::print(i<numPins-1 ? ", " : " } },");
+  }
+  SimpleFOCDebug::println();
+  #endif
+  return bestScore;
+}
+
+#ifdef SIMPLEFOC_STM32_DEBUG
+void printTimerCombination(int numPins, PinMap* timers[], int score) {
+  for (int i=0; i<numPins; i++) {
+    if (timers[i] == NP)
+      SimpleFOCDebug::print("NP");
+    else {
+      SimpleFOCDebug::print("TIM");
+      SimpleFOCDebug::print(getTimerNumber(get_timer_index((TIM_TypeDef*)timers[i]->peripheral)));
+      SimpleFOCDebug::print("-CH");
+      SimpleFOCDebug::print(STM_PIN_CHANNEL(timers[i]->function));
+      if (STM_PIN_INVERTED(timers[i]->function))
+        SimpleFOCDebug::print("N");
+    }
+    SimpleFOCDebug::print(" ");
+  }
+ SimpleFOCDebug::println("score: ", score);
+}
+#endif
+
+#endif
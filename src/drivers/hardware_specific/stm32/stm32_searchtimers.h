@@ -0,0 +1,53 @@
+#ifndef STM32_SEARCHTIMERS_H
+#define STM32_SEARCHTIMERS_H
+
+#include "../../hardware_api.h"
+
+#if defined(_STM32_DEF_)
+
+#ifndef SIMPLEFOC_STM32_MAX_PINTIMERSUSED
+#define SIMPLEFOC_STM32_MAX_PINTIMERSUSED 12
+#endif
+
+// 已被驱动使用的定时器通道
+extern int numTimerPinsUsed;
+extern PinMap* timerPinsUsed[SIMPLEFOC_STM32_MAX_PINTIMERSUSED];
+
+/**
+ * 预先计算的定时器组合 - 引脚和对应的 PinMap_TIM 表索引
+ * 调试输出的 "STM32-DRV: 表: ..." 行可以直接复制到程序中
+ */
+typedef struct STM32TimerCombination {
+  int num_pins; // 引脚数量
+  int pins[6]; // 引脚
+  int pinmap_index[6]; // PinMap_TIM 表的索引
+} STM32TimerCombination;
+
+/**
+ * 设置预先计算的定时器组合表 - 在 driver.init() 之前调用
+ * 匹配的引脚组合不再搜索，初始化时间为 O(引脚数)
+ * 表的索引只对生成它的开发板和 STM32 核心版本有效 - 无效的条目会回退到搜索
+ *
+ * @param table - 组合表（必须保持有效，例如 const 全局数组）
+ * @param count - 表的条目数
+ */
+void _stm32SetTimerCombinations(const STM32TimerCombination* table, int count);
+
+/**
+ * 定时器组合评分
+ * @return <0 组合无效，>=0 组合有效，分数越低越好
+ */
+int scoreCombination(int numPins, PinMap* pinTimers[]);
+
+/**
+ * 查找引脚的最佳定时器组合 - 先查预先计算的表，然后剪枝搜索
+ * @return 最佳分数，<0 表示未找到可行组合
+ */
+int findBestTimerCombination(int numPins, int pins[], PinMap* pinTimers[]);
+
+// 调试输出
+void printTimerCombination(int numPins, PinMap* timers[], int score);
+int getTimerNumber(int timerIndex);
+
+#endif
+#endif
@@ -0,0 +1,128 @@
+#include "FluxObserverSensor.h"
+#include "../communication/SimpleFOCDebug.h"
+
+// angle difference wrapped to [-PI, PI]
+static inline float _wrapAngle(float a) {
+  return _normalizeAngle(a + _PI) - _PI;
+}
+
+FluxObserverSensor::FluxObserverSensor(FOCMotor& _motor) : motor(_motor) {
+}
+
+void FluxObserverSensor::init() {
+  if (!motor.current_sense) SIMPLEFOC_ERROR("OBS: No current sense!");
+  if (!_isset(motor.phase_resistance) || !_isset(motor.phase_inductance))
+    SIMPLEFOC_WARN("OBS: Phase resistance/inductance not set!");
+  // same as the back-emf estimation in BLDCMotor: V = velocity / (KV * sqrt(3)) / (rpm->rad/s)
+  if (_isset(flux_linkage)) flux = flux_linkage;
+  else if (_isset(motor.KV_rating) && motor.KV_rating > 0) flux = 1.0f / (motor.KV_rating * _SQRT3 * _RPM_TO_RADS * motor.pole_pairs);
+  else {
+    flux = 0;
+    SIMPLEFOC_WARN("OBS: KV rating not set!");
+  }
+  // the observer angle is the electrical angle
+  motor.sensor_direction = Direction::CW;
+  motor.zero_electric_angle = 0;
+  reset();
+  Sensor::init();
+}
+
+void FluxObserverSensor::reset() {
+  closed_loop = false;
+  flux_alpha = flux;
+  flux_beta = 0;
+  forced_velocity = 0;
+  forced_angle = electrical_angle;
+  pll_angle = electrical_angle;
+  pll_velocity = 0;
+  handover_remaining = 0;
+  timestamp_prev = _micros();
+}
+
+void FluxObserverSensor::update() {
+  unsigned long now_us = _micros();
+  float Ts = (now_us - timestamp_prev) * 1e-6f;
+  // quick fix for strange cases (micros overflow + timestamp not defined)
+  if (Ts <= 0 || Ts > 0.5f) Ts = 1e-3f;
+  timestamp_prev = now_us;
+
+  // the motor is disabled - start again
+  if (!motor.enabled || !motor.current_sense) {
+    if (closed_loop || forced_velocity != 0) reset();
+    Sensor::update();
+    return;
+  }
+
+  // flux observer
+  ABCurrent_s i = motor.current_sense->getABCurrents(motor.current_sense->getPhaseCurrents());
+  float R = _isset(motor.phase_resistance) ? motor.phase_resistance : 0;
+  float L = _isset(motor.phase_inductance) ? motor.phase_inductance : 0;
+  flux_alpha += (motor.Ualpha - R * i.alpha) * Ts - L * (i.alpha - i_alpha_prev);
+  flux_beta += (motor.Ubeta - R * i.beta) * Ts - L * (i.beta - i_beta_prev);
+  i_alpha_prev = i.alpha;
+  i_beta_prev = i.beta;
+  // magnitude correction - keeps the integrators from drifting
+  if (flux > 0) {
+    float k = observer_gain * Ts;
+    if (k > 0.5f) k = 0.5f;
+    float e = k * (1.0f - (flux_alpha * flux_alpha + flux_beta * flux_beta) / (flux * flux));
+    flux_alpha += e * flux_alpha;
+    flux_beta += e * flux_beta;
+  }
+
+  // PLL on the flux angle - critically damped
+  float error = _wrapAngle(_atan2(flux_beta, flux_alpha) - pll_angle);
+  pll_velocity += pll_bandwidth * pll_bandwidth * error * Ts;
+  pll_angle = _normalizeAngle(pll_angle + (pll_velocity + 2.0f * pll_bandwidth * error) * Ts);
+
+  float handover_el = handover_velocity * motor.pole_pairs;
+  float angle;
+  if (!closed_loop) {
+    // forced start-up ramp
+    if (fabs(forced_velocity) < handover_el) forced_velocity += startup_direction * startup_acceleration * motor.pole_pairs * Ts;
+    forced_angle = _normalizeAngle(forced_angle + forced_velocity * Ts);
+    angle = forced_angle;
+    velocity = forced_velocity / motor.pole_pairs;
+    // handover once the observer follows the ramp
+    if (fabs(forced_velocity) >= handover_el && fabs(pll_velocity - forced_velocity) < velocity_tolerance * fabs(forced_velocity)) {
+      closed_loop = true;
+      handover_error = _wrapAngle(forced_angle - pll_angle);
+      handover_remaining = handover_time;
+    }
+  } else {
+    // blend the angle difference of the handover out
+    angle = pll_angle;
+    if (handover_remaining > 0 && handover_time > 0) {
+      angle = _normalizeAngle(pll_angle + handover_error * handover_remaining / handover_time);
+      handover_remaining -= Ts;
+    }
+    velocity = pll_velocity / motor.pole_pairs;
+    // too slow for the observer - back to the forced ramp
+    if (fabs(pll_velocity) < 0.5f * handover_el) {
+      closed_loop = false;
+      forced_angle = angle;
+      forced_velocity = pll_velocity;
+    }
+  }
+
+  // accumulate the mechanical angle
+  mechanical_angle = _normalizeAngle(mechanical_angle + _wrapAngle(angle - electrical_angle) / motor.pole_pairs);
+  electrical_angle = angle;
+  Sensor::update();
+}
+
+float FluxObserverSensor::getSensorAngle() {
+  return mechanical_angle;
+}
+
+float FluxObserverSensor::getVelocity() {
+  return velocity;
+}
+
+float FluxObserverSensor::getObserverAngle() {
+  return pll_angle;
+}
+
+float FluxObserverSensor::getObserverVelocity() {
+  return pll_velocity;
+}
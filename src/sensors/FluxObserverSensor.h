@@ -0,0 +1,88 @@
+#ifndef FLUX_OBSERVER_SENSOR_H
+#define FLUX_OBSERVER_SENSOR_H
+
+#include "Arduino.h"
+#include "../common/foc_utils.h"
+#include "../common/time_utils.h"
+#include "../common/base_classes/Sensor.h"
+#include "../common/base_classes/FOCMotor.h"
+#include "../common/base_classes/CurrentSense.h"
+
+/**
+ * Sensorless angle estimation - nonlinear flux observer with a PLL
+ *
+ *  - the rotor flux is integrated from the commanded motor.Ualpha/Ubeta and the measured
+ *    CurrentSense::getABCurrents(): flux = integral(U - R*I) - L*I
+ *  - the flux magnitude is pulled towards flux_linkage (Ortega et al.) which removes the integrator drift
+ *  - a PLL tracks the flux angle and gives a smooth angle and velocity
+ *  - below handover_velocity the sensor outputs a forced angle ramp (I/f start-up): with the current
+ *    (or voltage) torque control the rotor follows the rotating current vector. Once the observer velocity
+ *    matches the ramp the output is blended to the observed angle in handover_time
+ *
+ * The motor parameters (phase_resistance, phase_inductance, KV_rating, pole_pairs) and the current sense
+ * are taken from the motor. init() sets motor.sensor_direction and motor.zero_electric_angle as the observer
+ * angle is already the electrical angle - no sensor alignment is needed.
+ *
+ * Example:
+ *    FluxObserverSensor observer(motor);
+ *    motor.linkCurrentSense(&current_sense);
+ *    ...
+ *    motor.init();
+ *    observer.init();
+ *    motor.linkSensor(&observer);
+ *    motor.initFOC();
+ */
+class FluxObserverSensor : public Sensor
+{
+  public:
+    /**
+     * @param motor - motor providing the parameters, the current sense and the commanded voltages
+     */
+    FluxObserverSensor(FOCMotor& motor);
+
+    void init() override;
+    /** run the observer - called by motor.loopFOC() */
+    void update() override;
+    /** estimated mechanical velocity [rad/s] */
+    float getVelocity() override;
+    /** observer (PLL) electrical angle [rad] - valid above the handover velocity */
+    float getObserverAngle();
+    /** observer (PLL) electrical velocity [rad/s] */
+    float getObserverVelocity();
+
+    float flux_linkage = NOT_SET; //!< rotor flux linkage [V*s/rad] - NOT_SET: calculated from motor.KV_rating
+    float observer_gain = 1000.0f; //!< flux magnitude correction gain [1/s]
+    float pll_bandwidth = 300.0f; //!< PLL bandwidth [rad/s]
+
+    float startup_acceleration = 50.0f; //!< forced start-up acceleration [rad/s^2]
+    float handover_velocity = 20.0f; //!< velocity of the handover to the observer [rad/s]
+    float handover_time = 0.05f; //!< blending time of the forced and the observed angle [s]
+    float velocity_tolerance = 0.3f; //!< relative velocity difference accepted for the handover
+    int8_t startup_direction = 1; //!< start-up direction (1 or -1)
+
+    bool closed_loop = false; //!< true if the angle comes from the observer
+    float flux_alpha = 0; //!< estimated rotor flux alpha [V*s]
+    float flux_beta = 0; //!< estimated rotor flux beta [V*s]
+    float electrical_angle = 0; //!< estimated (or forced) electrical angle [rad]
+
+  protected:
+    float getSensorAngle() override;
+
+    FOCMotor& motor; //!< motor with the parameters
+    float flux = 0; //!< flux linkage used by the observer [V*s/rad]
+    float i_alpha_prev = 0; //!< previous alpha current [A]
+    float i_beta_prev = 0; //!< previous beta current [A]
+    float pll_angle = 0; //!< PLL electrical angle [rad]
+    float pll_velocity = 0; //!< PLL electrical velocity [rad/s]
+    float forced_angle = 0; //!< start-up electrical angle [rad]
+    float forced_velocity = 0; //!< start-up electrical velocity [rad/s]
+    float handover_error = 0; //!< angle difference at the handover [rad]
+    float handover_remaining = 0; //!< remaining blending time [s]
+    float mechanical_angle = 0; //!< accumulated mechanical angle [0, 2PI]
+    unsigned long timestamp_prev = 0; //!< last update timestamp
+
+    /** reset to the forced start-up */
+    void reset();
+};
+
+#endif
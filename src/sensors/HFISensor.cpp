@@ -0,0 +1,145 @@
+#include "HFISensor.h"
+#include "../communication/SimpleFOCDebug.h"
+
+// angle difference wrapped to [-PI, PI]
+static inline float _wrapAngle(float a) {
+  return _normalizeAngle(a + _PI) - _PI;
+}
+
+HFISensor::HFISensor(BLDCMotor& _motor) : motor(_motor) {
+}
+
+void HFISensor::linkObserver(FluxObserverSensor* _observer) {
+  observer = _observer;
+}
+
+void HFISensor::init() {
+  if (!motor.current_sense) SIMPLEFOC_ERROR("HFI: No current sense!");
+  if (motor.foc_modulation != FOCModulationType::SinePWM && motor.foc_modulation != FOCModulationType::SpaceVectorPWM)
+    SIMPLEFOC_WARN("HFI: Sine or SVPWM modulation needed!");
+  if (observer) observer->init();
+  // the estimated angle is the electrical angle
+  motor.sensor_direction = Direction::CW;
+  motor.zero_electric_angle = 0;
+  reset();
+  Sensor::init();
+}
+
+void HFISensor::reset() {
+  state = HFI_ALIGN;
+  state_time = 0;
+  pll_velocity = 0;
+  velocity_el = 0;
+  injection_sign = 0;
+  motor.injection_voltage_d = 0;
+  timestamp_prev = _micros();
+}
+
+// +pulse, -pulse, -pulse, +pulse: the current returns to zero and the peaks
+// of both polarities are measured one cycle after the pulse end (the voltage is applied in the next period)
+float HFISensor::polarity(float i_d) {
+  if (polarity_cnt == polarity_cycles) polarity_current_pos = i_d;
+  else if (polarity_cnt == 3 * polarity_cycles) polarity_current_neg = i_d;
+  else if (polarity_cnt >= 4 * polarity_cycles) {
+    // the larger current is in the magnet direction
+    if (-polarity_current_neg > polarity_current_pos) pll_angle = _normalizeAngle(pll_angle + _PI);
+    SIMPLEFOC_DEBUG("HFI: Polarity: ", polarity_current_pos + polarity_current_neg);
+    state = HFI_RUNNING;
+    state_time = 0;
+    return 0;
+  }
+  polarity_cnt++;
+  return (polarity_cnt <= polarity_cycles || polarity_cnt > 3 * polarity_cycles) ? polarity_voltage : -polarity_voltage;
+}
+
+void HFISensor::update() {
+  float Ts = sample_time;
+  unsigned long now_us = _micros();
+  if (!_isset(Ts)) {
+    Ts = (now_us - timestamp_prev) * 1e-6f;
+    // quick fix for strange cases (micros overflow + timestamp not defined)
+    if (Ts <= 0 || Ts > 0.5f) Ts = 1e-3f;
+  }
+  timestamp_prev = now_us;
+
+  // the motor is disabled - start again
+  if (!motor.enabled || !motor.current_sense) {
+    if (state != HFI_ALIGN || injection_sign != 0) reset();
+    Sensor::update();
+    return;
+  }
+
+  ABCurrent_s i = motor.current_sense->getABCurrents(motor.current_sense->getPhaseCurrents());
+  // current change in the frame of the last injection
+  float _sa, _ca;
+  _sincos(injection_angle, &_sa, &_ca);
+  float di_a = i.alpha - i_alpha_prev;
+  float di_b = i.beta - i_beta_prev;
+  float di_d = _ca * di_a + _sa * di_b;
+  float di_q = -_sa * di_a + _ca * di_b;
+  i_alpha_prev = i.alpha;
+  i_beta_prev = i.beta;
+  state_time += Ts;
+
+  // observer blending factor
+  float blend = 0;
+  if (observer) {
+    observer->update();
+    if (state == HFI_RUNNING && blend_velocity_high > blend_velocity_low)
+      blend = _constrain((fabs(velocity_el) / motor.pole_pairs - blend_velocity_low) / (blend_velocity_high - blend_velocity_low), 0, 1);
+  }
+
+  float u_d = 0;
+  if (state == HFI_POLARITY) {
+    // d current of the pulses
+    u_d = polarity(_ca * i.alpha + _sa * i.beta);
+  } else if (blend < 1.0f) {
+    // demodulation: iq = Vh*T*(1/Ld - 1/Lq)/2 * sin(2*error), id = Vh*T*(1/Ld + 1/Lq)/2 - normalized to the angle error
+    if (injection_sign != 0 && fabs(di_d) > 1e-6f) {
+      float r = saliency > 1.0f ? (saliency - 1.0f) / (saliency + 1.0f) : 1.0f;
+      angle_error = _constrain(di_q / di_d / (2.0f * r), -1.0f, 1.0f);
+      // PLL - critically damped
+      pll_velocity += pll_bandwidth * pll_bandwidth * angle_error * Ts;
+      pll_angle = _normalizeAngle(pll_angle + (pll_velocity + 2.0f * pll_bandwidth * angle_error) * Ts);
+    }
+    injection_sign = injection_sign > 0 ? -1.0f : 1.0f;
+    u_d = injection_sign * injection_voltage;
+    // converged - polarity detection
+    if (state == HFI_ALIGN && state_time > align_time) {
+      state = HFI_POLARITY;
+      polarity_cnt = 0;
+      injection_sign = 0;
+      u_d = polarity(0);
+    }
+  } else {
+    injection_sign = 0;
+  }
+
+  float angle = pll_angle;
+  velocity_el = pll_velocity;
+  if (blend > 0) {
+    angle = _normalizeAngle(pll_angle + blend * _wrapAngle(observer->getObserverAngle() - pll_angle));
+    velocity_el = pll_velocity + blend * (observer->getObserverVelocity() - pll_velocity);
+    // no injection - the HFI PLL follows the output
+    if (blend >= 1.0f) {
+      pll_angle = angle;
+      pll_velocity = velocity_el;
+    }
+  }
+  motor.injection_voltage_d = u_d;
+  injection_angle = angle;
+
+  // accumulate the mechanical angle
+  mechanical_angle = _normalizeAngle(mechanical_angle + _wrapAngle(angle - electrical_angle) / motor.pole_pairs);
+  electrical_angle = angle;
+  velocity = velocity_el / motor.pole_pairs;
+  Sensor::update();
+}
+
+float HFISensor::getSensorAngle() {
+  return mechanical_angle;
+}
+
+float HFISensor::getVelocity() {
+  return velocity;
+}
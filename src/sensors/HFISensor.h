@@ -0,0 +1,108 @@
+#ifndef HFI_SENSOR_H
+#define HFI_SENSOR_H
+
+#include "Arduino.h"
+#include "../common/foc_utils.h"
+#include "../common/time_utils.h"
+#include "../common/base_classes/Sensor.h"
+#include "../common/base_classes/CurrentSense.h"
+#include "../BLDCMotor.h"
+#include "FluxObserverSensor.h"
+
+/**
+ *  HFI sensor state
+ */
+enum HFIState : uint8_t {
+  HFI_ALIGN     = 0x00, //!< injection running - waiting for the PLL to converge
+  HFI_POLARITY  = 0x01, //!< magnet polarity detection
+  HFI_RUNNING   = 0x02  //!< angle tracking
+};
+
+/**
+ * Sensorless angle estimation at standstill and low speed - high frequency injection (HFI)
+ *
+ *  - a square wave voltage of +-injection_voltage is added to the d axis every loopFOC() call
+ *    (motor.injection_voltage_d, added in BLDCMotor::setPhaseVoltage)
+ *  - the current change between two samples is demodulated with the sign of the injection:
+ *    on a salient motor (Lq > Ld) the q axis response is proportional to sin(2 * angle error)
+ *  - a PLL tracks the angle - the HF response only gives the angle modulo PI so after
+ *    align_time the magnet polarity is detected with +/- d axis voltage pulses (saturation
+ *    makes the current rise faster when the d current strengthens the magnet)
+ *  - with a linked FluxObserverSensor the angle is blended to the observer angle between
+ *    blend_velocity_low and blend_velocity_high - above it the injection is switched off
+ *
+ * The demodulation assumes one loopFOC() call per PWM period (or a fixed number of periods):
+ * run loopFOC() from the PWM/ADC interrupt (InlineCurrentSense::pwm_sync or low-side sensing)
+ * and set sample_time to the loop period. Only SinePWM and SpaceVectorPWM modulation inject.
+ * The injected ripple is seen by the current loop as well - use the current LPF of the motor.
+ *
+ * Example:
+ *    HFISensor hfi(motor);
+ *    FluxObserverSensor observer(motor);
+ *    motor.linkCurrentSense(&current_sense);
+ *    ...
+ *    motor.init();
+ *    hfi.linkObserver(&observer);
+ *    hfi.init();
+ *    motor.linkSensor(&hfi);
+ *    motor.initFOC();
+ */
+class HFISensor : public Sensor
+{
+  public:
+    /**
+     * @param motor - motor providing the current sense, the pole pairs and the voltage injection
+     */
+    HFISensor(BLDCMotor& motor);
+
+    /** link the back-emf observer used above blend_velocity_low */
+    void linkObserver(FluxObserverSensor* observer);
+
+    void init() override;
+    /** run the injection and the demodulation - called by motor.loopFOC() */
+    void update() override;
+    /** estimated mechanical velocity [rad/s] */
+    float getVelocity() override;
+
+    float injection_voltage = 1.0f; //!< HF square wave amplitude [V]
+    float saliency = 1.5f; //!< Lq/Ld estimate - normalizes the angle error
+    float pll_bandwidth = 100.0f; //!< PLL bandwidth [rad/s]
+    float sample_time = NOT_SET; //!< fixed loop period [s] - NOT_SET: measured with _micros()
+
+    float align_time = 0.2f; //!< PLL convergence time before the polarity detection [s]
+    float polarity_voltage = 3.0f; //!< polarity detection pulse voltage [V]
+    uint16_t polarity_cycles = 10; //!< polarity detection pulse length [loop cycles]
+
+    float blend_velocity_low = 10.0f; //!< observer blending start [rad/s]
+    float blend_velocity_high = 20.0f; //!< observer only - injection off [rad/s]
+
+    HFIState state = HFI_ALIGN; //!< current state
+    float electrical_angle = 0; //!< estimated electrical angle [rad]
+    float angle_error = 0; //!< demodulated angle error [rad]
+    float polarity_current_pos = 0; //!< peak d current of the positive polarity pulse [A]
+    float polarity_current_neg = 0; //!< peak d current of the negative polarity pulse [A]
+
+  protected:
+    float getSensorAngle() override;
+
+    BLDCMotor& motor; //!< motor with the voltage injection
+    FluxObserverSensor* observer = nullptr; //!< back-emf observer
+    float pll_angle = 0; //!< HFI PLL electrical angle [rad]
+    float pll_velocity = 0; //!< HFI PLL electrical velocity [rad/s]
+    float velocity_el = 0; //!< output electrical velocity [rad/s]
+    float i_alpha_prev = 0; //!< previous alpha current [A]
+    float i_beta_prev = 0; //!< previous beta current [A]
+    float injection_angle = 0; //!< electrical angle of the last injection [rad]
+    float injection_sign = 0; //!< sign of the last injection
+    float state_time = 0; //!< time in the current state [s]
+    uint16_t polarity_cnt = 0; //!< polarity detection cycle counter
+    float mechanical_angle = 0; //!< accumulated mechanical angle [0, 2PI]
+    unsigned long timestamp_prev = 0; //!< last update timestamp
+
+    /** back to the alignment */
+    void reset();
+    /** polarity detection step - returns the d voltage of the next cycle */
+    float polarity(float i_d);
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include "HallSensor.h"
+#include "../communication/SimpleFOCDebug.h"
 
 
 /*
@@ -107,12 +108,97 @@ void HallSensor::update() {
   angle_prev_ts = pulse_timestamp;
   long last_electric_rotations = electric_rotations;
   int8_t last_electric_sector = electric_sector;
+  Direction last_direction = direction;
+  long last_pulse_diff = pulse_diff;
+  unsigned long last_pulse_timestamp = pulse_timestamp;
+  long last_interrupts = total_interrupts;
   if (use_interrupt) interrupts();
-  angle_prev = ((float)((last_electric_rotations * 6 + last_electric_sector) % cpr) / (float)cpr) * _2PI ;
+
+  if (calibration_samples > 0) calibrateSectors(last_electric_sector, last_direction, last_pulse_diff, last_interrupts);
+  last_total_interrupts = last_interrupts;
+
+  // the interpolated angle is valid now, not at the last edge
+  float offset = sectorOffset(last_electric_sector, last_direction, last_pulse_diff, last_pulse_timestamp);
+  if (interpolate) angle_prev_ts = _micros();
+  angle_prev = (((float)((last_electric_rotations * 6 + last_electric_sector) % cpr) + offset) / (float)cpr) * _2PI ;
   full_rotations = (int32_t)((last_electric_rotations * 6 + last_electric_sector) / cpr);
 }
 
 
+/*
+  Position inside the sector relative to its nominal start, in sectors
+  - without interpolation 0 - the angle of the last edge
+  - with interpolation the sector is entered at its start (CW) or at its end (CCW) and the motor is assumed
+    to turn at the velocity measured over the previous sector, but never past the sector boundary
+*/
+float HallSensor::sectorOffset(int8_t sector, Direction dir, long diff, unsigned long timestamp) {
+  if (!interpolate || sector < 0) return 0;
+  float travelled = 0;
+  if (diff > 0) {
+    // the last period was measured over the previous sector
+    int8_t prev = (dir == Direction::CW) ? (sector + 5) % 6 : (sector + 1) % 6;
+    travelled = sector_width[prev] * (float)(_micros() - timestamp) / (float)diff;
+    if (travelled > sector_width[sector]) travelled = sector_width[sector];
+  }
+  float offset = sector_start[sector] - sector;
+  return (dir == Direction::CW) ? offset + travelled : offset + sector_width[sector] - travelled;
+}
+
+
+/*
+  Sector timing calibration
+  At a constant velocity the period of each sector is proportional to its width.
+  Each new edge gives the period of the sector it left, the periods after a direction change are not valid (diff = 0).
+*/
+void HallSensor::startSectorCalibration(int samples) {
+  for (int i = 0; i < 6; i++) {
+    sector_time[i] = 0;
+    sector_count[i] = 0;
+  }
+  last_total_interrupts = total_interrupts;
+  calibration_samples = samples > 0 ? samples : 1;
+}
+
+bool HallSensor::calibratingSectors() {
+  return calibration_samples > 0;
+}
+
+void HallSensor::calibrateSectors(int8_t sector, Direction dir, long diff, long interrupts_count) {
+  if (interrupts_count == last_total_interrupts || diff <= 0 || sector < 0) return;
+  int8_t prev = (dir == Direction::CW) ? (sector + 5) % 6 : (sector + 1) % 6;
+  if (sector_count[prev] < calibration_samples) {
+    sector_time[prev] += diff;
+    sector_count[prev]++;
+  }
+  for (int i = 0; i < 6; i++)
+    if (sector_count[i] < calibration_samples) return;
+
+  // all the sectors measured
+  float widths[6];
+  for (int i = 0; i < 6; i++) widths[i] = (float)sector_time[i] / sector_count[i];
+  setSectorWidths(widths);
+  calibration_samples = 0;
+  for (int i = 0; i < 6; i++) SIMPLEFOC_DEBUG("Hall: sector width: ", sector_width[i]);
+}
+
+void HallSensor::setSectorWidths(const float widths[6]) {
+  float sum = 0;
+  for (int i = 0; i < 6; i++) sum += widths[i];
+  if (sum <= 0) return;
+  // sectors are consecutive, starts are the cumulative widths
+  float start = 0, shift = 0;
+  for (int i = 0; i < 6; i++) {
+    sector_width[i] = 6.0f * widths[i] / sum;
+    sector_start[i] = start;
+    start += sector_width[i];
+    shift += sector_start[i] + sector_width[i] / 2 - (i + 0.5f);
+  }
+  // keep the mean sector centre at its nominal position so the zero_electric_angle stays valid
+  shift /= 6.0f;
+  for (int i = 0; i < 6; i++) sector_start[i] -= shift;
+}
+
+
 
 /*
 	Shaft angle calculation
@@ -130,9 +216,18 @@ float HallSensor::getVelocity(){
   noInterrupts();
   long last_pulse_timestamp = pulse_timestamp;
   long last_pulse_diff = pulse_diff;
+  int8_t last_electric_sector = electric_sector;
+  Direction last_direction = direction;
   interrupts();
-  if (last_pulse_diff == 0 || ((long)(_micros() - last_pulse_timestamp) > last_pulse_diff*2) ) { // last velocity isn't accurate if too old
+  long elapsed = (long)(_micros() - last_pulse_timestamp);
+  if (last_pulse_diff == 0 || (elapsed > last_pulse_diff*2) ) { // last velocity isn't accurate if too old
     return 0;
+  } else if (interpolate && last_electric_sector >= 0) {
+    // the last period was measured over the previous sector, its width is known from the calibration
+    int8_t prev = (last_direction == Direction::CW) ? (last_electric_sector + 5) % 6 : (last_electric_sector + 1) % 6;
+    // no edge for longer than the last period - the motor is slowing down
+    if (elapsed < last_pulse_diff) elapsed = last_pulse_diff;
+    return last_direction * sector_width[prev] * (_2PI / (float)cpr) / (elapsed / 1000000.0f);
   } else {
     return direction * (_2PI / (float)cpr) / (last_pulse_diff / 1000000.0f);
   }
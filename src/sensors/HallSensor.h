@@ -79,6 +79,28 @@ class HallSensor: public Sensor{
     // variable used to filter outliers - rad/s
     float velocity_max = 1000.0f;
 
+    /**
+     * Interpolate the angle between the hall edges - smooth FOC with the hall sensors
+     * The angle is extrapolated from the period of the previous sector and capped at the sector boundary,
+     * if the motor slows down the angle waits there for the next edge
+     */
+    bool interpolate = false;
+    float sector_width[6] = {1, 1, 1, 1, 1, 1}; //!< width of each electric sector in sectors (nominal 1.0, sum 6.0) - uneven hall placement
+
+    /**
+     * Set the sector widths - for example the values printed by a previous sector calibration
+     * @param widths - widths of the 6 electric sectors, normalised to the sum of 6
+     */
+    void setSectorWidths(const float widths[6]);
+    /**
+     * Start the sector timing calibration - non-blocking, measured in update()
+     * The motor has to turn at a constant velocity (ex. velocity_openloop) until it finishes
+     * @param samples - number of measured periods of each sector
+     */
+    void startSectorCalibration(int samples = 20);
+    /** True while the sector calibration is running */
+    bool calibratingSectors();
+
   private:
     
     Direction decodeDirection(int oldState, int newState);
@@ -93,6 +115,17 @@ class HallSensor: public Sensor{
     void (*onSectorChange)(int sector) = nullptr;
 
     volatile long pulse_diff;
+
+    float sector_start[6] = {0, 1, 2, 3, 4, 5}; //!< start of each electric sector in sectors
+    unsigned long sector_time[6]; //!< sector calibration - sum of the measured periods [us]
+    int sector_count[6]; //!< sector calibration - number of the measured periods
+    int calibration_samples = 0; //!< sector calibration - periods to measure per sector (0 - not running)
+    long last_total_interrupts = 0; //!< interrupt count at the last update()
+
+    /** position inside the sector relative to its nominal start (in sectors) - interpolated between the edges */
+    float sectorOffset(int8_t sector, Direction dir, long diff, unsigned long timestamp);
+    /** sector calibration step - called from update() */
+    void calibrateSectors(int8_t sector, Direction dir, long diff, long interrupts_count);
     
 };
 